@@ -1,22 +1,85 @@
 #include "PhonebookManager.h"
 #include "app_config.h"
 #include "AppSharedUtils.h"
+#include "StateVersion.h"
 #include "esp_log.h"
 #include "esp_heap_caps.h"
 #include "esp_system.h"
+#include "esp_timer.h"
+#include "esp_rom_crc.h"
 #include "cJSON.h"
 #include "nvs.h"
+#include <algorithm>
+#include <set>
+#include <vector>
 #include <dirent.h>
 #include <string.h>
 #include <strings.h>
 #include <stdio.h>
+#include <unistd.h>
 
 static const char *TAG = "APP_PHONEBOOK";
 
 PhonebookManager phonebook;
 
+// One immutable version of the phonebook once published. Entries are kept
+// sorted by number; all string_views point into `strings` of the same table.
+struct PhonebookManager::Table {
+    struct Record {
+        std::string_view number;
+        PhonebookEntry entry;
+    };
+    struct ActionSlot {
+        std::string key;
+        phonebook_action_t handler;
+    };
+    // Digit trie over all numbers, for early dispatch while dialing
+    struct TrieNode {
+        int16_t child[10];
+        bool terminal = false;
+    };
+
+    std::vector<Record> entries;
+    std::set<std::string, std::less<>> strings;
+    std::vector<ActionSlot> actions;
+    std::vector<TrieNode> trie;
+
+    std::vector<Record>::iterator position(std::string_view number) {
+        return std::lower_bound(entries.begin(), entries.end(), number,
+                                [](const Record &r, std::string_view n) { return r.number < n; });
+    }
+
+    const Record *lookup(std::string_view number) const {
+        auto it = std::lower_bound(entries.begin(), entries.end(), number,
+                                   [](const Record &r, std::string_view n) { return r.number < n; });
+        if (it == entries.end() || it->number != number) return nullptr;
+        return &*it;
+    }
+
+    std::string_view intern(std::string_view str) {
+        auto it = strings.find(str);
+        if (it == strings.end()) {
+            it = strings.emplace(str).first;
+        }
+        return *it;
+    }
+
+    void compile(PhonebookEntry &entry) const;
+    void upsert(std::string_view number, std::string_view name, std::string_view type, std::string_view value, std::string_view parameter);
+    void rebuildTrie();
+};
+
 PhonebookManager::PhonebookManager() {}
 
+PhonebookManager::~PhonebookManager() {
+    if (_write_lock) vSemaphoreDelete(_write_lock);
+}
+
+void PhonebookManager::setFiles(const char *path, const char *tmp_path) {
+    _filename = path;
+    _tmpFilename = tmp_path;
+}
+
 static bool is_wav_name(const char *name) {
     if (!name) return false;
     size_t len = strlen(name);
@@ -94,93 +157,440 @@ static std::string get_persona_title(int idx) {
     return extract_category_title(wav);
 }
 
+void PhonebookManager::writeLockTake() {
+    if (!_write_lock) {
+        SemaphoreHandle_t created = xSemaphoreCreateMutex();
+        portENTER_CRITICAL(&_table_mux);
+        if (!_write_lock) {
+            _write_lock = created;
+            created = NULL;
+        }
+        portEXIT_CRITICAL(&_table_mux);
+        if (created) vSemaphoreDelete(created);
+    }
+    xSemaphoreTake(_write_lock, portMAX_DELAY);
+}
+
+void PhonebookManager::writeLockGive() {
+    xSemaphoreGive(_write_lock);
+}
+
+std::shared_ptr<const PhonebookManager::Table> PhonebookManager::snapshot() const {
+    portENTER_CRITICAL(&_table_mux);
+    std::shared_ptr<const Table> table = _table;
+    portEXIT_CRITICAL(&_table_mux);
+    return table;
+}
+
+// Writable copy of the current table; the action table is always carried over.
+// Caller holds the write lock.
+std::shared_ptr<PhonebookManager::Table> PhonebookManager::cloneTable(bool with_entries) const {
+    std::shared_ptr<const Table> current = snapshot();
+    std::shared_ptr<Table> table = std::make_shared<Table>();
+    if (!current) return table;
+
+    table->actions = current->actions;
+    if (with_entries) {
+        table->entries.reserve(current->entries.size());
+        for (const Table::Record &rec : current->entries) {
+            const PhonebookEntry &e = rec.entry;
+            table->upsert(rec.number, e.name, e.type, e.value, e.parameter);
+        }
+    }
+    return table;
+}
+
+// Makes the table visible to lookups. Readers still holding the previous
+// version keep it alive; it is freed when the last of them lets go. The
+// /api/state version follows the served table, whether or not save() works.
+void PhonebookManager::publish(std::shared_ptr<Table> table) {
+    table->rebuildTrie();
+    std::shared_ptr<const Table> next = std::move(table);
+    portENTER_CRITICAL(&_table_mux);
+    _table.swap(next);
+    portEXIT_CRITICAL(&_table_mux);
+    state_version::bump(STATE_PHONEBOOK);
+}
+
 void PhonebookManager::begin() {
+    writeLockTake();
+    std::shared_ptr<Table> table = cloneTable(false);
+    load(*table);
+    bool changed = addDefaults(*table);
+    publish(table);
+    if (changed) {
+        save(*table);
+    }
+    writeLockGive();
+}
+
+// Adds missing default numbers and switches built-in names to the current
+// UI language. Persona titles are only scanned from SD for missing entries.
+bool PhonebookManager::addDefaults(Table &table) {
     bool lang_en = app_is_lang_en();
-    // Default Entries Logic (in-memory only)
-    auto ensure = [&](std::string num, std::string name, std::string type, std::string val, std::string param="") {
-        if (!hasEntry(num)) {
-            ESP_LOGI(TAG, "Adding default: %s", name.c_str());
-            _entries[num] = {name, type, val, param};
+    bool changed = false;
+
+    auto ensure = [&](std::string_view num, std::string_view name_en, std::string_view name_de, std::string_view type, std::string_view val, std::string_view param = "") {
+        std::string_view name = lang_en ? name_en : name_de;
+        const Table::Record *existing = table.lookup(num);
+        if (!existing) {
+            ESP_LOGI(TAG, "Adding default: %.*s", (int)name.size(), name.data());
+            table.upsert(num, name, type, val, param);
+            changed = true;
+        } else if (existing->entry.value == val && existing->entry.name == (lang_en ? name_de : name_en) && name_en != name_de) {
+            const PhonebookEntry &e = existing->entry;
+            table.upsert(num, name, e.type, e.value, e.parameter);
+            changed = true;
         }
     };
+    auto ensure_persona = [&](std::string_view num, int idx) {
+        if (table.lookup(num)) return;
+        std::string title = get_persona_title(idx);
+        if (title.empty()) title = "Persona " + std::to_string(idx);
+        ensure(num, title, title, "FUNCTION", "COMPLIMENT_CAT", std::to_string(idx));
+    };
 
-    std::string p1 = get_persona_title(1);
-    std::string p2 = get_persona_title(2);
-    std::string p3 = get_persona_title(3);
-    std::string p4 = get_persona_title(4);
-    std::string p5 = get_persona_title(5);
-
-    ensure(APP_PB_NUM_PERSONA_1, p1.empty() ? "Persona 1" : p1, "FUNCTION", "COMPLIMENT_CAT", "1");
-    ensure(APP_PB_NUM_PERSONA_2, p2.empty() ? "Persona 2" : p2, "FUNCTION", "COMPLIMENT_CAT", "2");
-    ensure(APP_PB_NUM_PERSONA_3, p3.empty() ? "Persona 3" : p3, "FUNCTION", "COMPLIMENT_CAT", "3");
-    ensure(APP_PB_NUM_PERSONA_4, p4.empty() ? "Persona 4" : p4, "FUNCTION", "COMPLIMENT_CAT", "4");
-    ensure(APP_PB_NUM_PERSONA_5, p5.empty() ? "Persona 5" : p5, "FUNCTION", "COMPLIMENT_CAT", "5");
-    ensure(APP_PB_NUM_TIMER_REMAINING, lang_en ? "Timer Remaining" : "Timer Restzeit", "FUNCTION", "ANNOUNCE_TIMER_REMAINING");
-    ensure(APP_PB_NUM_RANDOM_MIX, lang_en ? "Random Mix (Surprise)" : "Zufallsmix (Überraschung)", "FUNCTION", "COMPLIMENT_MIX", "0");
-    ensure(APP_PB_NUM_TIME, lang_en ? "Time Announcement" : "Zeitauskunft", "FUNCTION", "ANNOUNCE_TIME");
+    ensure_persona(APP_PB_NUM_PERSONA_1, 1);
+    ensure_persona(APP_PB_NUM_PERSONA_2, 2);
+    ensure_persona(APP_PB_NUM_PERSONA_3, 3);
+    ensure_persona(APP_PB_NUM_PERSONA_4, 4);
+    ensure_persona(APP_PB_NUM_PERSONA_5, 5);
+    ensure(APP_PB_NUM_TIMER_REMAINING, "Timer Remaining", "Timer Restzeit", "FUNCTION", "ANNOUNCE_TIMER_REMAINING");
+    ensure(APP_PB_NUM_RANDOM_MIX, "Random Mix (Surprise)", "Zufallsmix (Überraschung)", "FUNCTION", "COMPLIMENT_MIX", "0");
+    ensure(APP_PB_NUM_TIME, "Time Announcement", "Zeitauskunft", "FUNCTION", "ANNOUNCE_TIME");
     
     // Admin
-    ensure(APP_PB_NUM_VOICE_MENU, lang_en ? "Voice Admin Menu" : "Sprachmenü", "FUNCTION", "VOICE_MENU");
+    ensure(APP_PB_NUM_VOICE_MENU, "Voice Admin Menu", "Sprachmenü", "FUNCTION", "VOICE_MENU");
+
+    return changed;
+}
+
+// phonebook.bin: header, then per entry five u16 length-prefixed strings
+// (number, name, type, value, parameter), then CRC32 over all preceding bytes.
+static const uint32_t PB_FILE_MAGIC = 0x4B425044; // "DPBK"
+static const uint16_t PB_FILE_VERSION = 1;
+
+struct PbFileHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t count;
+};
+
+static void pb_put_string(std::vector<uint8_t> &out, std::string_view str) {
+    uint16_t len = (uint16_t)std::min<size_t>(str.size(), UINT16_MAX);
+    const uint8_t *len_bytes = (const uint8_t *)&len;
+    out.insert(out.end(), len_bytes, len_bytes + sizeof(len));
+    out.insert(out.end(), str.begin(), str.begin() + len);
+}
+
+static bool pb_get_string(const uint8_t *buf, size_t len, size_t &pos, std::string_view &out) {
+    uint16_t str_len;
+    if (pos + sizeof(str_len) > len) return false;
+    memcpy(&str_len, buf + pos, sizeof(str_len));
+    pos += sizeof(str_len);
+    if (pos + str_len > len) return false;
+    out = std::string_view((const char *)buf + pos, str_len);
+    pos += str_len;
+    return true;
+}
+
+bool PhonebookManager::loadFile(const char *path, Table &table) {
+    FILE *f = fopen(path, "rb");
+    if (!f) return false;
+
+    int64_t start_us = esp_timer_get_time();
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    if (size < (long)(sizeof(PbFileHeader) + sizeof(uint32_t)) || size > APP_PB_FILE_MAX_BYTES) {
+        ESP_LOGW(TAG, "Ignoring %s: bad size %ld", path, size);
+        fclose(f);
+        return false;
+    }
+
+    uint8_t *buf = (uint8_t *)malloc((size_t)size);
+    if (!buf) {
+        fclose(f);
+        return false;
+    }
+    size_t len = fread(buf, 1, (size_t)size, f);
+    fclose(f);
+
+    uint32_t crc = 0;
+    PbFileHeader header = {};
+    bool ok = len == (size_t)size;
+    if (ok) {
+        memcpy(&crc, buf + len - sizeof(crc), sizeof(crc));
+        memcpy(&header, buf, sizeof(header));
+        ok = crc == esp_rom_crc32_le(0, buf, len - sizeof(crc)) &&
+             header.magic == PB_FILE_MAGIC && header.version == PB_FILE_VERSION;
+    }
+
+    size_t pos = sizeof(header);
+    size_t end = len - sizeof(crc);
+    for (uint16_t i = 0; ok && i < header.count; ++i) {
+        std::string_view number, name, type, value, parameter;
+        ok = pb_get_string(buf, end, pos, number) && pb_get_string(buf, end, pos, name) &&
+             pb_get_string(buf, end, pos, type) && pb_get_string(buf, end, pos, value) &&
+             pb_get_string(buf, end, pos, parameter) && !number.empty();
+        if (ok) table.upsert(number, name, type, value, parameter);
+    }
+    free(buf);
+
+    if (!ok) {
+        ESP_LOGW(TAG, "Ignoring %s: corrupt or unsupported", path);
+        table.entries.clear();
+        table.strings.clear();
+        return false;
+    }
+
+    ESP_LOGI(TAG, "Loaded %u entries from %s (%ld bytes) in %lld us",
+             (unsigned)table.entries.size(), path, size, (long long)(esp_timer_get_time() - start_us));
+    return true;
+}
+
+bool PhonebookManager::load(Table &table) {
+    table.entries.clear();
+    table.strings.clear();
+
+    bool ok = loadFile(_filename, table);
+    if (!ok && loadFile(_tmpFilename, table)) {
+        // Interrupted commit: the old file was already removed
+        rename(_tmpFilename, _filename);
+        ok = true;
+    }
+    return ok;
+}
+
+// Caller holds the write lock, so only one save touches the files at a time
+esp_err_t PhonebookManager::save(const Table &table) {
+    std::vector<uint8_t> out;
+    PbFileHeader header = {PB_FILE_MAGIC, PB_FILE_VERSION, (uint16_t)table.entries.size()};
+    const uint8_t *header_bytes = (const uint8_t *)&header;
+    out.insert(out.end(), header_bytes, header_bytes + sizeof(header));
+    for (const Table::Record &rec : table.entries) {
+        pb_put_string(out, rec.number);
+        pb_put_string(out, rec.entry.name);
+        pb_put_string(out, rec.entry.type);
+        pb_put_string(out, rec.entry.value);
+        pb_put_string(out, rec.entry.parameter);
+    }
+    uint32_t crc = esp_rom_crc32_le(0, out.data(), out.size());
+    const uint8_t *crc_bytes = (const uint8_t *)&crc;
+    out.insert(out.end(), crc_bytes, crc_bytes + sizeof(crc));
+
+    FILE *f = fopen(_tmpFilename, "wb");
+    if (!f) {
+        ESP_LOGE(TAG, "Cannot open %s for writing", _tmpFilename);
+        return ESP_FAIL;
+    }
+    bool ok = fwrite(out.data(), 1, out.size(), f) == out.size();
+    ok = fflush(f) == 0 && ok;
+    ok = fsync(fileno(f)) == 0 && ok;
+    fclose(f);
+    if (!ok) {
+        ESP_LOGE(TAG, "Writing %s failed", _tmpFilename);
+        unlink(_tmpFilename);
+        return ESP_FAIL;
+    }
+
+    // FATFS rename does not replace an existing file
+    unlink(_filename);
+    if (rename(_tmpFilename, _filename) != 0) {
+        ESP_LOGE(TAG, "Committing %s failed", _filename);
+        return ESP_FAIL;
+    }
+    ESP_LOGI(TAG, "Saved %u entries (%u bytes)", (unsigned)table.entries.size(), (unsigned)out.size());
+    return ESP_OK;
+}
+
+void PhonebookManager::Table::compile(PhonebookEntry &entry) const {
+    std::string_view key = entry.type == "FUNCTION" ? entry.value : entry.type;
+    entry.action = 0;
+    for (size_t i = 0; i < actions.size(); ++i) {
+        if (actions[i].key == key) {
+            entry.action = (uint8_t)(i + 1);
+            break;
+        }
+    }
+
+    entry.arg = -1;
+    std::string_view param = entry.parameter;
+    if (!param.empty() && param.size() <= 4 && param.find_first_not_of("0123456789") == std::string_view::npos) {
+        int value = 0;
+        for (char c : param) value = value * 10 + (c - '0');
+        entry.arg = (int16_t)value;
+    }
+}
+
+// Slots are only ever appended or rebound, so an entry's action index stays
+// valid in every later table version.
+bool PhonebookManager::registerAction(std::string_view key, phonebook_action_t handler) {
+    if (key.empty() || !handler) return false;
+
+    writeLockTake();
+    std::shared_ptr<Table> table = cloneTable(true);
+    bool ok = true;
+    auto slot = std::find_if(table->actions.begin(), table->actions.end(),
+                             [&](const Table::ActionSlot &s) { return s.key == key; });
+    if (slot != table->actions.end()) {
+        slot->handler = handler;
+    } else if (table->actions.size() >= UINT8_MAX) {
+        ESP_LOGE(TAG, "Action table full, cannot register %.*s", (int)key.size(), key.data());
+        ok = false;
+    } else {
+        table->actions.push_back({std::string(key), handler});
+        for (Table::Record &rec : table->entries) {
+            table->compile(rec.entry);
+        }
+    }
+    if (ok) publish(table);
+    writeLockGive();
+    return ok;
 }
 
-void PhonebookManager::load() {
-    // Phonebook persistence disabled; defaults only.
-    _entries.clear();
+bool PhonebookManager::dispatch(const PhonebookEntry &entry) const {
+    std::shared_ptr<const Table> table = snapshot();
+    if (!table || entry.action == 0 || entry.action > table->actions.size()) return false;
+    table->actions[entry.action - 1].handler(entry);
+    return true;
 }
 
-void PhonebookManager::save() {
-    // Phonebook persistence disabled; keep in memory only.
+void PhonebookManager::Table::upsert(std::string_view number, std::string_view name, std::string_view type, std::string_view value, std::string_view parameter) {
+    PhonebookEntry entry = {intern(name), intern(type), intern(value), intern(parameter)};
+    compile(entry);
+    auto it = position(number);
+    if (it != entries.end() && it->number == number) {
+        it->entry = entry;
+    } else {
+        entries.insert(it, {intern(number), entry});
+    }
 }
 
-bool PhonebookManager::hasEntry(std::string number) {
-    return _entries.find(number) != _entries.end();
+void PhonebookManager::Table::rebuildTrie() {
+    trie.clear();
+    trie.push_back({});
+    std::fill(std::begin(trie[0].child), std::end(trie[0].child), -1);
+
+    for (const Record &rec : entries) {
+        std::string_view number = rec.number;
+        if (number.empty() || number.find_first_not_of("0123456789") != std::string_view::npos) {
+            continue; // Not dialable; still reachable through find() after the timeout
+        }
+
+        size_t node = 0;
+        for (char c : number) {
+            int digit = c - '0';
+            if (trie[node].child[digit] < 0) {
+                trie[node].child[digit] = (int16_t)trie.size();
+                trie.push_back({});
+                std::fill(std::begin(trie.back().child), std::end(trie.back().child), -1);
+            }
+            node = trie[node].child[digit];
+        }
+        trie[node].terminal = true;
+    }
 }
 
-PhonebookEntry PhonebookManager::getEntry(std::string number) {
-    if (hasEntry(number)) {
-        return _entries[number];
+PhonebookMatch PhonebookManager::matchPrefix(std::string_view digits) const {
+    std::shared_ptr<const Table> table = snapshot();
+    if (digits.empty() || !table || table->trie.empty()) return PhonebookMatch::None;
+
+    const std::vector<Table::TrieNode> &trie = table->trie;
+    size_t node = 0;
+    for (char c : digits) {
+        if (c < '0' || c > '9') return PhonebookMatch::None;
+        int16_t next = trie[node].child[c - '0'];
+        if (next < 0) return PhonebookMatch::None;
+        node = (size_t)next;
     }
-    return {"Unknown", "NONE", "", ""};
+
+    const Table::TrieNode &n = trie[node];
+    bool has_children = std::any_of(std::begin(n.child), std::end(n.child), [](int16_t c) { return c >= 0; });
+    if (!n.terminal) return PhonebookMatch::Partial;
+    return has_children ? PhonebookMatch::Ambiguous : PhonebookMatch::Unique;
 }
 
-void PhonebookManager::addEntry(std::string number, std::string name, std::string type, std::string value, std::string parameter) {
-    _entries[number] = {name, type, value, parameter};
-    save();
+PhonebookEntryRef PhonebookManager::find(std::string_view number) const {
+    std::shared_ptr<const Table> table = snapshot();
+    const Table::Record *rec = table ? table->lookup(number) : nullptr;
+    if (!rec) return {};
+    return PhonebookEntryRef(table, &rec->entry);
 }
 
-void PhonebookManager::removeEntry(std::string number) {
-    if (hasEntry(number)) {
-        _entries.erase(number);
-        save();
+bool PhonebookManager::hasEntry(std::string_view number) const {
+    return static_cast<bool>(find(number));
+}
+
+PhonebookEntryRef PhonebookManager::getEntry(std::string_view number) const {
+    static const PhonebookEntry unknown = {"Unknown", "NONE", "", ""};
+    PhonebookEntryRef entry = find(number);
+    if (entry) {
+        return entry;
+    }
+    return PhonebookEntryRef(nullptr, &unknown);
+}
+
+void PhonebookManager::addEntry(std::string_view number, std::string_view name, std::string_view type, std::string_view value, std::string_view parameter) {
+    writeLockTake();
+    std::shared_ptr<Table> table = cloneTable(true);
+    table->upsert(number, name, type, value, parameter);
+    publish(table);
+    save(*table);
+    writeLockGive();
+}
+
+void PhonebookManager::removeEntry(std::string_view number) {
+    writeLockTake();
+    std::shared_ptr<Table> table = cloneTable(true);
+    auto it = table->position(number);
+    if (it != table->entries.end() && it->number == number) {
+        table->entries.erase(it);
+        publish(table);
+        save(*table);
     }
+    writeLockGive();
+}
+
+void PhonebookManager::writeJson(JsonWriter &out) const {
+    std::shared_ptr<const Table> table = snapshot();
+    out.beginObject();
+    if (table) {
+        for (const Table::Record &rec : table->entries) {
+            out.key(rec.number);
+            out.beginObject();
+            out.field("name", rec.entry.name);
+            out.field("type", rec.entry.type);
+            out.field("value", rec.entry.value);
+            out.field("parameter", rec.entry.parameter);
+            out.endObject();
+        }
+    }
+    out.endObject();
 }
 
 std::string PhonebookManager::getJson() {
-    cJSON *root = cJSON_CreateObject();
-    for (const auto &kv : _entries) {
-        cJSON *entry = cJSON_CreateObject();
-        cJSON_AddStringToObject(entry, "name", kv.second.name.c_str());
-        cJSON_AddStringToObject(entry, "type", kv.second.type.c_str());
-        cJSON_AddStringToObject(entry, "value", kv.second.value.c_str());
-        cJSON_AddStringToObject(entry, "parameter", kv.second.parameter.c_str());
-        cJSON_AddItemToObject(root, kv.first.c_str(), entry);
-    }
-
-    const char *json_str = cJSON_PrintUnformatted(root);
-    std::string out = json_str ? json_str : "{}";
-    free((void *)json_str);
-    cJSON_Delete(root);
-    return out;
+    std::string json;
+    JsonWriter out([](void *ctx, const char *data, size_t len) {
+        static_cast<std::string *>(ctx)->append(data, len);
+        return true;
+    }, &json);
+    writeJson(out);
+    out.finish();
+    return json;
 }
 
-void PhonebookManager::saveFromJson(std::string jsonString) {
-    cJSON *root = cJSON_Parse(jsonString.c_str());
+// The new table is built next to the live one, so lookups from the main task
+// keep working on the old entries until the swap.
+bool PhonebookManager::saveFromJson(const char *json) {
+    cJSON *root = cJSON_Parse(json);
     if (!root || !cJSON_IsObject(root)) {
         cJSON_Delete(root);
-        return;
+        return false;
     }
 
-    _entries.clear();
+    writeLockTake();
+    std::shared_ptr<Table> table = cloneTable(false);
 
     cJSON *item = NULL;
     cJSON_ArrayForEach(item, root) {
@@ -197,26 +607,34 @@ void PhonebookManager::saveFromJson(std::string jsonString) {
             continue;
         }
 
-        std::string parameter = cJSON_IsString(param) ? param->valuestring : "";
-        _entries[item->string] = {name->valuestring, type->valuestring, value->valuestring, parameter};
+        const char *parameter = cJSON_IsString(param) ? param->valuestring : "";
+        table->upsert(item->string, name->valuestring, type->valuestring, value->valuestring, parameter);
     }
 
+    publish(table);
+    writeLockGive();
     cJSON_Delete(root);
+    return true;
 }
 
-void PhonebookManager::saveChanges() {
-    save();
+esp_err_t PhonebookManager::saveChanges() {
+    writeLockTake();
+    std::shared_ptr<const Table> table = snapshot();
+    esp_err_t err = table ? save(*table) : ESP_ERR_INVALID_STATE;
+    writeLockGive();
+    return err;
 }
 
 void PhonebookManager::reloadDefaults() {
-    load();
     begin();
 }
 
-std::string PhonebookManager::findKeyByValueAndParam(std::string value, std::string parameter) {
-    for (auto const& [key, val] : _entries) {
-        if (val.value == value && val.parameter == parameter) {
-            return key;
+std::string PhonebookManager::findKeyByValueAndParam(std::string_view value, std::string_view parameter) const {
+    std::shared_ptr<const Table> table = snapshot();
+    if (!table) return "";
+    for (const Table::Record &rec : table->entries) {
+        if (rec.entry.value == value && rec.entry.parameter == parameter) {
+            return std::string(rec.number);
         }
     }
     return "";
@@ -1,42 +1,112 @@
 #pragma once
 
+#include <stdint.h>
+#include <memory>
 #include <string>
-#include <map>
+#include <string_view>
 #include "cJSON.h"
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "JsonWriter.h"
 
+// Fields view interned, NUL-terminated strings owned by one version of the
+// phonebook table; a PhonebookEntryRef keeps that version alive.
 struct PhonebookEntry {
-    std::string name;        // Display Name
-    std::string type;        // "TTS", "AUDIO", "FUNCTION"
-    std::string value;       // Text, Path, or ID
-    std::string parameter;   // Optional param
+    std::string_view name;        // Display Name
+    std::string_view type;        // "TTS", "AUDIO", "FUNCTION"
+    std::string_view value;       // Text, Path, or ID
+    std::string_view parameter;   // Optional param
+
+    // Compiled when the entry is stored
+    uint8_t action = 0;           // Slot in the action table, 0 = no handler registered
+    int16_t arg = -1;             // Numeric parameter (e.g. persona index), -1 if none
+};
+
+typedef void (*phonebook_action_t)(const PhonebookEntry &entry);
+
+// Result of find(): holds a reference to the table version the entry lives
+// in, so it stays valid while the web server replaces the phonebook.
+class PhonebookEntryRef {
+public:
+    PhonebookEntryRef() = default;
+    explicit operator bool() const { return _entry != nullptr; }
+    const PhonebookEntry &operator*() const { return *_entry; }
+    const PhonebookEntry *operator->() const { return _entry; }
+
+private:
+    friend class PhonebookManager;
+    PhonebookEntryRef(std::shared_ptr<const void> owner, const PhonebookEntry *entry)
+        : _owner(std::move(owner)), _entry(entry) {}
+
+    std::shared_ptr<const void> _owner;
+    const PhonebookEntry *_entry = nullptr;
 };
 
+// Result of matching a dialed digit prefix against all phonebook numbers
+enum class PhonebookMatch {
+    None,       // No number starts with these digits
+    Partial,    // Prefix of longer numbers only
+    Unique,     // Exact number with no longer extension: dispatch now
+    Ambiguous   // Exact number that is also a prefix of longer ones (e.g. "11" vs "110")
+};
+
+// Lookups work on an immutable snapshot of the table and never block on a
+// writer. Every modification builds a new table under _write_lock and swaps
+// it in, so lookups from the main task and edits from the web server can run
+// concurrently.
 class PhonebookManager {
 public:
     PhonebookManager();
+    ~PhonebookManager();
     void begin();
+    // Storage location (default /sdcard/phonebook.bin); call before begin().
+    // Both paths must outlive the manager.
+    void setFiles(const char *path, const char *tmp_path);
     
     // Core Functionality
-    bool hasEntry(std::string number);
-    PhonebookEntry getEntry(std::string number);
+    PhonebookEntryRef find(std::string_view number) const; // Empty if unknown
+    bool hasEntry(std::string_view number) const;
+    PhonebookEntryRef getEntry(std::string_view number) const; // "Unknown"/"NONE" entry if unknown
+    PhonebookMatch matchPrefix(std::string_view digits) const;
+
+    // Actions: key is the FUNCTION value (e.g. "ANNOUNCE_TIME") or the entry
+    // type for plain playback ("AUDIO", "TTS"). Registering recompiles all entries.
+    bool registerAction(std::string_view key, phonebook_action_t handler);
+    bool dispatch(const PhonebookEntry &entry) const; // false if no handler
     
     // Management
-    void addEntry(std::string number, std::string name, std::string type, std::string value, std::string parameter = "");
-    void removeEntry(std::string number);
+    void addEntry(std::string_view number, std::string_view name, std::string_view type, std::string_view value, std::string_view parameter = "");
+    void removeEntry(std::string_view number);
     std::string getJson(); 
-    void saveFromJson(std::string jsonString);
-    void saveChanges(); 
+    void writeJson(JsonWriter &out) const; // Streams the same object as getJson()
+    bool saveFromJson(const char *json); // Replaces all entries, false on invalid JSON
+    esp_err_t saveChanges(); 
     void reloadDefaults();
 
     // Search
-    std::string findKeyByValueAndParam(std::string value, std::string parameter);
+    std::string findKeyByValueAndParam(std::string_view value, std::string_view parameter) const;
 
 private:
-    const char* _filename = "/sdcard/phonebook.json"; // Moved to SD Card for IDF (for now)
-    std::map<std::string, PhonebookEntry> _entries;
-    
-    void load();
-    void save();
+    // Binary file, committed by writing _tmpFilename and renaming it over _filename
+    const char* _filename = "/sdcard/phonebook.bin";
+    const char* _tmpFilename = "/sdcard/phonebook.tmp";
+
+    struct Table; // Entries, interned strings, action table and digit trie
+    std::shared_ptr<const Table> _table;
+    mutable portMUX_TYPE _table_mux = portMUX_INITIALIZER_UNLOCKED; // Guards the _table pointer only
+    SemaphoreHandle_t _write_lock = nullptr; // Serializes writers (table rebuild + file save)
+
+    void writeLockTake();
+    void writeLockGive();
+    std::shared_ptr<const Table> snapshot() const;
+    std::shared_ptr<Table> cloneTable(bool with_entries) const;
+    void publish(std::shared_ptr<Table> table);
+
+    bool load(Table &table);
+    bool loadFile(const char *path, Table &table);
+    esp_err_t save(const Table &table);
+    bool addDefaults(Table &table);
 };
 
 extern PhonebookManager phonebook;
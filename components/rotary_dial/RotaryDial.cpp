@@ -1,46 +1,69 @@
 #include "RotaryDial.h"
-#include "esp_timer.h"
 #include "esp_log.h"
-#include "driver/gpio.h"
-#include "rom/ets_sys.h" 
+#include <stdlib.h>
 #include "app_config.h"
+#ifdef ESP_PLATFORM
+#include "rom/ets_sys.h"
+#else
+#include <stdio.h>
+#define ets_printf printf
+#endif
 
 // Hardcoded configs for component independence
 #define DIAL_DEBOUNCE_PULSE_MS APP_DIAL_PULSE_DEBOUNCE_MS
 #define DIAL_DIGIT_GAP_MS APP_DIAL_DIGIT_GAP_MS
 #define DIAL_TIMEOUT_MS APP_DIAL_TIMEOUT_MS
+#define DIAL_INPUT_DEBOUNCE_MS 50 // Hook and extra button settle time
 #define DIAL_MODE_ACTIVE_LOW true
 #define DIAL_PULSE_ACTIVE_LOW true
 
-static bool gpio_supports_internal_pull(gpio_num_t pin) {
-    int pin_num = static_cast<int>(pin);
-    if (pin_num < 0) {
-        return false;
-    }
-    return !(pin_num >= 34 && pin_num <= 39);
-}
+// Plausible inter-pulse periods for learning (nominal 10 pps = 100 ms)
+#define DIAL_LEARN_PERIOD_MIN_MS 40
+#define DIAL_LEARN_PERIOD_MAX_MS 200
+#define DIAL_LEARN_NVS_KEY "dial_period"
 
 // Macros for time
-#define MILLIS() (esp_timer_get_time() / 1000)
+#define MILLIS() (_hal->time_us() / 1000)
 
 RotaryDial* RotaryDial::_instance = nullptr;
 
 RotaryDial::RotaryDial(int pulse_pin, int hook_pin, int extra_btn_pin, int mode_pin) 
 {
-    _pulse_pin = (gpio_num_t)pulse_pin;
-    _hook_pin = (gpio_num_t)hook_pin;
-    _btn_pin = (gpio_num_t)extra_btn_pin;
-    _mode_pin = (gpio_num_t)mode_pin;
+    _pulse_pin = pulse_pin;
+    _hook_pin = hook_pin;
+    _btn_pin = extra_btn_pin;
+    _mode_pin = mode_pin;
+#ifdef ESP_PLATFORM
+    _hal = &rotary_dial_hal::kEsp;
+#else
+    _hal = nullptr;
+#endif
     
+    _edge_head.store(0);
+    _edge_tail.store(0);
+    _edge_overflows.store(0);
+    _trace = nullptr;
+    _trace_size = 0;
+    _trace_head = 0;
+    _trace_count = 0;
     _pulse_count = 0;
     _last_pulse_time = 0;
+    _period_ema_x16 = 0;
+    _period_samples = 0;
+    _period_saved_ms = 0;
+    _period_saved_at = 0;
     _dialing = false;
     _new_pulse = false;
     _last_pulse_delta_ms = 0;
+    _mode_raw = false;
+    _mode_stable = false;
+    _mode_change_time = 0;
     
     _off_hook = false;
+    _hook_raw = false;
     _last_hook_debounce = 0;
     _btn_state = false;
+    _btn_raw = false;
     _last_btn_debounce = 0;
 
     _dial_callback = nullptr;
@@ -52,6 +75,11 @@ RotaryDial::RotaryDial(int pulse_pin, int hook_pin, int extra_btn_pin, int mode_
     _pulse_active_low = DIAL_PULSE_ACTIVE_LOW;
 }
 
+RotaryDial::~RotaryDial() {
+    if (_instance == this) _instance = nullptr;
+    free(_trace);
+}
+
 void RotaryDial::setModeActiveLow(bool active_low) {
     _mode_active_low = active_low;
 }
@@ -60,13 +88,21 @@ void RotaryDial::setPulseActiveLow(bool active_low) {
     _pulse_active_low = active_low;
 }
 
+void RotaryDial::setHal(const RotaryDialHal *hal) {
+#ifdef ESP_PLATFORM
+    _hal = hal ? hal : &rotary_dial_hal::kEsp;
+#else
+    _hal = hal;
+#endif
+}
+
 void RotaryDial::debugLoop() {
     static int last_pulse_val = -1;
     static int last_mode_val = -1;
     
-    int pulse = gpio_get_level(_pulse_pin);
+    int pulse = _hal->get_level(_pulse_pin);
     int mode = -1;
-    if ((int)_mode_pin >= 0) mode = gpio_get_level(_mode_pin);
+    if (_mode_pin >= 0) mode = _hal->get_level(_mode_pin);
 
     bool changed = false;
     if (pulse != last_pulse_val) { last_pulse_val = pulse; changed = true; }
@@ -74,114 +110,265 @@ void RotaryDial::debugLoop() {
 
     if (changed) {
         // Direct print (ets_printf) to avoid logging overhead and buffering
-        ets_printf("RAW CHANGE -> P(5):%d | M(23):%d | Time:%lld\n", pulse, mode, MILLIS());
+        ets_printf("RAW CHANGE -> P(5):%d | M(23):%d | Time:%lld\n", pulse, mode, (long long)MILLIS());
     }
 }
 
 void IRAM_ATTR RotaryDial::isr_handler(void* arg) {
-    if (!_instance) return;
-    
-    // Check Mode Pin if used
-    if ((int)_instance->_mode_pin >= 0) {
-        int mode_level = gpio_get_level(_instance->_mode_pin);
-        bool mode_active = (mode_level == (_instance->_mode_active_low ? 0 : 1));
-        if (!mode_active) return;
+    RotaryDial *self = _instance;
+    if (!self) return;
+
+    InputEdge edge;
+    edge.time_us = (uint32_t)self->_hal->time_us();
+    edge.source = (uint8_t)(uintptr_t)arg;
+    edge.mode_active = 1;
+    int pin = self->_pulse_pin;
+    if (edge.source == EDGE_HOOK) pin = self->_hook_pin;
+    else if (edge.source == EDGE_BUTTON) pin = self->_btn_pin;
+    edge.level = (uint8_t)self->_hal->get_level(pin);
+    if (edge.source == EDGE_PULSE && self->_mode_pin >= 0) {
+        edge.mode_active = self->_hal->get_level(self->_mode_pin) == (self->_mode_active_low ? 0 : 1);
     }
+    self->pushEdge(edge);
+    self->_hal->signal_event(true);
+}
 
-    // Check Pulse Pin
-    int pulse_level = gpio_get_level(_instance->_pulse_pin);
+// Single producer: the ISR, or feedEdge() when no ISR is attached
+void IRAM_ATTR RotaryDial::wake_isr_handler(void* arg) {
+    static_cast<RotaryDial *>(arg)->_hal->signal_event(true);
+}
 
-    // Count only on the expected edge level to avoid double counts from ANYEDGE noise.
-    if (_instance->_pulse_active_low) {
-        if (pulse_level != 1) return; // Rising edge (idle low -> pulse high)
+bool IRAM_ATTR RotaryDial::pushEdge(const InputEdge &edge) {
+    uint32_t head = _edge_head.load(std::memory_order_relaxed);
+    if (head - _edge_tail.load(std::memory_order_acquire) >= kEdgeRingSize) {
+        _edge_overflows.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    _edge_ring[head & (kEdgeRingSize - 1)] = edge;
+    _edge_head.store(head + 1, std::memory_order_release);
+    return true;
+}
+
+bool RotaryDial::feedEdge(uint8_t source, int level, int64_t time_us, bool mode_active) {
+    if (source > EDGE_BUTTON) return false;
+    InputEdge edge;
+    edge.time_us = (uint32_t)time_us;
+    edge.source = source;
+    edge.level = level ? 1 : 0;
+    edge.mode_active = mode_active ? 1 : 0;
+    return pushEdge(edge);
+}
+
+// Debounce and count one captured edge (task context)
+void RotaryDial::handleEdge(int64_t time_ms, bool pulse_level, bool mode_active) {
+    if (!mode_active) return;
+
+    // Count only on the expected edge level to avoid double counts from contact noise.
+    if (_pulse_active_low) {
+        if (!pulse_level) return; // Rising edge (idle low -> pulse high)
     } else {
-        if (pulse_level != 0) return; // Falling edge (idle high -> pulse low)
+        if (pulse_level) return; // Falling edge (idle high -> pulse low)
     }
-    
-    // Logic: Count only on transition to INACTIVE level?
-    // Original: bool pulseInactive = (read == (ACTIVE_LOW ? HIGH : LOW)); -> (read == HIGH)
-    // Debounce and count run only in inactive state.
-    
-    // Simplified logic: Count Falling Edges if Active Low
-    // Alternative is active-state pulse detection.
-    
-    // Interrupt mode is "ANYEDGE" and counting runs on stable state.
-    // on the stable state. 
-    // Actually, Rotary Dial pulses are ~60ms break / 40ms make. 
-    // Original Arduino logic is retained:
-    // "if (read == HIGH && (now - _last_pulse_time > 50)) count++" (Active Low)
-    
-    int64_t now_ms = MILLIS();
-    if (now_ms - _instance->_last_pulse_time > DIAL_DEBOUNCE_PULSE_MS) {
+
+    // Rotary dial pulses are ~60ms break / 40ms make; edges closer than the
+    // debounce window belong to the same pulse.
+    if (time_ms - _last_pulse_time > DIAL_DEBOUNCE_PULSE_MS) {
         int32_t delta_ms = 0;
-        if (_instance->_pulse_count > 0) {
-            delta_ms = (int32_t)(now_ms - _instance->_last_pulse_time);
+        if (_pulse_count > 0) {
+            delta_ms = (int32_t)(time_ms - _last_pulse_time);
         }
-        _instance->_pulse_count++;
-        _instance->_last_pulse_time = now_ms;
-        _instance->_last_pulse_delta_ms = delta_ms;
-        _instance->_dialing = true;
-        _instance->_new_pulse = true;
+        if (delta_ms > 0) learnPulsePeriod(delta_ms);
+        _pulse_count++;
+        _last_pulse_time = time_ms;
+        _last_pulse_delta_ms = delta_ms;
+        _dialing = true;
+        _new_pulse = true;
     }
 }
 
-void RotaryDial::begin() {
-    gpio_config_t io_conf = {};
-    io_conf.intr_type = GPIO_INTR_DISABLE;
-    io_conf.mode = GPIO_MODE_INPUT;
-
-    auto configure_input_pin = [&](gpio_num_t pin, const char* label) {
-        io_conf.pin_bit_mask = (1ULL << pin);
-        if (gpio_supports_internal_pull(pin)) {
-            io_conf.pull_up_en = GPIO_PULLUP_ENABLE;
-            io_conf.pull_down_en = GPIO_PULLDOWN_DISABLE;
+// Exponential moving average (alpha 1/8) of the time between pulses of one digit
+void RotaryDial::learnPulsePeriod(int32_t delta_ms) {
+    if (delta_ms < DIAL_LEARN_PERIOD_MIN_MS || delta_ms > DIAL_LEARN_PERIOD_MAX_MS) return;
+    uint32_t sample_x16 = (uint32_t)delta_ms * 16;
+    if (_period_samples == 0) {
+        _period_ema_x16 = sample_x16;
+    } else {
+        _period_ema_x16 = _period_ema_x16 - _period_ema_x16 / 8 + sample_x16 / 8;
+    }
+    if (_period_samples < UINT16_MAX) _period_samples++;
+}
+
+uint32_t RotaryDial::digitGapMs() const {
+#if APP_DIAL_GAP_ADAPTIVE
+    if (_period_samples >= APP_DIAL_LEARN_MIN_SAMPLES) {
+        uint32_t gap = (_period_ema_x16 * APP_DIAL_GAP_PERIOD_FACTOR) / 16;
+        if (gap < APP_DIAL_GAP_MIN_MS) gap = APP_DIAL_GAP_MIN_MS;
+        if (gap > DIAL_DIGIT_GAP_MS) gap = DIAL_DIGIT_GAP_MS;
+        return gap;
+    }
+#endif
+    return DIAL_DIGIT_GAP_MS;
+}
+
+uint32_t RotaryDial::learnedPeriodMs() const {
+    return _period_samples >= APP_DIAL_LEARN_MIN_SAMPLES ? _period_ema_x16 / 16 : 0;
+}
+
+void RotaryDial::loadLearnedPeriod() {
+    uint16_t period_ms = 0;
+    if (_hal->load_u16(DIAL_LEARN_NVS_KEY, &period_ms) &&
+        period_ms >= DIAL_LEARN_PERIOD_MIN_MS && period_ms <= DIAL_LEARN_PERIOD_MAX_MS) {
+        _period_ema_x16 = (uint32_t)period_ms * 16;
+        _period_samples = APP_DIAL_LEARN_MIN_SAMPLES;
+        _period_saved_ms = period_ms;
+        ESP_LOGI("RotaryDial", "Learned pulse period %u ms, digit gap %u ms", (unsigned)period_ms, (unsigned)digitGapMs());
+    }
+}
+
+// Persist after a digit when the period moved by a few ms, at most once per interval
+void RotaryDial::maybeSaveLearnedPeriod(int64_t now_ms) {
+    if (_period_samples < APP_DIAL_LEARN_MIN_SAMPLES) return;
+    uint16_t period_ms = (uint16_t)(_period_ema_x16 / 16);
+    int diff = (int)period_ms - (int)_period_saved_ms;
+    if (diff > -3 && diff < 3) return;
+    if (_period_saved_at != 0 && now_ms - _period_saved_at < APP_DIAL_LEARN_SAVE_INTERVAL_MS) return;
+
+    _period_saved_at = now_ms;
+    if (_hal->save_u16(DIAL_LEARN_NVS_KEY, period_ms)) {
+        _period_saved_ms = period_ms;
+        ESP_LOGI("RotaryDial", "Saved pulse period %u ms, digit gap %u ms", (unsigned)period_ms, (unsigned)digitGapMs());
+    }
+}
+
+void RotaryDial::recordTrace(const TraceEdge &edge) {
+    portENTER_CRITICAL(&_trace_mux);
+    _trace[_trace_head] = edge;
+    _trace_head = (_trace_head + 1) % _trace_size;
+    if (_trace_count < _trace_size) _trace_count++;
+    portEXIT_CRITICAL(&_trace_mux);
+}
+
+size_t RotaryDial::copyTrace(TraceEdge *out, size_t max) const {
+    if (!_trace || !out) return 0;
+    portENTER_CRITICAL(&_trace_mux);
+    size_t count = _trace_count < max ? _trace_count : max;
+    size_t start = (_trace_head + _trace_size - count) % _trace_size;
+    for (size_t i = 0; i < count; ++i) {
+        out[i] = _trace[(start + i) % _trace_size];
+    }
+    portEXIT_CRITICAL(&_trace_mux);
+    return count;
+}
+
+bool RotaryDial::waitForEvent(uint32_t timeout_ms) {
+    return _hal->wait_event(timeout_ms);
+}
+
+void RotaryDial::notify() {
+    _hal->signal_event(false);
+}
+
+bool RotaryDial::addWakeInput(int pin) {
+    if (pin < 0) return false;
+    // A second handler on the same pin would replace the dial's own. Hook and
+    // button already wake on both edges, the pulse pin only on one.
+    if (pin == _hook_pin || pin == _btn_pin) return true;
+    if (pin == _pulse_pin) return false;
+    return _hal->setup_input(pin, RotaryDialIrq::AnyEdge, wake_isr_handler, this);
+}
+
+uint32_t RotaryDial::nextWakeMs() const {
+    int64_t now = MILLIS();
+    int64_t due = INT64_MAX;
+    auto at = [&](int64_t t) { if (t < due) due = t; };
+
+    if (_hook_raw != _off_hook) at(_last_hook_debounce + DIAL_INPUT_DEBOUNCE_MS);
+    if (_btn_raw != _btn_state) at(_last_btn_debounce + DIAL_INPUT_DEBOUNCE_MS);
+    if (_mode_pin >= 0) {
+        at(now + 20); // Mode contact is polled
+    } else if (_dialing) {
+        at(_last_pulse_time + (int64_t)digitGapMs() + 1);
+    }
+
+    if (due == INT64_MAX) return UINT32_MAX;
+    return due <= now ? 0 : (uint32_t)(due - now);
+}
+
+void RotaryDial::drainEdges() {
+    int64_t now_us = _hal->time_us();
+    uint32_t now32 = (uint32_t)now_us;
+    uint32_t tail = _edge_tail.load(std::memory_order_relaxed);
+    uint32_t head = _edge_head.load(std::memory_order_acquire);
+
+    while (tail != head) {
+        InputEdge edge = _edge_ring[tail & (kEdgeRingSize - 1)];
+        _edge_tail.store(++tail, std::memory_order_release);
+        // Widen the 32-bit capture time against the current 64-bit clock
+        int64_t time_us = now_us - (int64_t)(uint32_t)(now32 - edge.time_us);
+        int64_t time_ms = time_us / 1000;
+        if (_trace) recordTrace({time_us, edge.source, edge.level, edge.mode_active});
+        if (edge.source == EDGE_HOOK) {
+            bool raw = (edge.level == 0);
+            if (raw != _hook_raw) {
+                _hook_raw = raw;
+                _last_hook_debounce = time_ms;
+            }
+        } else if (edge.source == EDGE_BUTTON) {
+            bool raw = (edge.level == 0);
+            if (raw != _btn_raw) {
+                _btn_raw = raw;
+                _last_btn_debounce = time_ms;
+            }
         } else {
-            io_conf.pull_up_en = GPIO_PULLUP_DISABLE;
-            io_conf.pull_down_en = GPIO_PULLDOWN_DISABLE;
-            ESP_LOGW("RotaryDial", "%s GPIO %d has no internal pull resistor; using floating input", label, (int)pin);
-        }
-        esp_err_t cfg_err = gpio_config(&io_conf);
-        if (cfg_err != ESP_OK) {
-            ESP_LOGE("RotaryDial", "gpio_config failed for %s GPIO %d: %s", label, (int)pin, esp_err_to_name(cfg_err));
+            handleEdge(time_ms, edge.level != 0, edge.mode_active != 0);
         }
-    };
+    }
 
-    configure_input_pin(_pulse_pin, "Pulse");
-    configure_input_pin(_hook_pin, "Hook");
-    configure_input_pin(_btn_pin, "Button");
+    uint32_t overflows = _edge_overflows.exchange(0, std::memory_order_relaxed);
+    if (overflows > 0) {
+        ESP_LOGW("RotaryDial", "Pulse edge ring overflow, %u edges dropped", (unsigned)overflows);
+    }
+}
 
-    if ((int)_mode_pin >= 0) {
-        configure_input_pin(_mode_pin, "Mode");
+void RotaryDial::begin() {
+    // Count on a single pulse edge only to reduce false double counts on
+    // contact bounce. Hook and button wake the input task on both edges;
+    // loop() still re-samples their levels, so a missed or spurious edge
+    // (GPIO36/39 errata) only costs a wakeup.
+    RotaryDialIrq pulse_irq = _pulse_active_low ? RotaryDialIrq::Rising : RotaryDialIrq::Falling;
+    _hal->setup_input(_pulse_pin, pulse_irq, isr_handler, (void *)(uintptr_t)EDGE_PULSE);
+    _hal->setup_input(_hook_pin, RotaryDialIrq::AnyEdge, isr_handler, (void *)(uintptr_t)EDGE_HOOK);
+    _hal->setup_input(_btn_pin, RotaryDialIrq::AnyEdge, isr_handler, (void *)(uintptr_t)EDGE_BUTTON);
+    if (_mode_pin >= 0) {
+        _hal->setup_input(_mode_pin, RotaryDialIrq::None, nullptr, nullptr);
     }
 
     // Prime stable input states to avoid synthetic "state changed" callbacks
     // on the first loop iteration after boot.
-    _off_hook = (gpio_get_level(_hook_pin) == (APP_HOOK_ACTIVE_LOW ? 0 : 1));
-    _btn_state = (gpio_get_level(_btn_pin) == 0);
+    _off_hook = (_hal->get_level(_hook_pin) == (APP_HOOK_ACTIVE_LOW ? 0 : 1));
+    _btn_state = (_hal->get_level(_btn_pin) == 0);
+    _hook_raw = _off_hook;
+    _btn_raw = _btn_state;
     _last_hook_debounce = MILLIS();
     _last_btn_debounce = MILLIS();
     ESP_LOGI("RotaryDial", "Initial states: off_hook=%d btn_down=%d", _off_hook ? 1 : 0, _btn_state ? 1 : 0);
+    loadLearnedPeriod();
 
-    // Install ISR service
-    // ISR service may already exist from PERIPH or audio board setup.
-    esp_log_level_set("gpio", ESP_LOG_NONE); // Suppress "already installed" error
-    esp_err_t err = gpio_install_isr_service(0);
-    esp_log_level_set("gpio", ESP_LOG_INFO); // Restore
-    
-    if (err != ESP_OK && err != ESP_ERR_INVALID_STATE) {
-        // Only log real failures (not invalid state)
-        ESP_LOGE("RotaryDial", "ISR Install Failed: %d", err);
+#if APP_INPUT_TRACE_EDGES > 0
+    if (!_trace) {
+        _trace = (TraceEdge *)calloc(APP_INPUT_TRACE_EDGES, sizeof(TraceEdge));
+        if (_trace) {
+            _trace_size = APP_INPUT_TRACE_EDGES;
+        } else {
+            ESP_LOGW("RotaryDial", "No memory for input trace");
+        }
     }
-    
-    // Attach to Pulse
-    // Count on a single edge only to reduce false double counts on contact bounce.
-    gpio_int_type_t pulse_intr = _pulse_active_low ? GPIO_INTR_POSEDGE : GPIO_INTR_NEGEDGE;
-    gpio_set_intr_type(_pulse_pin, pulse_intr);
-    gpio_isr_handler_add(_pulse_pin, isr_handler, NULL);
+#endif
 }
 
 void RotaryDial::loop() {
     int64_t now = MILLIS();
+    drainEdges();
 
 #if APP_DIAL_DEBUG_SERIAL
     if (_new_pulse) {
@@ -191,79 +378,59 @@ void RotaryDial::loop() {
 #endif
     
     // --- Hook Logic ---
-    int hook_level = gpio_get_level(_hook_pin);
+    // Edges timestamp raw changes in drainEdges(); the sampled level catches
+    // anything the ISR missed. A change is accepted once it held for the debounce time.
+    int hook_level = _hal->get_level(_hook_pin);
     // Original: CONF_HOOK_ACTIVE_LOW = true
     // High = On Hook. Low = Off Hook.
     bool current_off_hook = (hook_level == 0); 
-    
-    // Debounce
-    if (current_off_hook != _off_hook) {
-        if (now - _last_hook_debounce > 50) { 
-             // Stable change
-             // Is this a change from previous stable state?
-             // Actually original logic was simpler:
-             // if (read != lastRead) debounce = now;
-             // if (now - debounce > delay) if (read != state) state = read;
-             
-             // Current branch compares state delta against stored debounce time.
-             // Continuous debounce updates on flicker are not used in this path.
-             // if (read != lastDebounceValue) lastDebounceTime = now;
-             
-             // Simple debounce path:
-             // state change is accepted after minimum stable interval.
-             _off_hook = current_off_hook;
-             if (_hook_callback) _hook_callback(_off_hook);
-             _last_hook_debounce = now;
+    if (current_off_hook != _hook_raw) {
+        _hook_raw = current_off_hook;
+        _last_hook_debounce = now;
+    }
+    if (_hook_raw != _off_hook && now - _last_hook_debounce >= DIAL_INPUT_DEBOUNCE_MS) {
+        _off_hook = _hook_raw;
+        if (_hook_callback) _hook_callback(_off_hook);
 #if APP_DIAL_DEBUG_SERIAL
-            ets_printf("HOOK state=%s level=%d time=%lld\n", _off_hook ? "OFF" : "ON", hook_level, now);
+        ets_printf("HOOK state=%s level=%d time=%lld\n", _off_hook ? "OFF" : "ON", hook_level, now);
 #endif
-        }
-    } else {
-        _last_hook_debounce = now;
     }
 
     // --- Button Logic ---
-    int btn_level = gpio_get_level(_btn_pin);
-    bool current_btn_down = (btn_level == 0);
-
-    if (current_btn_down != _btn_state) {
-        if (now - _last_btn_debounce > 50) {
-            _btn_state = current_btn_down;
-            // Trigger callback on Press (falling edge -> state becomes true)
-            if (_btn_state && _btn_callback) {
-                _btn_callback();
-            }
-            _last_btn_debounce = now;
-        }
-    } else {
+    bool current_btn_down = (_hal->get_level(_btn_pin) == 0);
+    if (current_btn_down != _btn_raw) {
+        _btn_raw = current_btn_down;
         _last_btn_debounce = now;
     }
+    if (_btn_raw != _btn_state && now - _last_btn_debounce >= DIAL_INPUT_DEBOUNCE_MS) {
+        _btn_state = _btn_raw;
+        // Trigger callback on Press (falling edge -> state becomes true)
+        if (_btn_state && _btn_callback) {
+            _btn_callback();
+        }
+    }
 
     // --- Dial Logic ---
-    if ((int)_mode_pin >= 0) {
-        int mode_level = gpio_get_level(_mode_pin);
+    if (_mode_pin >= 0) {
+        int mode_level = _hal->get_level(_mode_pin);
         bool mode_active = (mode_level == (_mode_active_low ? 0 : 1));
         
-        static bool last_raw_mode = false;
-        static bool stable_mode_active = false;
-        static int64_t mode_change_time = 0;
-        
-        if (mode_active != last_raw_mode) {
-            mode_change_time = now;
-            last_raw_mode = mode_active;
+        if (mode_active != _mode_raw) {
+            _mode_change_time = now;
+            _mode_raw = mode_active;
 #if APP_DIAL_DEBUG_SERIAL
             ets_printf("MODE raw=%d level=%d time=%lld\n", mode_active ? 1 : 0, mode_level, now);
 #endif
         }
         
-        if ((now - mode_change_time) > 20) {
-            stable_mode_active = mode_active;
+        if ((now - _mode_change_time) > 20) {
+            _mode_stable = mode_active;
 #if APP_DIAL_DEBUG_SERIAL
-            ets_printf("MODE stable=%d time=%lld\n", stable_mode_active ? 1 : 0, now);
+            ets_printf("MODE stable=%d time=%lld\n", _mode_stable ? 1 : 0, now);
 #endif
         }
 
-        if (stable_mode_active) {
+        if (_mode_stable) {
             _dialing = true;
             // _last_pulse_time = now; // Removed to prevent Debounce Race Condition
         } else {
@@ -286,11 +453,12 @@ void RotaryDial::loop() {
                     }
                 }
                 _pulse_count = 0;
+                maybeSaveLearnedPeriod(now);
             }
         }
     } else {
          // Timeout/Gap Logic (No mode pin)
-         if (_dialing && (now - _last_pulse_time > DIAL_DIGIT_GAP_MS)) {
+         if (_dialing && (now - _last_pulse_time > (int64_t)digitGapMs())) {
              _dialing = false;
              int digit = _pulse_count;
              if (digit > 9) digit = 0;
@@ -300,6 +468,7 @@ void RotaryDial::loop() {
              ets_printf("DIAL GAP digit=%d pulses=%d gap_ms=%lld\n", digit, _pulse_count, (now - _last_pulse_time));
 #endif
              _pulse_count = 0;
+             maybeSaveLearnedPeriod(now);
          } else if (_dialing && (now - _last_pulse_time > DIAL_TIMEOUT_MS)) {
              _dialing = false;
              int digit = _pulse_count;
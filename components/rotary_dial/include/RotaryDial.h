@@ -1,8 +1,13 @@
 #pragma once
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
-#include "driver/gpio.h"
+#ifdef __cplusplus
+#include <atomic>
+#endif
 #include "esp_attr.h"
+#include "freertos/FreeRTOS.h"
+#include "RotaryDialHal.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -14,7 +19,18 @@ typedef void (*button_callback_t)(void);
 
 class RotaryDial {
 public:
+    enum EdgeSource : uint8_t { EDGE_PULSE = 0, EDGE_HOOK, EDGE_BUTTON };
+
+    // One recorded raw edge, in the same terms feedEdge() accepts
+    struct TraceEdge {
+        int64_t time_us;
+        uint8_t source;
+        uint8_t level;
+        uint8_t mode_active;
+    };
+
     RotaryDial(int pulse_pin, int hook_pin, int extra_btn_pin, int mode_pin);
+    ~RotaryDial();
     void begin();
     void loop();
 
@@ -25,40 +41,107 @@ public:
     bool isOffHook();
     bool isButtonDown();
     bool isDialing() const;
+    uint32_t digitGapMs() const; // Pause that completes a digit (learned or APP_DIAL_DIGIT_GAP_MS)
+    uint32_t learnedPeriodMs() const; // Learned inter-pulse period, 0 until enough samples
+
+    // Event-driven input task: block until an input edge, notify() or timeout.
+    // nextWakeMs() is the time until loop() has a pending deadline (UINT32_MAX if idle).
+    bool waitForEvent(uint32_t timeout_ms);
+    uint32_t nextWakeMs() const;
+    void notify();
+    // Extra input whose edges only wake waitForEvent() (e.g. a polled key);
+    // call after begin(). false if its edges cannot wake the task.
+    bool addWakeInput(int pin);
 
     void setModeActiveLow(bool active_low);
     void setPulseActiveLow(bool active_low);
+
+    // Swap the platform backend; call before begin(). The table must outlive the dial.
+    // Required on host builds, which have no default.
+    void setHal(const RotaryDialHal *hal);
+    // Inject a raw edge as if the ISR had captured it (trace replay with a
+    // custom HAL). source: 0 = pulse, 1 = hook, 2 = button.
+    bool feedEdge(uint8_t source, int level, int64_t time_us, bool mode_active = true);
+
+    // Recent raw edges, oldest first (APP_INPUT_TRACE_EDGES). Safe from any task.
+    size_t copyTrace(TraceEdge *out, size_t max) const;
+    size_t traceCapacity() const { return _trace_size; }
+    uint32_t edgeOverflows() const { return _edge_overflows.load(std::memory_order_relaxed); }
     
     // Debug method
     void debugLoop();
 
 private:
-    gpio_num_t _pulse_pin;
-    gpio_num_t _hook_pin;
-    gpio_num_t _btn_pin;
-    gpio_num_t _mode_pin;
+    int _pulse_pin;
+    int _hook_pin;
+    int _btn_pin;
+    int _mode_pin;
+    const RotaryDialHal *_hal;
+
+    // Raw input edges: the ISR only timestamps and pushes (single producer),
+    // loop() drains and debounces them in task context (single consumer).
+    struct InputEdge {
+        uint32_t time_us;    // Low 32 bits of the HAL clock
+        uint8_t source;      // EdgeSource
+        uint8_t level;
+        uint8_t mode_active; // Pulse edges only
+    };
+    static constexpr uint32_t kEdgeRingSize = 64; // Power of two
+    InputEdge _edge_ring[kEdgeRingSize];
+    std::atomic<uint32_t> _edge_head;
+    std::atomic<uint32_t> _edge_tail;
+    std::atomic<uint32_t> _edge_overflows;
+
+    // Always-on trace of drained edges, filled in task context
+    TraceEdge *_trace;
+    size_t _trace_size;
+    size_t _trace_head;
+    size_t _trace_count;
+    mutable portMUX_TYPE _trace_mux = portMUX_INITIALIZER_UNLOCKED;
 
     int _pulse_count;
     int64_t _last_pulse_time;
+
+    // Learned inter-pulse period (EMA, ms * 16) and its persistence state
+    uint32_t _period_ema_x16;
+    uint16_t _period_samples;
+    uint16_t _period_saved_ms;
+    int64_t _period_saved_at;
     volatile bool _dialing;
     volatile bool _new_pulse;
     volatile int32_t _last_pulse_delta_ms;
     bool _mode_active_low;
     bool _pulse_active_low;
 
-    // Hook
+    // Mode contact (optional): last raw state, debounced state, time of last change
+    bool _mode_raw;
+    bool _mode_stable;
+    int64_t _mode_change_time;
+
+    // Hook: debounced state, last raw level and when it last changed
     bool _off_hook;
+    bool _hook_raw;
     int64_t _last_hook_debounce;
 
     // Button
     bool _btn_state;
+    bool _btn_raw;
     int64_t _last_btn_debounce;
 
     dial_callback_t _dial_callback;
     hook_callback_t _hook_callback;
     button_callback_t _btn_callback;
 
+    bool pushEdge(const InputEdge &edge);
+    void drainEdges();
+    void recordTrace(const TraceEdge &edge);
+    void learnPulsePeriod(int32_t delta_ms);
+    void loadLearnedPeriod();
+    void maybeSaveLearnedPeriod(int64_t now_ms);
+    void handleEdge(int64_t time_ms, bool pulse_level, bool mode_active);
+
     static void IRAM_ATTR isr_handler(void* arg);
+    static void IRAM_ATTR wake_isr_handler(void* arg);
     static RotaryDial* _instance;
 };
 
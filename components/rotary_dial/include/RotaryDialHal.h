@@ -0,0 +1,30 @@
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+
+// Everything RotaryDial needs from the platform: clock, GPIO, the wakeup
+// semaphore of the input task and a place to persist the learned pulse
+// period. The ESP-IDF table (rotary_dial_hal::kEsp) is the default on the
+// device; host builds pass their own through RotaryDial::setHal(), which is
+// how the simulator, tests and fuzz target under test/host drive the decoder.
+// time_us, get_level and signal_event(true) are called from the GPIO ISR and
+// must be IRAM safe.
+enum class RotaryDialIrq : uint8_t { None, Rising, Falling, AnyEdge };
+
+typedef void (*rotary_dial_isr_t)(void *arg);
+
+struct RotaryDialHal {
+    int64_t (*time_us)();
+    int (*get_level)(int pin);
+    // Input with pull-up where the pin has one; isr runs on irq edges (None = polled)
+    bool (*setup_input)(int pin, RotaryDialIrq irq, rotary_dial_isr_t isr, void *arg);
+    // Block the input task until signal_event() or the timeout; true on an event
+    bool (*wait_event)(uint32_t timeout_ms);
+    void (*signal_event)(bool from_isr);
+    bool (*load_u16)(const char *key, uint16_t *value);
+    bool (*save_u16)(const char *key, uint16_t value);
+};
+
+#ifdef ESP_PLATFORM
+#include "RotaryDialHalEsp.h"
+#endif
@@ -0,0 +1,109 @@
+#pragma once
+#include "RotaryDialHal.h"
+#include "driver/gpio.h"
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "nvs.h"
+
+// ESP-IDF backend of RotaryDialHal: GPIO ISR service, one binary semaphore
+// for the input task and the "dialcharm" NVS namespace.
+namespace rotary_dial_hal {
+
+inline SemaphoreHandle_t g_event_sem = nullptr;
+
+inline int64_t IRAM_ATTR esp_time_us() {
+    return esp_timer_get_time();
+}
+
+inline int IRAM_ATTR esp_get_level(int pin) {
+    return gpio_get_level((gpio_num_t)pin);
+}
+
+inline bool esp_setup_input(int pin, RotaryDialIrq irq, rotary_dial_isr_t isr, void *arg) {
+    if (pin < 0) return false;
+    gpio_config_t io_conf = {};
+    io_conf.pin_bit_mask = (1ULL << pin);
+    io_conf.mode = GPIO_MODE_INPUT;
+    io_conf.intr_type = GPIO_INTR_DISABLE;
+    io_conf.pull_down_en = GPIO_PULLDOWN_DISABLE;
+    if (pin >= 34 && pin <= 39) { // Input-only pads without pull resistors
+        io_conf.pull_up_en = GPIO_PULLUP_DISABLE;
+        ESP_LOGW("RotaryDial", "GPIO %d has no internal pull resistor; using floating input", pin);
+    } else {
+        io_conf.pull_up_en = GPIO_PULLUP_ENABLE;
+    }
+    esp_err_t err = gpio_config(&io_conf);
+    if (err != ESP_OK) {
+        ESP_LOGE("RotaryDial", "gpio_config failed for GPIO %d: %s", pin, esp_err_to_name(err));
+        return false;
+    }
+    if (irq == RotaryDialIrq::None || !isr) return true;
+
+    if (!g_event_sem) g_event_sem = xSemaphoreCreateBinary();
+
+    // The ISR service may already exist from PERIPH or audio board setup
+    static bool isr_service = false;
+    if (!isr_service) {
+        esp_log_level_set("gpio", ESP_LOG_NONE); // Suppress "already installed" error
+        err = gpio_install_isr_service(0);
+        esp_log_level_set("gpio", ESP_LOG_INFO);
+        if (err != ESP_OK && err != ESP_ERR_INVALID_STATE) {
+            ESP_LOGE("RotaryDial", "ISR Install Failed: %d", err);
+            return false;
+        }
+        isr_service = true;
+    }
+
+    gpio_int_type_t type = irq == RotaryDialIrq::Rising ? GPIO_INTR_POSEDGE
+                         : irq == RotaryDialIrq::Falling ? GPIO_INTR_NEGEDGE : GPIO_INTR_ANYEDGE;
+    err = gpio_set_intr_type((gpio_num_t)pin, type);
+    if (err == ESP_OK) err = gpio_isr_handler_add((gpio_num_t)pin, isr, arg);
+    return err == ESP_OK;
+}
+
+inline bool esp_wait_event(uint32_t timeout_ms) {
+    TickType_t ticks = pdMS_TO_TICKS(timeout_ms);
+    if (ticks < 1) ticks = 1; // Always yield so IDLE can run
+    if (!g_event_sem) {
+        vTaskDelay(ticks);
+        return false;
+    }
+    return xSemaphoreTake(g_event_sem, ticks) == pdTRUE;
+}
+
+inline void IRAM_ATTR esp_signal_event(bool from_isr) {
+    if (!g_event_sem) return;
+    if (from_isr) {
+        BaseType_t woken = pdFALSE;
+        xSemaphoreGiveFromISR(g_event_sem, &woken);
+        portYIELD_FROM_ISR(woken);
+    } else {
+        xSemaphoreGive(g_event_sem);
+    }
+}
+
+inline bool esp_load_u16(const char *key, uint16_t *value) {
+    nvs_handle_t handle;
+    if (nvs_open("dialcharm", NVS_READONLY, &handle) != ESP_OK) return false;
+    bool ok = nvs_get_u16(handle, key, value) == ESP_OK;
+    nvs_close(handle);
+    return ok;
+}
+
+inline bool esp_save_u16(const char *key, uint16_t value) {
+    nvs_handle_t handle;
+    if (nvs_open("dialcharm", NVS_READWRITE, &handle) != ESP_OK) return false;
+    bool ok = nvs_set_u16(handle, key, value) == ESP_OK && nvs_commit(handle) == ESP_OK;
+    nvs_close(handle);
+    return ok;
+}
+
+inline const RotaryDialHal kEsp = {
+    esp_time_us, esp_get_level, esp_setup_input, esp_wait_event, esp_signal_event, esp_load_u16, esp_save_u16,
+};
+
+} // namespace rotary_dial_hal
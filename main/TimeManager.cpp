@@ -5,20 +5,112 @@
 #include "nvs.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_timer.h"
+#include "esp_rom_crc.h"
+#include "StateVersion.h"
+#include "LocalTimeCache.h"
 #include <sys/time.h>
+#include <stddef.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <atomic>
+#include <map>
+#include <set>
+#include <utility>
 #include "driver/i2c_master.h"
 #include "app_config.h"
 
 static const char *TAG = "TIME_MANAGER";
 static bool _alarm_ringing = false;
-static int64_t _last_triggered_key = -1; // Ensure trigger only once per minute slot
 static TaskHandle_t s_sntp_task = NULL;
 static bool s_sntp_synced = false;
 static time_t s_last_ntp_sync = 0;
 
+// Earliest epoch treated as a valid wall clock (2020-01-01 UTC)
+static const time_t kMinValidEpoch = 1577836800;
+// A jump larger than this between two checkAlarm() calls is treated as a clock step
+static const time_t kClockStepThresholdSec = 90;
+
+// Persisted alarm entry. POD so the whole schedule can be stored as one NVS blob.
+// Ids 0-6 are the fixed weekday slots (id == dayIndex), additional alarms use ids >= 7.
+struct StoredAlarm {
+    uint16_t id;
+    uint8_t days;          // Bit mask, bit0 = Sunday ... bit6 = Saturday; 0 = one-shot
+    int8_t hour;
+    int8_t minute;
+    bool active;
+    bool volumeRamp;
+    bool useRandomMsg;
+    uint16_t year;         // One-shot date (local time)
+    uint8_t month;         // 1-12
+    uint8_t mday;
+    char ringtone[64];
+};
+
+// Persisted form of the schedule: one NVS blob instead of 42 per-day keys.
+// Layout: header, `count` StoredAlarm records, CRC32 over everything before it.
+// Bump kScheduleBlobVersion when StoredAlarm changes layout.
+static const char *kScheduleBlobKey = "alm_sched";
+static const uint32_t kScheduleBlobMagic = 0x534D4C41; // "ALMS"
+static const uint16_t kScheduleBlobVersion = 2;
+static const size_t kMaxAlarms = 7 + APP_ALARM_MAX_EXTRA;
+
+struct ScheduleBlobHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t count;
+};
+
+// Version 1 layout (seven weekday entries only), kept for migration
+struct ScheduleV1Day {
+    int8_t hour;
+    int8_t minute;
+    bool active;
+    bool volumeRamp;
+    bool useRandomMsg;
+    char ringtone[64];
+};
+
+struct ScheduleBlobV1 {
+    ScheduleBlobHeader header;
+    ScheduleV1Day days[7];
+    uint32_t crc;
+};
+
+struct AlarmSlot {
+    StoredAlarm cfg;
+    time_t next;           // Queued fire time, 0 = not queued
+};
+
+// Schedule engine, guarded by s_alarm_lock. s_alarm_queue orders (fire time, id) so
+// inserting/removing an alarm is O(log n) and the next deadline is begin().
+static SemaphoreHandle_t s_alarm_lock = NULL;
+static std::map<uint16_t, AlarmSlot> s_alarms;
+static std::set<std::pair<time_t, uint16_t>> s_alarm_queue;
+static bool s_alarms_loaded = false;
+static StoredAlarm s_ringing_alarm;
+
+// Fast-path state read by checkAlarm() every loop, guarded by s_alarm_mux.
+static portMUX_TYPE s_alarm_mux = portMUX_INITIALIZER_UNLOCKED;
+static uint32_t s_alarm_gen = 1;          // Bumped on timezone/clock changes
+static uint32_t s_next_alarm_gen = 0;     // Generation the queue was last rebuilt for
+static time_t s_next_alarm_epoch = 0;     // Front of s_alarm_queue, 0 = no active alarm
+static time_t s_last_fired_epoch = 0;     // Ensure trigger only once per alarm slot
+static time_t s_last_check_epoch = 0;
+
+// Broken-down local time, recomputed at most once per wall-clock second.
+// s_time_cache_gen is bumped on SNTP sync and timezone changes.
+static LocalTimeCache s_time_cache;
+static std::atomic<uint32_t> s_time_cache_gen{1};
+#if APP_TIME_DIAG_LOG
+static std::atomic<uint32_t> s_time_cache_hits{0};
+static std::atomic<uint32_t> s_time_cache_misses{0};
+static std::atomic<uint32_t> s_time_cache_miss_us{0};
+static std::atomic<int64_t> s_time_cache_last_log_us{0};
+#endif
+
 // RTC DS3231 Implementation
 #define I2C_PORT_NUM I2C_NUM_1
 #define DS3231_ADDR 0x68
@@ -32,6 +124,8 @@ static uint8_t dec2bcd(uint8_t val) { return ((val / 10 * 16) + (val % 10)); }
 static bool rtc_read_time_raw(struct tm *out_tm);
 static bool rtc_read_status(uint8_t *status);
 static bool rtc_clear_osf();
+static void invalidate_next_alarm();
+static void invalidate_local_time_cache();
 
 static time_t timegm_utc(struct tm *timeinfo) {
     if (!timeinfo) return (time_t)-1;
@@ -224,6 +318,8 @@ void time_sync_notification_cb(struct timeval *tv) {
     rtc_clear_osf();
     s_sntp_synced = true;
     s_last_ntp_sync = now;
+    invalidate_local_time_cache();
+    invalidate_next_alarm();
 }
 
 void TimeManager::init() {
@@ -249,6 +345,7 @@ void TimeManager::init() {
     if (tz.empty()) tz = "CET-1CEST,M3.5.0,M10.5.0/3"; // Default Berlin
     setenv("TZ", tz.c_str(), 1);
     tzset();
+    invalidate_local_time_cache();
 }
 
 void TimeManager::setTimezone(const char* tz) {
@@ -270,6 +367,9 @@ void TimeManager::setTimezone(const char* tz) {
         
         setenv("TZ", tz, 1);
         tzset();
+        invalidate_local_time_cache();
+        invalidate_next_alarm();
+        state_version::bump(STATE_SETTINGS);
         ESP_LOGI(TAG, "Timezone set to: %s", tz);
         
         // Update RTC time just in case (optional, but recalculates local time)
@@ -298,91 +398,659 @@ std::string TimeManager::getTimezone() {
     return tz;
 }
 
-void TimeManager::setAlarm(int dayIndex, int hour, int minute, bool active, bool volumeRamp, bool useMsg, const char* ringtone) {
-    if (dayIndex < 0 || dayIndex > 6) return;
+static void alarm_keys(int dayIndex, char key_h[16], char key_m[16], char key_en[16],
+                       char key_rmp[16], char key_msg[16], char key_snd[16]) {
+    snprintf(key_h, 16, "alm_%d_h", dayIndex);
+    snprintf(key_m, 16, "alm_%d_m", dayIndex);
+    snprintf(key_en, 16, "alm_%d_en", dayIndex);
+    snprintf(key_rmp, 16, "alm_%d_rmp", dayIndex);
+    snprintf(key_msg, 16, "alm_%d_msg", dayIndex);
+    snprintf(key_snd, 16, "alm_%d_snd", dayIndex);
+}
+
+static void set_ringtone(StoredAlarm *out, const char *tone) {
+    if (!tone || tone[0] == '\0') tone = APP_DEFAULT_TIMER_RINGTONE;
+    strncpy(out->ringtone, tone, sizeof(out->ringtone) - 1);
+    out->ringtone[sizeof(out->ringtone) - 1] = '\0';
+}
+
+static void default_weekday_alarm(int dayIndex, StoredAlarm *out) {
+    memset(out, 0, sizeof(*out));
+    out->id = (uint16_t)dayIndex;
+    out->days = (uint8_t)(1u << dayIndex);
+    out->hour = 7;
+    out->minute = 0;
+    set_ringtone(out, NULL);
+}
+
+static void load_alarm_from_handle(nvs_handle_t handle, int dayIndex, StoredAlarm *out) {
+    char key_h[16], key_m[16], key_en[16], key_rmp[16], key_msg[16], key_snd[16];
+    alarm_keys(dayIndex, key_h, key_m, key_en, key_rmp, key_msg, key_snd);
+
+    int32_t val_i32;
+    uint8_t val_u8;
+    size_t len;
+    char buf[64];
+
+    if (nvs_get_i32(handle, key_h, &val_i32) == ESP_OK) out->hour = (int8_t)val_i32;
+    if (nvs_get_i32(handle, key_m, &val_i32) == ESP_OK) out->minute = (int8_t)val_i32;
+    if (nvs_get_u8(handle, key_en, &val_u8) == ESP_OK) out->active = (val_u8 == 1);
+    if (nvs_get_u8(handle, key_rmp, &val_u8) == ESP_OK) out->volumeRamp = (val_u8 == 1);
+    if (nvs_get_u8(handle, key_msg, &val_u8) == ESP_OK) out->useRandomMsg = (val_u8 == 1);
+
+    len = sizeof(buf);
+    if (nvs_get_str(handle, key_snd, buf, &len) == ESP_OK && len > 0) {
+        set_ringtone(out, buf);
+    }
+}
+
+static bool alarm_time_valid(int hour, int minute) {
+    return hour >= 0 && hour <= 23 && minute >= 0 && minute <= 59;
+}
+
+static bool alarm_date_valid(int year, int month, int mday) {
+    return year >= 2020 && year <= 2099 && month >= 1 && month <= 12 && mday >= 1 && mday <= 31;
+}
+
+static DayAlarm to_day_alarm(const StoredAlarm &c) {
+    DayAlarm alarm = {c.hour, c.minute, c.active, c.volumeRamp, c.useRandomMsg, c.ringtone};
+    return alarm;
+}
+
+static AlarmEntry to_alarm_entry(const StoredAlarm &c) {
+    AlarmEntry entry;
+    entry.id = c.id;
+    entry.days = c.days;
+    entry.hour = c.hour;
+    entry.minute = c.minute;
+    entry.year = c.year;
+    entry.month = c.month;
+    entry.mday = c.mday;
+    entry.active = c.active;
+    entry.volumeRamp = c.volumeRamp;
+    entry.useRandomMsg = c.useRandomMsg;
+    entry.ringtone = c.ringtone;
+    return entry;
+}
 
+static void alarm_lock_take() {
+    if (!s_alarm_lock) {
+        SemaphoreHandle_t created = xSemaphoreCreateMutex();
+        portENTER_CRITICAL(&s_alarm_mux);
+        if (!s_alarm_lock) {
+            s_alarm_lock = created;
+            created = NULL;
+        }
+        portEXIT_CRITICAL(&s_alarm_mux);
+        if (created) vSemaphoreDelete(created);
+    }
+    xSemaphoreTake(s_alarm_lock, portMAX_DELAY);
+}
+
+static void alarm_lock_give() {
+    xSemaphoreGive(s_alarm_lock);
+}
+
+// --- Persistence (caller holds s_alarm_lock) ---
+
+static esp_err_t write_schedule_blob_locked(nvs_handle_t handle) {
+    size_t count = s_alarms.size();
+    size_t len = sizeof(ScheduleBlobHeader) + count * sizeof(StoredAlarm) + sizeof(uint32_t);
+    uint8_t *buf = (uint8_t *)calloc(1, len); // Zeroed so struct padding is deterministic for the CRC
+    if (!buf) return ESP_ERR_NO_MEM;
+
+    ScheduleBlobHeader header = {kScheduleBlobMagic, kScheduleBlobVersion, (uint16_t)count};
+    memcpy(buf, &header, sizeof(header));
+    StoredAlarm *records = (StoredAlarm *)(buf + sizeof(header));
+    size_t i = 0;
+    for (const auto &kv : s_alarms) {
+        records[i++] = kv.second.cfg;
+    }
+    size_t crc_offset = len - sizeof(uint32_t);
+    uint32_t crc = esp_rom_crc32_le(0, buf, crc_offset);
+    memcpy(buf + crc_offset, &crc, sizeof(crc));
+
+    esp_err_t err = nvs_set_blob(handle, kScheduleBlobKey, buf, len);
+    free(buf);
+    if (err == ESP_OK) err = nvs_commit(handle);
+    return err;
+}
+
+static esp_err_t save_alarms_locked() {
+#if APP_ALARM_DIAG_LOG
+    int64_t start_us = esp_timer_get_time();
+#endif
     nvs_handle_t my_handle;
     esp_err_t err = nvs_open("dialcharm", NVS_READWRITE, &my_handle);
-    if (err == ESP_OK) {
-        char key_h[16], key_m[16], key_en[16], key_rmp[16], key_msg[16], key_snd[16];
-        snprintf(key_h, sizeof(key_h), "alm_%d_h", dayIndex);
-        snprintf(key_m, sizeof(key_m), "alm_%d_m", dayIndex);
-        snprintf(key_en, sizeof(key_en), "alm_%d_en", dayIndex);
-        snprintf(key_rmp, sizeof(key_rmp), "alm_%d_rmp", dayIndex);
-        snprintf(key_msg, sizeof(key_msg), "alm_%d_msg", dayIndex);
-        snprintf(key_snd, sizeof(key_snd), "alm_%d_snd", dayIndex);
-
-        err = nvs_set_i32(my_handle, key_h, hour);
-        if (err == ESP_OK) err = nvs_set_i32(my_handle, key_m, minute);
-        if (err == ESP_OK) err = nvs_set_u8(my_handle, key_en, active ? 1 : 0);
-        if (err == ESP_OK) err = nvs_set_u8(my_handle, key_rmp, volumeRamp ? 1 : 0);
-        if (err == ESP_OK) err = nvs_set_u8(my_handle, key_msg, useMsg ? 1 : 0);
-        
-        if (err == ESP_OK) {
-            if (ringtone && strlen(ringtone) > 0) {
-                err = nvs_set_str(my_handle, key_snd, ringtone);
-            } else {
-                err = nvs_set_str(my_handle, key_snd, APP_DEFAULT_TIMER_RINGTONE);
-            }
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to open NVS for alarm schedule: %s", esp_err_to_name(err));
+        return err;
+    }
+    err = write_schedule_blob_locked(my_handle);
+    nvs_close(my_handle);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to save alarm schedule: %s", esp_err_to_name(err));
+        return err;
+    }
+    state_version::bump(STATE_SETTINGS);
+#if APP_ALARM_DIAG_LOG
+    ESP_LOGI(TAG, "Alarm schedule saved (%u alarms, 1 commit) in %lld us",
+             (unsigned)s_alarms.size(), (long long)(esp_timer_get_time() - start_us));
+#endif
+    return ESP_OK;
+}
+
+static void insert_alarm_locked(const StoredAlarm &cfg) {
+    AlarmSlot slot;
+    slot.cfg = cfg;
+    slot.cfg.ringtone[sizeof(slot.cfg.ringtone) - 1] = '\0';
+    slot.next = 0;
+    s_alarms[cfg.id] = slot;
+}
+
+static bool parse_schedule_v1(const uint8_t *buf, size_t len) {
+    if (len != sizeof(ScheduleBlobV1)) return false;
+    ScheduleBlobV1 blob;
+    memcpy(&blob, buf, sizeof(blob));
+    if (blob.header.count != 7 || blob.crc != esp_rom_crc32_le(0, buf, offsetof(ScheduleBlobV1, crc))) return false;
+
+    for (int i = 0; i < 7; ++i) {
+        const ScheduleV1Day &d = blob.days[i];
+        StoredAlarm a;
+        default_weekday_alarm(i, &a);
+        if (alarm_time_valid(d.hour, d.minute)) {
+            a.hour = d.hour;
+            a.minute = d.minute;
         }
-        
-        if (err == ESP_OK) {
-            err = nvs_commit(my_handle);
+        a.active = d.active;
+        a.volumeRamp = d.volumeRamp;
+        a.useRandomMsg = d.useRandomMsg;
+        char tone[sizeof(d.ringtone)];
+        memcpy(tone, d.ringtone, sizeof(tone));
+        tone[sizeof(tone) - 1] = '\0';
+        set_ringtone(&a, tone);
+        insert_alarm_locked(a);
+    }
+    return true;
+}
+
+static bool parse_schedule_v2(const uint8_t *buf, size_t len, uint16_t count) {
+    size_t expected = sizeof(ScheduleBlobHeader) + count * sizeof(StoredAlarm) + sizeof(uint32_t);
+    if (len != expected || count > kMaxAlarms) return false;
+    uint32_t crc;
+    memcpy(&crc, buf + len - sizeof(crc), sizeof(crc));
+    if (crc != esp_rom_crc32_le(0, buf, len - sizeof(crc))) return false;
+
+    const uint8_t *p = buf + sizeof(ScheduleBlobHeader);
+    for (uint16_t i = 0; i < count; ++i, p += sizeof(StoredAlarm)) {
+        StoredAlarm a;
+        memcpy(&a, p, sizeof(a));
+        if (!alarm_time_valid(a.hour, a.minute)) continue;
+        if (a.id < 7) {
+            a.days = (uint8_t)(1u << a.id); // Weekday slots are fixed to their day
+        } else if (a.days == 0 && !alarm_date_valid(a.year, a.month, a.mday)) {
+            continue;
+        }
+        insert_alarm_locked(a);
+    }
+    return true;
+}
+
+// Returns ESP_ERR_NVS_NOT_FOUND when no blob exists yet, ESP_OK if the blob
+// was parsed (rewrite_needed set for older versions) and an error otherwise.
+static esp_err_t read_schedule_blob_locked(nvs_handle_t handle, bool *rewrite_needed) {
+    size_t len = 0;
+    esp_err_t err = nvs_get_blob(handle, kScheduleBlobKey, NULL, &len);
+    if (err != ESP_OK) return err;
+    if (len < sizeof(ScheduleBlobHeader) + sizeof(uint32_t)) return ESP_ERR_INVALID_SIZE;
+
+    uint8_t *buf = (uint8_t *)malloc(len);
+    if (!buf) return ESP_ERR_NO_MEM;
+    err = nvs_get_blob(handle, kScheduleBlobKey, buf, &len);
+    if (err != ESP_OK) {
+        free(buf);
+        return err;
+    }
+
+    ScheduleBlobHeader header;
+    memcpy(&header, buf, sizeof(header));
+    bool ok = false;
+    if (header.magic == kScheduleBlobMagic && header.version == 1) {
+        ok = parse_schedule_v1(buf, len);
+        *rewrite_needed = ok;
+    } else if (header.magic == kScheduleBlobMagic && header.version == kScheduleBlobVersion) {
+        ok = parse_schedule_v2(buf, len, header.count);
+    }
+    free(buf);
+
+    if (!ok) {
+        ESP_LOGE(TAG, "Alarm schedule blob invalid (len=%u ver=%u), using defaults", (unsigned)len, (unsigned)header.version);
+        s_alarms.clear();
+        return ESP_ERR_INVALID_CRC;
+    }
+    return ESP_OK;
+}
+
+// One-time conversion of the legacy alm_%d_* keys into the schedule blob.
+// Legacy keys are erased only after the blob has been committed.
+static void migrate_legacy_alarm_keys_locked(nvs_handle_t handle) {
+    for (int i = 0; i < 7; ++i) {
+        StoredAlarm a;
+        default_weekday_alarm(i, &a);
+        load_alarm_from_handle(handle, i, &a);
+        if (!alarm_time_valid(a.hour, a.minute)) default_weekday_alarm(i, &a);
+        insert_alarm_locked(a);
+    }
+
+    esp_err_t err = write_schedule_blob_locked(handle);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Alarm schedule migration failed: %s", esp_err_to_name(err));
+        return;
+    }
+
+    int erased = 0;
+    for (int i = 0; i < 7; ++i) {
+        char keys[6][16];
+        alarm_keys(i, keys[0], keys[1], keys[2], keys[3], keys[4], keys[5]);
+        for (int k = 0; k < 6; ++k) {
+            if (nvs_erase_key(handle, keys[k]) == ESP_OK) erased++;
+        }
+    }
+    if (erased > 0) nvs_commit(handle);
+    ESP_LOGI(TAG, "Alarm schedule migrated to blob (%d legacy keys removed)", erased);
+}
+
+// Loads the schedule from NVS once; afterwards RAM is the source of truth and
+// every edit is written back as a whole blob.
+static void ensure_alarms_loaded_locked() {
+    if (s_alarms_loaded) return;
+
+    nvs_handle_t my_handle;
+    if (nvs_open("dialcharm", NVS_READWRITE, &my_handle) == ESP_OK) {
+        bool rewrite_needed = false;
+        esp_err_t err = read_schedule_blob_locked(my_handle, &rewrite_needed);
+        if (err == ESP_ERR_NVS_NOT_FOUND) {
+            migrate_legacy_alarm_keys_locked(my_handle);
+        } else if (err == ESP_OK && rewrite_needed) {
+            esp_err_t werr = write_schedule_blob_locked(my_handle);
+            ESP_LOGI(TAG, "Alarm schedule blob upgraded to v%u: %s", (unsigned)kScheduleBlobVersion, esp_err_to_name(werr));
         }
         nvs_close(my_handle);
+    }
 
-        if (err != ESP_OK) {
-            ESP_LOGE(TAG, "Failed to save alarm day %d: %s", dayIndex, esp_err_to_name(err));
-            return;
+    // Weekday slots always exist, even on a fresh or corrupt store
+    for (int i = 0; i < 7; ++i) {
+        if (s_alarms.find(i) == s_alarms.end()) {
+            StoredAlarm a;
+            default_weekday_alarm(i, &a);
+            insert_alarm_locked(a);
         }
+    }
+    s_alarms_loaded = true;
 
-        int logDay = (dayIndex == 0) ? 7 : dayIndex;
-        ESP_LOGI(TAG, "Saved Alarm Day %d: %02d:%02d (Act:%d Rmp:%d Msg:%d) Tone: %s", logDay, hour, minute, active, volumeRamp, useMsg, ringtone);
-    } else {
-        ESP_LOGE(TAG, "Failed to open NVS for alarm day %d: %s", dayIndex, esp_err_to_name(err));
+    portENTER_CRITICAL(&s_alarm_mux);
+    s_alarm_gen++; // Forces the first queue build
+    portEXIT_CRITICAL(&s_alarm_mux);
+}
+
+// --- Scheduling (caller holds s_alarm_lock) ---
+
+// First fire time at or after `from`, 0 if the alarm will not fire.
+static time_t compute_next_fire(const StoredAlarm &a, time_t from) {
+    if (!a.active) return 0;
+
+    if (a.days == 0) {
+        struct tm t = {};
+        t.tm_year = a.year - 1900;
+        t.tm_mon = a.month - 1;
+        t.tm_mday = a.mday;
+        t.tm_hour = a.hour;
+        t.tm_min = a.minute;
+        t.tm_isdst = -1;
+        time_t when = mktime(&t);
+        return (when != (time_t)-1 && when >= from) ? when : 0;
+    }
+
+    struct tm base;
+    if (localtime_r(&from, &base) == NULL) return 0;
+    // 8 days so today's slot that already passed is found again next week
+    for (int i = 0; i <= 7; ++i) {
+        int day = (base.tm_wday + i) % 7;
+        if (!(a.days & (1u << day))) continue;
+
+        struct tm t = base;
+        t.tm_mday += i;
+        t.tm_hour = a.hour;
+        t.tm_min = a.minute;
+        t.tm_sec = 0;
+        t.tm_isdst = -1;
+        time_t when = mktime(&t);
+        if (when != (time_t)-1 && when >= from) return when;
+    }
+    return 0;
+}
+
+// Earliest fire time the queue may contain: start of the current minute, unless
+// an alarm already fired in it.
+static time_t schedule_start(time_t now) {
+    time_t from = now - (now % 60);
+    time_t last_fired;
+    portENTER_CRITICAL(&s_alarm_mux);
+    last_fired = s_last_fired_epoch;
+    portEXIT_CRITICAL(&s_alarm_mux);
+    if (last_fired >= from && last_fired <= now) from = last_fired + 60;
+    return from;
+}
+
+static void schedule_slot_locked(AlarmSlot &slot, time_t from) {
+    if (slot.next != 0) {
+        s_alarm_queue.erase(std::make_pair(slot.next, slot.cfg.id));
+    }
+    slot.next = compute_next_fire(slot.cfg, from);
+    if (slot.next != 0) {
+        s_alarm_queue.emplace(slot.next, slot.cfg.id);
+    }
+}
+
+static void publish_next_alarm_locked() {
+    time_t next = s_alarm_queue.empty() ? 0 : s_alarm_queue.begin()->first;
+    portENTER_CRITICAL(&s_alarm_mux);
+    s_next_alarm_epoch = next;
+    portEXIT_CRITICAL(&s_alarm_mux);
+}
+
+// Full rebuild, only needed when the timezone or wall clock changed.
+static void rebuild_alarm_queue_locked(time_t now) {
+    uint32_t gen;
+    portENTER_CRITICAL(&s_alarm_mux);
+    gen = s_alarm_gen;
+    portEXIT_CRITICAL(&s_alarm_mux);
+
+    s_alarm_queue.clear();
+    time_t from = schedule_start(now);
+    for (auto &kv : s_alarms) {
+        kv.second.next = 0;
+        if (now >= kMinValidEpoch) schedule_slot_locked(kv.second, from);
+    }
+    publish_next_alarm_locked();
+
+    portENTER_CRITICAL(&s_alarm_mux);
+    s_next_alarm_gen = gen;
+    portEXIT_CRITICAL(&s_alarm_mux);
+}
+
+// Re-queues a single edited alarm: O(log n)
+static void reschedule_alarm_locked(uint16_t id) {
+    auto it = s_alarms.find(id);
+    if (it == s_alarms.end()) return;
+    time_t now = time(NULL);
+    if (now < kMinValidEpoch) return; // Queue is built once the clock is valid
+    schedule_slot_locked(it->second, schedule_start(now));
+}
+
+static void remove_alarm_locked(uint16_t id) {
+    auto it = s_alarms.find(id);
+    if (it == s_alarms.end()) return;
+    if (it->second.next != 0) {
+        s_alarm_queue.erase(std::make_pair(it->second.next, id));
+    }
+    s_alarms.erase(it);
+}
+
+static void invalidate_next_alarm() {
+    portENTER_CRITICAL(&s_alarm_mux);
+    s_alarm_gen++;
+    portEXIT_CRITICAL(&s_alarm_mux);
+}
+
+static bool alarm_queue_stale() {
+    bool stale;
+    portENTER_CRITICAL(&s_alarm_mux);
+    stale = (s_next_alarm_gen != s_alarm_gen);
+    portEXIT_CRITICAL(&s_alarm_mux);
+    return stale;
+}
+
+static void ensure_alarm_queue_fresh(time_t now) {
+    if (!s_alarms_loaded || alarm_queue_stale()) {
+        alarm_lock_take();
+        ensure_alarms_loaded_locked();
+        if (alarm_queue_stale()) rebuild_alarm_queue_locked(now);
+        alarm_lock_give();
+    }
+}
+
+// --- Public API ---
+
+esp_err_t TimeManager::setSchedule(const WeekSchedule &schedule) {
+    for (int i = 0; i < 7; ++i) {
+        const DayAlarm &d = schedule.days[i];
+        if (!alarm_time_valid(d.hour, d.minute)) {
+            ESP_LOGE(TAG, "Rejecting alarm schedule: day %d has invalid time %d:%d", i, d.hour, d.minute);
+            return ESP_ERR_INVALID_ARG;
+        }
+    }
+
+    alarm_lock_take();
+    ensure_alarms_loaded_locked();
+
+    StoredAlarm previous[7];
+    for (int i = 0; i < 7; ++i) {
+        previous[i] = s_alarms[i].cfg;
+        const DayAlarm &d = schedule.days[i];
+        StoredAlarm &a = s_alarms[i].cfg;
+        a.hour = (int8_t)d.hour;
+        a.minute = (int8_t)d.minute;
+        a.active = d.active;
+        a.volumeRamp = d.volumeRamp;
+        a.useRandomMsg = d.useRandomMsg;
+        set_ringtone(&a, d.ringtone.c_str());
+    }
+
+    esp_err_t err = save_alarms_locked();
+    if (err != ESP_OK) {
+        for (int i = 0; i < 7; ++i) s_alarms[i].cfg = previous[i];
+        alarm_lock_give();
+        return err;
+    }
+
+    for (int i = 0; i < 7; ++i) {
+        reschedule_alarm_locked(i);
+    }
+    publish_next_alarm_locked();
+    alarm_lock_give();
+
+    for (int i = 1; i <= 7; ++i) {
+        const DayAlarm &d = schedule.days[i % 7];
+        ESP_LOGI(TAG, "Alarm Day %d: %02d:%02d (Act:%d Rmp:%d Msg:%d) Tone: %s",
+                 i, d.hour, d.minute, d.active, d.volumeRamp, d.useRandomMsg, d.ringtone.c_str());
+    }
+    return ESP_OK;
+}
+
+WeekSchedule TimeManager::getSchedule() {
+    WeekSchedule schedule;
+    alarm_lock_take();
+    ensure_alarms_loaded_locked();
+    for (int i = 0; i < 7; ++i) {
+        schedule.days[i] = to_day_alarm(s_alarms[i].cfg);
     }
+    alarm_lock_give();
+    return schedule;
+}
+
+void TimeManager::setAlarm(int dayIndex, int hour, int minute, bool active, bool volumeRamp, bool useMsg, const char* ringtone) {
+    if (dayIndex < 0 || dayIndex > 6) return;
+
+    WeekSchedule schedule = getSchedule();
+    DayAlarm &d = schedule.days[dayIndex];
+    d.hour = hour;
+    d.minute = minute;
+    d.active = active;
+    d.volumeRamp = volumeRamp;
+    d.useRandomMsg = useMsg;
+    d.ringtone = (ringtone && strlen(ringtone) > 0) ? ringtone : APP_DEFAULT_TIMER_RINGTONE;
+    setSchedule(schedule);
 }
 
 DayAlarm TimeManager::getAlarm(int dayIndex) {
     DayAlarm alarm = {7, 0, false, false, false, APP_DEFAULT_TIMER_RINGTONE}; // Default
     if (dayIndex < 0 || dayIndex > 6) return alarm;
 
-    nvs_handle_t my_handle;
-    if (nvs_open("dialcharm", NVS_READONLY, &my_handle) == ESP_OK) {
-        char key_h[16], key_m[16], key_en[16], key_rmp[16], key_msg[16], key_snd[16];
-        snprintf(key_h, sizeof(key_h), "alm_%d_h", dayIndex);
-        snprintf(key_m, sizeof(key_m), "alm_%d_m", dayIndex);
-        snprintf(key_en, sizeof(key_en), "alm_%d_en", dayIndex);
-        snprintf(key_rmp, sizeof(key_rmp), "alm_%d_rmp", dayIndex);
-        snprintf(key_msg, sizeof(key_msg), "alm_%d_msg", dayIndex);
-        snprintf(key_snd, sizeof(key_snd), "alm_%d_snd", dayIndex);
-
-        int32_t val_i32;
-        uint8_t val_u8;
-        size_t len;
-        char buf[64];
-
-        if (nvs_get_i32(my_handle, key_h, &val_i32) == ESP_OK) alarm.hour = val_i32;
-        if (nvs_get_i32(my_handle, key_m, &val_i32) == ESP_OK) alarm.minute = val_i32;
-        if (nvs_get_u8(my_handle, key_en, &val_u8) == ESP_OK) alarm.active = (val_u8 == 1);
-        if (nvs_get_u8(my_handle, key_rmp, &val_u8) == ESP_OK) alarm.volumeRamp = (val_u8 == 1);
-        if (nvs_get_u8(my_handle, key_msg, &val_u8) == ESP_OK) alarm.useRandomMsg = (val_u8 == 1);
-
-        len = sizeof(buf);
-        if (nvs_get_str(my_handle, key_snd, buf, &len) == ESP_OK && len > 0) {
-            alarm.ringtone = buf;
+    alarm_lock_take();
+    ensure_alarms_loaded_locked();
+    alarm = to_day_alarm(s_alarms[dayIndex].cfg);
+    alarm_lock_give();
+    return alarm;
+}
+
+std::vector<AlarmEntry> TimeManager::getExtraAlarms() {
+    std::vector<AlarmEntry> out;
+    alarm_lock_take();
+    ensure_alarms_loaded_locked();
+    for (const auto &kv : s_alarms) {
+        if (kv.first >= kFirstExtraAlarmId) out.push_back(to_alarm_entry(kv.second.cfg));
+    }
+    alarm_lock_give();
+    return out;
+}
+
+esp_err_t TimeManager::setExtraAlarms(const std::vector<AlarmEntry> &alarms) {
+    if (alarms.size() > APP_ALARM_MAX_EXTRA) {
+        ESP_LOGE(TAG, "Rejecting %u extra alarms (max %d)", (unsigned)alarms.size(), APP_ALARM_MAX_EXTRA);
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    std::vector<StoredAlarm> incoming;
+    incoming.reserve(alarms.size());
+    uint16_t next_id = kFirstExtraAlarmId;
+    for (const AlarmEntry &e : alarms) {
+        bool one_shot = (e.days & 0x7F) == 0;
+        if (!alarm_time_valid(e.hour, e.minute) || (one_shot && !alarm_date_valid(e.year, e.month, e.mday))) {
+            ESP_LOGE(TAG, "Rejecting extra alarm %02d:%02d (days=0x%02x date=%04d-%02d-%02d)",
+                     e.hour, e.minute, e.days, e.year, e.month, e.mday);
+            return ESP_ERR_INVALID_ARG;
+        }
+        StoredAlarm a;
+        memset(&a, 0, sizeof(a));
+        a.id = next_id++;
+        a.days = e.days & 0x7F;
+        a.hour = (int8_t)e.hour;
+        a.minute = (int8_t)e.minute;
+        if (one_shot) {
+            a.year = (uint16_t)e.year;
+            a.month = (uint8_t)e.month;
+            a.mday = (uint8_t)e.mday;
         }
+        a.active = e.active;
+        a.volumeRamp = e.volumeRamp;
+        a.useRandomMsg = e.useRandomMsg;
+        set_ringtone(&a, e.ringtone.c_str());
+        incoming.push_back(a);
+    }
 
-        nvs_close(my_handle);
+    alarm_lock_take();
+    ensure_alarms_loaded_locked();
+
+    std::vector<StoredAlarm> previous;
+    for (auto it = s_alarms.lower_bound(kFirstExtraAlarmId); it != s_alarms.end();) {
+        previous.push_back(it->second.cfg);
+        uint16_t id = (it++)->first;
+        remove_alarm_locked(id);
+    }
+    for (const StoredAlarm &a : incoming) {
+        insert_alarm_locked(a);
+    }
+
+    esp_err_t err = save_alarms_locked();
+    if (err != ESP_OK) {
+        for (const StoredAlarm &a : incoming) remove_alarm_locked(a.id);
+        for (const StoredAlarm &a : previous) insert_alarm_locked(a);
     }
+    for (auto it = s_alarms.lower_bound(kFirstExtraAlarmId); it != s_alarms.end(); ++it) {
+        reschedule_alarm_locked(it->first);
+    }
+    publish_next_alarm_locked();
+    alarm_lock_give();
+
+    if (err == ESP_OK) {
+        ESP_LOGI(TAG, "Extra alarms saved: %u", (unsigned)incoming.size());
+    }
+    return err;
+}
+
+bool TimeManager::getNextAlarm(time_t *out_epoch, DayAlarm *out_alarm) {
+    time_t now = time(NULL);
+    if (now < kMinValidEpoch) return false;
+
+    ensure_alarm_queue_fresh(now);
+
+    bool found = false;
+    alarm_lock_take();
+    if (!s_alarm_queue.empty()) {
+        const auto &front = *s_alarm_queue.begin();
+        if (out_epoch) *out_epoch = front.first;
+        if (out_alarm) *out_alarm = to_day_alarm(s_alarms[front.second].cfg);
+        found = true;
+    }
+    alarm_lock_give();
+    return found;
+}
+
+DayAlarm TimeManager::getRingingAlarm() {
+    alarm_lock_take();
+    DayAlarm alarm = to_day_alarm(s_ringing_alarm);
+    alarm_lock_give();
     return alarm;
 }
 
+static void invalidate_local_time_cache() {
+    s_time_cache_gen.fetch_add(1, std::memory_order_release);
+}
+
+#if APP_TIME_DIAG_LOG
+static void time_cache_diag(bool hit, int64_t miss_us) {
+    if (hit) {
+        s_time_cache_hits.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        s_time_cache_misses.fetch_add(1, std::memory_order_relaxed);
+        s_time_cache_miss_us.fetch_add((uint32_t)miss_us, std::memory_order_relaxed);
+    }
+
+    int64_t now_us = esp_timer_get_time();
+    int64_t last_us = s_time_cache_last_log_us.load(std::memory_order_relaxed);
+    if (now_us - last_us < (int64_t)APP_TIME_DIAG_INTERVAL_MS * 1000) return;
+    if (!s_time_cache_last_log_us.compare_exchange_strong(last_us, now_us)) return;
+
+    uint32_t hits = s_time_cache_hits.exchange(0);
+    uint32_t misses = s_time_cache_misses.exchange(0);
+    uint32_t total_miss_us = s_time_cache_miss_us.exchange(0);
+    ESP_LOGI(TAG, "Local time cache: %u hits, %u localtime_r calls (avg %u us each)",
+             (unsigned)hits, (unsigned)misses, misses ? (unsigned)(total_miss_us / misses) : 0);
+}
+#endif
+
 struct tm TimeManager::getCurrentTime() {
     time_t now;
     struct tm timeinfo;
     time(&now);
+
+    uint32_t gen = s_time_cache_gen.load(std::memory_order_acquire);
+    if (s_time_cache.read(now, gen, &timeinfo)) {
+#if APP_TIME_DIAG_LOG
+        time_cache_diag(true, 0);
+#endif
+        return timeinfo;
+    }
+
+#if APP_TIME_DIAG_LOG
+    int64_t start_us = esp_timer_get_time();
+#endif
     localtime_r(&now, &timeinfo);
+    s_time_cache.publish(now, gen, timeinfo);
+#if APP_TIME_DIAG_LOG
+    time_cache_diag(false, esp_timer_get_time() - start_us);
+#endif
     return timeinfo;
 }
 
@@ -400,29 +1068,77 @@ struct tm TimeManager::getCurrentTimeRtc() {
 bool TimeManager::checkAlarm() {
     if (_alarm_ringing) return false; // Already ringing
 
-    struct tm now = getCurrentTime();
-    if (now.tm_year < 120) return false; // Time not set yet (before 2020)
-
-    // Check against today's alarm
-    int today = now.tm_wday; // 0=Sun
-    DayAlarm alm = getAlarm(today);
-
-    if (!alm.active) return false;
-
-    // Check matching time
-    if (now.tm_hour == alm.hour && now.tm_min == alm.minute) {
-        // Debounce per exact minute slot (year/day/hour/minute), not per full day.
-        // This allows changing alarms during the same day without requiring reboot.
-        int64_t trigger_key = (((int64_t)now.tm_year * 366 + now.tm_yday) * 1440) + (now.tm_hour * 60 + now.tm_min);
-        if (_last_triggered_key != trigger_key) {
-            int logDay = (today == 0) ? 7 : today;
-            ESP_LOGI(TAG, "ALARM TRIGGERED for Day %d at %02d:%02d", logDay, now.tm_hour, now.tm_min);
-            _alarm_ringing = true;
-            _last_triggered_key = trigger_key;
-            return true;
+    time_t now = time(NULL);
+    if (now < kMinValidEpoch) return false; // Time not set yet (before 2020)
+
+    // RTC load, SNTP step or manual clock change: deadline must be recomputed
+    if (now < s_last_check_epoch || (now - s_last_check_epoch) > kClockStepThresholdSec) {
+        invalidate_next_alarm();
+    }
+    s_last_check_epoch = now;
+
+    ensure_alarm_queue_fresh(now);
+
+    time_t next_epoch;
+    portENTER_CRITICAL(&s_alarm_mux);
+    next_epoch = s_next_alarm_epoch;
+    portEXIT_CRITICAL(&s_alarm_mux);
+    if (next_epoch == 0 || now < next_epoch) return false;
+
+    // Due: pop every alarm whose slot has started. The first one still inside its
+    // minute rings; others in the same minute are coalesced, missed ones skipped.
+    bool fired = false;
+    bool persist = false;
+    StoredAlarm fired_cfg;
+    time_t fired_at = 0;
+
+    alarm_lock_take();
+    while (!s_alarm_queue.empty() && s_alarm_queue.begin()->first <= now) {
+        time_t when = s_alarm_queue.begin()->first;
+        uint16_t id = s_alarm_queue.begin()->second;
+        s_alarm_queue.erase(s_alarm_queue.begin());
+
+        AlarmSlot &slot = s_alarms[id];
+        slot.next = 0;
+        bool missed = now >= when + 60;
+        if (!missed && !fired) {
+            fired = true;
+            fired_cfg = slot.cfg;
+            fired_at = when;
+        } else if (!missed) {
+            ESP_LOGI(TAG, "Alarm %u coalesced with alarm %u", (unsigned)id, (unsigned)fired_cfg.id);
+        }
+
+        if (slot.cfg.days == 0) {
+            slot.cfg.active = false; // One-shot alarms are consumed when due
+            persist = true;
+        } else {
+            schedule_slot_locked(slot, when + 60);
         }
     }
-    return false;
+    if (fired) {
+        s_ringing_alarm = fired_cfg;
+        portENTER_CRITICAL(&s_alarm_mux);
+        s_last_fired_epoch = fired_at;
+        portEXIT_CRITICAL(&s_alarm_mux);
+    }
+    if (persist) save_alarms_locked();
+    publish_next_alarm_locked();
+    alarm_lock_give();
+
+    if (!fired) return false;
+
+    struct tm fire_tm;
+    localtime_r(&fired_at, &fire_tm);
+    if (fired_cfg.id < kFirstExtraAlarmId) {
+        int logDay = (fired_cfg.id == 0) ? 7 : fired_cfg.id;
+        ESP_LOGI(TAG, "ALARM TRIGGERED for Day %d at %02d:%02d", logDay, fire_tm.tm_hour, fire_tm.tm_min);
+    } else {
+        ESP_LOGI(TAG, "ALARM TRIGGERED (alarm %u%s) at %02d:%02d", (unsigned)fired_cfg.id,
+                 fired_cfg.days == 0 ? ", one-shot" : "", fire_tm.tm_hour, fire_tm.tm_min);
+    }
+    _alarm_ringing = true;
+    return true;
 }
 
 bool TimeManager::isAlarmRinging() { 
@@ -10,12 +10,18 @@
 #include <strings.h>
 #include <sys/stat.h>
 #include <unistd.h>
+#include <new>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
 #include "esp_wifi.h"
 #include "esp_event.h"
 #include "esp_log.h"
 #include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include "esp_rom_crc.h"
+#include "esp_cpu.h"
 #include "app_config.h"
 #include "AppSharedUtils.h"
 #include <sys/stat.h>
@@ -26,6 +32,12 @@
 #include "lwip/apps/netbiosns.h"
 #include "app_config.h"
 #include "PhonebookManager.h"
+#include "RotaryDial.h"
+#include "JsonWriter.h"
+#include "CjsonArena.h"
+#include "StateVersion.h"
+#include "LogRing.h"
+#include "OtaInflate.h"
 #include "cJSON.h"
 #include "lwip/sockets.h"
 #include "esp_ota_ops.h"
@@ -37,6 +49,8 @@
 extern void play_file(const char* path);
 // External reference to safe_reboot from main.cpp
 extern void safe_reboot();
+// External reference to the dial from main.cpp (input trace export)
+extern RotaryDial dial;
 
 static const char *TAG = "WEB_MANAGER";
 WebManager webManager;
@@ -57,8 +71,20 @@ static const size_t LOG_LINE_MAX = 256;
 static char s_log_lines[LOG_LINE_COUNT][LOG_LINE_MAX];
 static size_t s_log_head = 0;
 static size_t s_log_count = 0;
+static uint32_t s_log_seq = 0; // Lines added since boot, for the event stream
+#if APP_WEB_SSE_DIAG_LOG
+static uint32_t s_poll_requests = 0; // /api/logs + /api/time, replaced by /api/events
+#endif
 static portMUX_TYPE s_log_mux = portMUX_INITIALIZER_UNLOCKED;
 static vprintf_like_t s_prev_vprintf = nullptr;
+// Captured lines wait here until log_drain_task strips, stamps and stores them
+static LogRing<APP_LOG_RING_BYTES> s_log_ring;
+static TaskHandle_t s_log_drain_task = nullptr;
+#if APP_LOG_CYCLES_DIAG_LOG
+static uint32_t s_log_cycle_calls = 0;
+static uint32_t s_log_cycle_sum = 0;
+static uint32_t s_log_cycle_max = 0;
+#endif
 static bool s_runtime_logging_enabled = true;
 
 // WiFi / AP Logic
@@ -161,9 +187,116 @@ static void mdns_reannounce_task(void *pvParameters) {
     }
 }
 
+// --- WiFi scan cache ---
+// Scans run asynchronously; WIFI_EVENT_SCAN_DONE copies the results here (event
+// task) and /api/wifi/scan only reads the cache, so the httpd task never blocks.
+struct WifiScanEntry {
+    char ssid[33];
+    int8_t rssi;
+    uint8_t auth;
+};
+
+static WifiScanEntry s_scan_list[APP_WIFI_SCAN_MAX_RESULTS];
+static size_t s_scan_count = 0;
+static int64_t s_scan_done_ms = 0; // 0 = no results yet
+static int64_t s_scan_started_ms = 0;
+static bool s_scan_running = false;
+static portMUX_TYPE s_scan_mux = portMUX_INITIALIZER_UNLOCKED;
+
+static esp_err_t wifi_scan_start_async() {
+    wifi_scan_config_t scan_config = {
+        .ssid = NULL,
+        .bssid = NULL,
+        .channel = 0,
+        .show_hidden = true,
+        .scan_type = WIFI_SCAN_TYPE_ACTIVE,
+        .scan_time = {
+            .active = { .min = 100, .max = 300 },
+            .passive = 100
+        },
+        .home_chan_dwell_time = 0,
+        .channel_bitmap = { .ghz_2_channels = 0, .ghz_5_channels = 0 },
+        .coex_background_scan = false
+    };
+
+    // Marked before starting: SCAN_DONE may arrive before esp_wifi_scan_start returns
+    portENTER_CRITICAL(&s_scan_mux);
+    s_scan_running = true;
+    s_scan_started_ms = esp_timer_get_time() / 1000;
+    portEXIT_CRITICAL(&s_scan_mux);
+
+    // Note: In strict AP mode, scan might not work on all ESP32 revisions without APSTA.
+    esp_err_t err = esp_wifi_scan_start(&scan_config, false);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "WiFi Scan failed: %s", esp_err_to_name(err));
+        portENTER_CRITICAL(&s_scan_mux);
+        s_scan_running = false;
+        portEXIT_CRITICAL(&s_scan_mux);
+    }
+    return err;
+}
+
+// WIFI_EVENT_SCAN_DONE: keep the strongest entry per SSID, strongest first
+static void wifi_scan_collect() {
+    uint16_t ap_count = 0;
+    esp_wifi_scan_get_ap_num(&ap_count);
+    if (ap_count > APP_WIFI_SCAN_MAX_RESULTS * 2) ap_count = APP_WIFI_SCAN_MAX_RESULTS * 2;
+
+    wifi_ap_record_t *ap_list = ap_count ? (wifi_ap_record_t *)malloc(sizeof(wifi_ap_record_t) * ap_count) : nullptr;
+    if (ap_list) {
+        esp_wifi_scan_get_ap_records(&ap_count, ap_list);
+    } else {
+        ap_count = 0;
+    }
+    esp_wifi_clear_ap_list(); // Release records beyond the ones fetched
+
+    WifiScanEntry found[APP_WIFI_SCAN_MAX_RESULTS];
+    size_t count = 0;
+    for (uint16_t i = 0; i < ap_count; ++i) {
+        const char *ssid = (const char *)ap_list[i].ssid;
+        if (ssid[0] == '\0') continue; // Hidden network
+
+        size_t pos = 0;
+        bool duplicate = false;
+        for (; pos < count; ++pos) {
+            if (strcmp(found[pos].ssid, ssid) == 0) {
+                duplicate = true;
+                break;
+            }
+        }
+        if (duplicate) {
+            if (ap_list[i].rssi <= found[pos].rssi) continue;
+            // Stronger BSS of a known SSID: drop the old entry and reinsert
+            memmove(&found[pos], &found[pos + 1], (count - pos - 1) * sizeof(found[0]));
+            count--;
+        }
+
+        pos = 0;
+        while (pos < count && found[pos].rssi >= ap_list[i].rssi) pos++;
+        if (pos >= APP_WIFI_SCAN_MAX_RESULTS) continue;
+        size_t tail = (count < APP_WIFI_SCAN_MAX_RESULTS ? count : APP_WIFI_SCAN_MAX_RESULTS - 1) - pos;
+        memmove(&found[pos + 1], &found[pos], tail * sizeof(found[0]));
+        snprintf(found[pos].ssid, sizeof(found[pos].ssid), "%s", ssid);
+        found[pos].rssi = ap_list[i].rssi;
+        found[pos].auth = (uint8_t)ap_list[i].authmode;
+        if (count < APP_WIFI_SCAN_MAX_RESULTS) count++;
+    }
+    free(ap_list);
+
+    portENTER_CRITICAL(&s_scan_mux);
+    memcpy(s_scan_list, found, count * sizeof(found[0]));
+    s_scan_count = count;
+    s_scan_done_ms = esp_timer_get_time() / 1000;
+    s_scan_running = false;
+    portEXIT_CRITICAL(&s_scan_mux);
+    ESP_LOGI(TAG, "WiFi scan done: %u networks", (unsigned)count);
+}
+
 static void wifi_event_handler(void* arg, esp_event_base_t event_base,
                                int32_t event_id, void* event_data) {
-    if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_START) {
+    if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_SCAN_DONE) {
+        wifi_scan_collect();
+    } else if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_START) {
         esp_wifi_connect();
     } else if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_DISCONNECTED) {
         if (s_ap_mode_active) return; // Retry is disabled after AP switch
@@ -188,13 +321,87 @@ static void wifi_event_handler(void* arg, esp_event_base_t event_base,
 }
 
 #if APP_ENABLE_SD_LOG
+// Owned by the flush task: others post requests and never touch the file
 static FILE *s_sd_log_file = nullptr;
 static TaskHandle_t s_sd_log_task = nullptr;
 static portMUX_TYPE s_sd_log_mux = portMUX_INITIALIZER_UNLOCKED;
-static char s_sd_log_buf[APP_SD_LOG_BUFFER_LINES][LOG_LINE_MAX];
-static char s_sd_log_flush_buf[APP_SD_LOG_BUFFER_LINES][LOG_LINE_MAX];
-static size_t s_sd_log_buf_count = 0;
+// Byte ring of finished lines ("...\n"). log_drain_task appends at head; the
+// flush task writes [tail, head) straight from the ring into the file.
+// Indices run freely and are masked on access.
+static char *s_sd_log_ring = nullptr;
+static size_t s_sd_log_ring_size = 0; // Power of two
+static size_t s_sd_log_head = 0;
+static size_t s_sd_log_tail = 0;
+static size_t s_sd_log_inflight = 0; // Bytes from tail the flush task is writing right now
+static uint32_t s_sd_log_dropped = 0;
+static int64_t s_sd_log_pending_since_ms = 0; // Oldest byte not yet written
+static size_t s_sd_log_size = 0; // Current file size, tracked instead of seeking
 static bool s_sd_log_enabled = true;
+enum : uint8_t { SD_LOG_REQ_CLOSE = 1, SD_LOG_REQ_CLEAR = 2 };
+static uint8_t s_sd_log_requests = 0; // Handled by the flush task between writes
+
+static bool sd_log_ensure_ring() {
+    if (s_sd_log_ring) {
+        return true;
+    }
+    size_t size = APP_SD_LOG_RING_BYTES;
+    char *ring = (char *)heap_caps_malloc(size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    bool psram = ring != nullptr;
+    if (!ring) {
+        size = 8192;
+        ring = (char *)heap_caps_malloc(size, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    }
+    if (!ring) {
+        return false;
+    }
+    s_sd_log_ring_size = size;
+    s_sd_log_ring = ring;
+    ESP_LOGI(TAG, "SD log ring: %u bytes (%s)", (unsigned)size, psram ? "PSRAM" : "internal");
+    return true;
+}
+
+// Drops everything not already being written
+static void sd_log_discard_pending() {
+    portENTER_CRITICAL(&s_sd_log_mux);
+    s_sd_log_head = s_sd_log_tail + s_sd_log_inflight;
+    portEXIT_CRITICAL(&s_sd_log_mux);
+}
+
+static void sd_log_remove_files() {
+    char backup_path[160];
+    snprintf(backup_path, sizeof(backup_path), "%s.1", APP_SD_LOG_PATH);
+    remove(APP_SD_LOG_PATH);
+    remove(backup_path);
+}
+
+// Close (and for a clear, delete) the log file once the current write is done
+static void sd_log_request(uint8_t request) {
+    if (!s_sd_log_task) { // The file is only ever opened by the flush task
+        if (request & SD_LOG_REQ_CLEAR) sd_log_remove_files();
+        return;
+    }
+    portENTER_CRITICAL(&s_sd_log_mux);
+    s_sd_log_requests |= request;
+    portEXIT_CRITICAL(&s_sd_log_mux);
+    xTaskNotifyGive(s_sd_log_task);
+}
+
+static void sd_log_handle_requests() {
+    portENTER_CRITICAL(&s_sd_log_mux);
+    uint8_t requests = s_sd_log_requests;
+    s_sd_log_requests = 0;
+    portEXIT_CRITICAL(&s_sd_log_mux);
+    if (!requests) {
+        return;
+    }
+    if (s_sd_log_file) {
+        fclose(s_sd_log_file);
+        s_sd_log_file = nullptr;
+    }
+    if (requests & SD_LOG_REQ_CLEAR) {
+        sd_log_remove_files();
+    }
+}
 
 static bool sd_log_open_file_if_needed() {
     if (s_sd_log_file) {
@@ -214,7 +421,13 @@ static bool sd_log_open_file_if_needed() {
     }
 
     s_sd_log_file = fopen(log_path, "a");
-    return s_sd_log_file != nullptr;
+    if (!s_sd_log_file) {
+        return false;
+    }
+    setvbuf(s_sd_log_file, NULL, _IONBF, 0); // Writes are already large blocks
+    struct stat st;
+    s_sd_log_size = (fstat(fileno(s_sd_log_file), &st) == 0) ? (size_t)st.st_size : 0;
+    return true;
 }
 
 static bool sd_log_rotate_file() {
@@ -229,40 +442,55 @@ static bool sd_log_rotate_file() {
     rename(APP_SD_LOG_PATH, backup_path);
 
     s_sd_log_file = fopen(APP_SD_LOG_PATH, "w");
-    return s_sd_log_file != nullptr;
-}
-
-static long sd_log_get_current_size() {
     if (!s_sd_log_file) {
-        return 0;
-    }
-    if (fseek(s_sd_log_file, 0, SEEK_END) != 0) {
-        return -1;
+        return false;
     }
-    return ftell(s_sd_log_file);
+    setvbuf(s_sd_log_file, NULL, _IONBF, 0);
+    s_sd_log_size = 0;
+    return true;
 }
 
+// Only log_drain_task appends, so the copy can run outside the lock: the
+// region past head is not visible to the flush task until head moves.
 static void sd_log_write_line(const char *line) {
-    if (!line || !line[0]) {
+    if (!line || !line[0] || !s_sd_log_ring) {
+        return;
+    }
+    size_t len = strnlen(line, LOG_LINE_MAX);
+    const size_t mask = s_sd_log_ring_size - 1;
+
+    portENTER_CRITICAL(&s_sd_log_mux);
+    size_t head = s_sd_log_head;
+    bool fits = (head - s_sd_log_tail) + len + 1 <= s_sd_log_ring_size;
+    if (!fits) s_sd_log_dropped++;
+    portEXIT_CRITICAL(&s_sd_log_mux);
+    if (!fits) {
         return;
     }
+
+    size_t off = head & mask;
+    size_t first = MIN(len, s_sd_log_ring_size - off);
+    memcpy(s_sd_log_ring + off, line, first);
+    memcpy(s_sd_log_ring, line + first, len - first);
+    s_sd_log_ring[(head + len) & mask] = '\n';
+
     portENTER_CRITICAL(&s_sd_log_mux);
-    if (s_sd_log_buf_count < APP_SD_LOG_BUFFER_LINES) {
-        strncpy(s_sd_log_buf[s_sd_log_buf_count], line, LOG_LINE_MAX - 1);
-        s_sd_log_buf[s_sd_log_buf_count][LOG_LINE_MAX - 1] = '\0';
-        s_sd_log_buf_count++;
+    if (s_sd_log_head == head) { // Not discarded meanwhile
+        if (s_sd_log_head == s_sd_log_tail) s_sd_log_pending_since_ms = esp_timer_get_time() / 1000;
+        s_sd_log_head = head + len + 1;
     }
     portEXIT_CRITICAL(&s_sd_log_mux);
 }
 
-static void sd_log_format_with_time(const char *line, char *dst, size_t dst_size) {
+// time_us is the esp_timer time of the log call, which may be a little in the past
+static void sd_log_format_with_time(const char *line, int64_t time_us, char *dst, size_t dst_size) {
     if (!line || !dst || dst_size == 0) {
         return;
     }
-    time_t now = time(NULL);
+    time_t now = time(NULL) - (time_t)((esp_timer_get_time() - time_us) / 1000000);
     struct tm now_tm;
     if (localtime_r(&now, &now_tm) == NULL || now_tm.tm_year < 120) {
-        snprintf(dst, dst_size, "[%lu] %s", (unsigned long)esp_log_timestamp(), line);
+        snprintf(dst, dst_size, "[%lu] %s", (unsigned long)(time_us / 1000), line);
         return;
     }
     char time_buf[32];
@@ -273,59 +501,71 @@ static void sd_log_format_with_time(const char *line, char *dst, size_t dst_size
     snprintf(dst, dst_size, "%s %s", time_buf, line);
 }
 
+// Writes ring data so the file ends on a cluster boundary; a shorter tail is
+// held back until a later flush completes the cluster or it gets too old.
 static void sd_log_flush_task(void *pvParameters) {
     (void)pvParameters;
     while (true) {
-        vTaskDelay(pdMS_TO_TICKS(APP_SD_LOG_FLUSH_INTERVAL_MS));
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(APP_SD_LOG_FLUSH_INTERVAL_MS)); // Early on a request
+        sd_log_handle_requests();
 
-        size_t count = 0;
         portENTER_CRITICAL(&s_sd_log_mux);
-        count = s_sd_log_buf_count;
-        for (size_t i = 0; i < count; ++i) {
-            strncpy(s_sd_log_flush_buf[i], s_sd_log_buf[i], LOG_LINE_MAX);
-            s_sd_log_flush_buf[i][LOG_LINE_MAX - 1] = '\0';
-        }
+        size_t tail = s_sd_log_tail;
+        size_t pending = s_sd_log_head - tail;
+        int64_t pending_since_ms = s_sd_log_pending_since_ms;
+        uint32_t dropped = s_sd_log_dropped;
+        s_sd_log_dropped = 0;
         portEXIT_CRITICAL(&s_sd_log_mux);
 
-        if (count == 0) {
+        if (dropped > 0) {
+            ESP_LOGW(TAG, "SD log ring full, %lu lines dropped", (unsigned long)dropped);
+        }
+        if (pending == 0 || !sd_log_open_file_if_needed()) {
             continue;
         }
 
-        if (!sd_log_open_file_if_needed()) {
-            continue;
+        if (s_sd_log_size + pending > APP_SD_LOG_MAX_BYTES) {
+            if (!sd_log_rotate_file()) {
+                continue;
+            }
         }
 
-        long size = sd_log_get_current_size();
-        if (size < 0) {
+        size_t n = pending;
+        size_t aligned_end = (s_sd_log_size + pending) & ~((size_t)APP_SD_LOG_WRITE_ALIGN - 1);
+        bool tail_due = (esp_timer_get_time() / 1000 - pending_since_ms) >= APP_SD_LOG_MAX_HOLD_MS;
+        if (aligned_end > s_sd_log_size && !tail_due) {
+            n = aligned_end - s_sd_log_size;
+        } else if (!tail_due) {
             continue;
         }
-        for (size_t i = 0; i < count; ++i) {
-            size_t line_len = strnlen(s_sd_log_flush_buf[i], LOG_LINE_MAX) + 1; // + newline
-            if (size >= (long)APP_SD_LOG_MAX_BYTES ||
-                (size + (long)line_len) > (long)APP_SD_LOG_MAX_BYTES) {
-                if (!sd_log_rotate_file()) {
-                    break;
-                }
-                size = 0;
-            }
-            fputs(s_sd_log_flush_buf[i], s_sd_log_file);
-            fputc('\n', s_sd_log_file);
-            size += (long)line_len;
+
+        portENTER_CRITICAL(&s_sd_log_mux);
+        s_sd_log_inflight = n;
+        portEXIT_CRITICAL(&s_sd_log_mux);
+
+        int64_t start_us = esp_timer_get_time();
+        size_t off = tail & (s_sd_log_ring_size - 1);
+        size_t first = MIN(n, s_sd_log_ring_size - off);
+        size_t written = fwrite(s_sd_log_ring + off, 1, first, s_sd_log_file);
+        if (written == first && n > first) {
+            written += fwrite(s_sd_log_ring, 1, n - first, s_sd_log_file);
         }
-        fflush(s_sd_log_file);
+        int64_t write_us = esp_timer_get_time();
         fsync(fileno(s_sd_log_file));
+        s_sd_log_size += written;
+#if APP_SD_LOG_DIAG_LOG
+        int64_t end_us = esp_timer_get_time();
+        ESP_LOGI(TAG, "SD log flush: %u bytes (file %u), write %lld ms, sync %lld ms", (unsigned)written,
+                 (unsigned)s_sd_log_size, (long long)(write_us - start_us) / 1000, (long long)(end_us - write_us) / 1000);
+#else
+        (void)start_us;
+        (void)write_us;
+#endif
 
         portENTER_CRITICAL(&s_sd_log_mux);
-        if (s_sd_log_buf_count >= count) {
-            size_t remaining = s_sd_log_buf_count - count;
-            for (size_t i = 0; i < remaining; ++i) {
-                strncpy(s_sd_log_buf[i], s_sd_log_buf[count + i], LOG_LINE_MAX);
-                s_sd_log_buf[i][LOG_LINE_MAX - 1] = '\0';
-            }
-            s_sd_log_buf_count = remaining;
-        } else {
-            s_sd_log_buf_count = 0;
-        }
+        s_sd_log_inflight = 0;
+        s_sd_log_tail = tail + n; // A failed write is dropped rather than retried forever
+        s_sd_log_pending_since_ms = esp_timer_get_time() / 1000; // Held-back tail waits from now on
         portEXIT_CRITICAL(&s_sd_log_mux);
     }
 }
@@ -333,16 +573,11 @@ static void sd_log_flush_task(void *pvParameters) {
 static void sd_log_set_enabled(bool enabled) {
     s_sd_log_enabled = enabled;
     if (!enabled) {
-        if (s_sd_log_file) {
-            fclose(s_sd_log_file);
-            s_sd_log_file = nullptr;
-        }
-        portENTER_CRITICAL(&s_sd_log_mux);
-        s_sd_log_buf_count = 0;
-        portEXIT_CRITICAL(&s_sd_log_mux);
+        sd_log_discard_pending();
+        sd_log_request(SD_LOG_REQ_CLOSE);
         return;
     }
-    if (!s_sd_log_task) {
+    if (sd_log_ensure_ring() && !s_sd_log_task) {
         xTaskCreate(sd_log_flush_task, "sd_log_flush", 4096, NULL, 2, &s_sd_log_task);
     }
 }
@@ -568,50 +803,114 @@ static void log_buffer_add(const char *line) {
     if (s_log_count < LOG_LINE_COUNT) {
         s_log_count++;
     }
+    s_log_seq++;
     portEXIT_CRITICAL(&s_log_mux);
 }
 
+// Runs on the calling task (audio elements included), so it only formats the
+// line and queues it; everything else happens in log_drain_task. The
+// arguments have to be formatted here: %s arguments, the tag among them,
+// point to memory that is gone once the call returns.
 static int log_vprintf(const char *fmt, va_list args) {
+    if (!s_runtime_logging_enabled) {
+        return 0;
+    }
+#if APP_LOG_CYCLES_DIAG_LOG
+    uint32_t cycles_start = esp_cpu_get_cycle_count();
+#endif
+
     char buf[LOG_LINE_MAX];
     va_list args_copy;
     va_copy(args_copy, args);
-    vsnprintf(buf, sizeof(buf), fmt, args_copy);
+    int written = vsnprintf(buf, sizeof(buf), fmt, args_copy);
     va_end(args_copy);
 
-    size_t len = strlen(buf);
+    size_t len = written < 0 ? 0 : MIN((size_t)written, sizeof(buf) - 1);
     while (len > 0 && (buf[len - 1] == '\n' || buf[len - 1] == '\r')) {
-        buf[len - 1] = '\0';
         len--;
     }
+    if (len > 0) {
+        s_log_ring.push(esp_timer_get_time(), buf, len);
+    }
 
-    if (!s_runtime_logging_enabled) {
-        return (int)len;
+#if APP_LOG_CYCLES_DIAG_LOG
+    uint32_t cycles = esp_cpu_get_cycle_count() - cycles_start;
+    portENTER_CRITICAL(&s_log_mux);
+    s_log_cycle_calls++;
+    s_log_cycle_sum += cycles;
+    if (cycles > s_log_cycle_max) s_log_cycle_max = cycles;
+    portEXIT_CRITICAL(&s_log_mux);
+#endif
+
+    if (s_prev_vprintf) {
+        return s_prev_vprintf(fmt, args);
     }
+    return vprintf(fmt, args);
+}
 
-    log_buffer_add(buf);
+static void log_drain_record(const LogRing<APP_LOG_RING_BYTES>::Record &rec) {
+    char line[LOG_LINE_MAX];
+    size_t len = MIN(rec.len, sizeof(line) - 1);
+    memcpy(line, rec.text, len);
+    line[len] = '\0';
+
+    log_buffer_add(line);
 
 #if APP_ENABLE_SD_LOG
     if (s_sd_log_enabled) {
         char clean[LOG_LINE_MAX];
         char stamped[LOG_LINE_MAX];
-        strip_ansi(buf, clean, sizeof(clean));
-        sd_log_format_with_time(clean, stamped, sizeof(stamped));
+        strip_ansi(line, clean, sizeof(clean));
+        sd_log_format_with_time(clean, rec.time_us, stamped, sizeof(stamped));
         sd_log_write_line(stamped);
     }
 #endif
+}
 
-    if (s_prev_vprintf) {
-        return s_prev_vprintf(fmt, args);
+static void log_drain_task(void *pvParameters) {
+    (void)pvParameters;
+#if APP_LOG_CYCLES_DIAG_LOG
+    int64_t last_report_ms = esp_timer_get_time() / 1000;
+#endif
+    while (true) {
+        vTaskDelay(pdMS_TO_TICKS(APP_LOG_DRAIN_MS));
+        s_log_ring.drain(log_drain_record);
+
+        uint32_t dropped = s_log_ring.takeDropped();
+        if (dropped > 0) {
+            ESP_LOGW(TAG, "Log ring full, %lu lines dropped", (unsigned long)dropped);
+        }
+
+#if APP_LOG_CYCLES_DIAG_LOG
+        int64_t now_ms = esp_timer_get_time() / 1000;
+        if (now_ms - last_report_ms >= 10000) {
+            last_report_ms = now_ms;
+            portENTER_CRITICAL(&s_log_mux);
+            uint32_t calls = s_log_cycle_calls;
+            uint32_t sum = s_log_cycle_sum;
+            uint32_t max = s_log_cycle_max;
+            s_log_cycle_calls = 0;
+            s_log_cycle_sum = 0;
+            s_log_cycle_max = 0;
+            portEXIT_CRITICAL(&s_log_mux);
+            if (calls > 0) {
+                ESP_LOGI(TAG, "Log capture: %lu calls, avg %lu cycles, max %lu cycles (excl. console)",
+                         (unsigned long)calls, (unsigned long)(sum / calls), (unsigned long)max);
+            }
+        }
+#endif
     }
-    return vprintf(fmt, args);
 }
 
 static void init_log_capture() {
+    if (!s_log_drain_task) {
+        xTaskCreate(log_drain_task, "log_drain", 4096, NULL, 2, &s_log_drain_task);
+    }
     if (!s_prev_vprintf) {
         s_prev_vprintf = esp_log_set_vprintf(log_vprintf);
     }
 #if APP_ENABLE_SD_LOG
-    if (s_runtime_logging_enabled && s_sd_log_enabled && !s_sd_log_task) {
+    if (s_runtime_logging_enabled && s_sd_log_enabled && sd_log_ensure_ring() && !s_sd_log_task) {
         xTaskCreate(sd_log_flush_task, "sd_log_flush", 4096, NULL, 2, &s_sd_log_task);
     }
 #endif
@@ -732,47 +1031,13 @@ static const char* get_mime_type(const char* path) {
     if (strcmp(ext, ".png") == 0) return "image/png";
     if (strcmp(ext, ".ico") == 0) return "image/x-icon";
     if (strcmp(ext, ".json") == 0) return "application/json";
+    if (strcasecmp(ext, ".wav") == 0) return "audio/wav";
+    if (strcasecmp(ext, ".mp3") == 0) return "audio/mpeg";
     return "text/plain";
 }
 
 // --- API HANDLERS ---
 
-static esp_err_t api_ringtones_handler(httpd_req_t *req) {
-    httpd_resp_set_type(req, "application/json");
-    cJSON *root = cJSON_CreateArray();
-    
-    DIR *dir = opendir("/sdcard/ringtones");
-    if (dir) {
-        struct dirent *ent;
-        while ((ent = readdir(dir)) != NULL) {
-            if (ent->d_type != DT_REG) {
-                continue;
-            }
-
-            const char *name = ent->d_name;
-            size_t len = strlen(name);
-            if (len < 4) {
-                continue;
-            }
-
-            const char *ext = name + len - 4;
-            if (strcasecmp(ext, ".wav") == 0) {
-                cJSON_AddItemToArray(root, cJSON_CreateString(name));
-            }
-        }
-        closedir(dir);
-    } else {
-        ESP_LOGW(TAG, "Ringtones folder not accessible: /sdcard/ringtones");
-    }
-    
-    const char *json_str = cJSON_PrintUnformatted(root);
-    esp_err_t send_err = httpd_resp_send(req, json_str, strlen(json_str));
-    note_http_error("api_ringtones_handler:send", send_err);
-    free((void*)json_str);
-    cJSON_Delete(root);
-    return send_err;
-}
-
 static esp_err_t api_preview_handler(httpd_req_t *req) {
     char buf[128];
     if (httpd_req_get_url_query_str(req, buf, sizeof(buf)) == ESP_OK) {
@@ -837,6 +1102,9 @@ static esp_err_t api_preview_handler(httpd_req_t *req) {
 }
 
 static esp_err_t api_logs_handler(httpd_req_t *req) {
+#if APP_WEB_SSE_DIAG_LOG
+    s_poll_requests++;
+#endif
     httpd_resp_set_type(req, "application/json");
 
     char lines[LOG_LINE_COUNT][LOG_LINE_MAX];
@@ -961,26 +1229,50 @@ static esp_err_t api_logs_clear_handler(httpd_req_t *req) {
 
 #if APP_ENABLE_SD_LOG
     // Clear buffered SD log lines and remove persisted log files.
-    portENTER_CRITICAL(&s_sd_log_mux);
-    s_sd_log_buf_count = 0;
-    portEXIT_CRITICAL(&s_sd_log_mux);
-
-    if (s_sd_log_file) {
-        fclose(s_sd_log_file);
-        s_sd_log_file = nullptr;
-    }
-
-    char backup_path[160];
-    snprintf(backup_path, sizeof(backup_path), "%s.1", APP_SD_LOG_PATH);
-    remove(APP_SD_LOG_PATH);
-    remove(backup_path);
+    sd_log_discard_pending();
+    sd_log_request(SD_LOG_REQ_CLEAR);
 #endif
 
     httpd_resp_set_type(req, "application/json");
     return httpd_resp_send(req, "{\"ok\":true}", HTTPD_RESP_USE_STRLEN);
 }
 
+// Raw dial/hook/button edges as CSV. Each row maps 1:1 onto
+// RotaryDial::feedEdge(source, level, time_us, mode_active) for offline replay.
+static esp_err_t api_input_trace_handler(httpd_req_t *req) {
+    size_t capacity = dial.traceCapacity();
+    RotaryDial::TraceEdge *edges = capacity ? (RotaryDial::TraceEdge *)malloc(capacity * sizeof(RotaryDial::TraceEdge)) : nullptr;
+    if (capacity && !edges) {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Out of memory");
+        return ESP_FAIL;
+    }
+    size_t count = dial.copyTrace(edges, capacity);
+
+    httpd_resp_set_type(req, "text/csv");
+    httpd_resp_set_hdr(req, "Content-Disposition", "attachment; filename=input_trace.csv");
+
+    char line[160];
+    int n = snprintf(line, sizeof(line),
+                     "# input trace v1, source 0=pulse 1=hook 2=button, edges=%u, overflows=%lu\n"
+                     "time_us,source,level,mode_active\n",
+                     (unsigned)count, (unsigned long)dial.edgeOverflows());
+    esp_err_t err = httpd_resp_send_chunk(req, line, n);
+    for (size_t i = 0; i < count && err == ESP_OK; ++i) {
+        n = snprintf(line, sizeof(line), "%lld,%u,%u,%u\n", (long long)edges[i].time_us,
+                     (unsigned)edges[i].source, (unsigned)edges[i].level, (unsigned)edges[i].mode_active);
+        err = httpd_resp_send_chunk(req, line, n);
+    }
+    free(edges);
+    note_http_error("api_input_trace_handler:chunk", err);
+    esp_err_t end_err = httpd_resp_send_chunk(req, NULL, 0);
+    note_http_error("api_input_trace_handler:end_chunk", end_err);
+    return err == ESP_OK ? end_err : ESP_FAIL;
+}
+
 static esp_err_t api_time_handler(httpd_req_t *req) {
+#if APP_WEB_SSE_DIAG_LOG
+    s_poll_requests++;
+#endif
     httpd_resp_set_type(req, "application/json");
     
     struct tm now = TimeManager::getCurrentTime();
@@ -998,6 +1290,230 @@ static esp_err_t api_time_handler(httpd_req_t *req) {
     return send_err;
 }
 
+// --- Pipelined OTA ---
+// api_ota_handler only validates the upload and then hands the request to
+// ota_receive_task (httpd async request), so the httpd task stays free for
+// /api/ota/status, the 409 check and everything else during an update.
+// The receive task fills a small pool of buffers while ota_writer_task
+// flashes filled ones, so flash erase/write overlaps the network receive.
+// The writer also hashes the image (SHA-256) on the fly and inflates gzip
+// uploads (detected by their magic bytes) before they reach the flash.
+enum OtaState : uint8_t { OTA_IDLE = 0, OTA_RECEIVING, OTA_FINISHING, OTA_DONE, OTA_FAILED };
+
+struct OtaStatus {
+    OtaState state;
+    size_t total;
+    size_t received;
+    size_t consumed; // Upload bytes processed by the writer
+    size_t written;  // Image bytes flashed (more than consumed for gzip uploads)
+    bool compressed;
+    int64_t start_ms;
+    int64_t end_ms;
+    char sha256[65];
+    char error[48];
+};
+
+struct OtaChunk {
+    uint8_t *data;
+    size_t len; // 0 = end of image
+};
+
+static OtaStatus s_ota_status = {};
+static portMUX_TYPE s_ota_mux = portMUX_INITIALIZER_UNLOCKED;
+
+// State shared with ota_receive_task and ota_writer_task for one update
+struct OtaPipeline {
+    httpd_req_t *req; // Async copy, completed by ota_receive_task
+    const esp_partition_t *partition;
+    esp_ota_handle_t handle;
+    uint8_t *pool;
+    size_t buf_size;
+    QueueHandle_t filled;
+    QueueHandle_t free_bufs;
+    SemaphoreHandle_t done;
+    volatile esp_err_t write_err;
+    mbedtls_sha256_context sha;
+    bool started;
+    GzipInflater *inflater; // Only for gzip uploads
+    char expected_sha[65]; // Optional X-OTA-SHA256, empty if not sent
+};
+
+static void ota_set_state(OtaState state, const char *error) {
+    portENTER_CRITICAL(&s_ota_mux);
+    s_ota_status.state = state;
+    if (error) snprintf(s_ota_status.error, sizeof(s_ota_status.error), "%s", error);
+    if (state == OTA_DONE || state == OTA_FAILED) s_ota_status.end_ms = esp_timer_get_time() / 1000;
+    portEXIT_CRITICAL(&s_ota_mux);
+}
+
+static void ota_pipeline_free(OtaPipeline *p) {
+    if (!p) return;
+    if (p->filled) vQueueDelete(p->filled);
+    if (p->free_bufs) vQueueDelete(p->free_bufs);
+    if (p->done) vSemaphoreDelete(p->done);
+    mbedtls_sha256_free(&p->sha);
+    free(p->pool);
+    free(p);
+}
+
+// Flashes one block of the uncompressed image
+static esp_err_t ota_flash_sink(void *ctx, const uint8_t *data, size_t len) {
+    OtaPipeline *p = static_cast<OtaPipeline *>(ctx);
+    esp_err_t err = esp_ota_write(p->handle, data, len);
+    if (err != ESP_OK) return err;
+    mbedtls_sha256_update(&p->sha, data, len);
+    portENTER_CRITICAL(&s_ota_mux);
+    s_ota_status.written += len;
+    portEXIT_CRITICAL(&s_ota_mux);
+    return ESP_OK;
+}
+
+static esp_err_t ota_write_chunk(OtaPipeline *p, const uint8_t *data, size_t len) {
+    if (!p->started) {
+        p->started = true;
+        if (GzipInflater::isGzip(data, len)) {
+            p->inflater = new (std::nothrow) GzipInflater();
+            esp_err_t err = p->inflater ? p->inflater->begin(ota_flash_sink, p) : ESP_ERR_NO_MEM;
+            if (err != ESP_OK) return err;
+            portENTER_CRITICAL(&s_ota_mux);
+            s_ota_status.compressed = true;
+            portEXIT_CRITICAL(&s_ota_mux);
+            ESP_LOGI(TAG, "OTA upload is gzip compressed");
+        }
+    }
+    esp_err_t err = p->inflater ? p->inflater->feed(data, len) : ota_flash_sink(p, data, len);
+    portENTER_CRITICAL(&s_ota_mux);
+    s_ota_status.consumed += len;
+    portEXIT_CRITICAL(&s_ota_mux);
+    return err;
+}
+
+static void ota_writer_task(void *arg) {
+    OtaPipeline *p = static_cast<OtaPipeline *>(arg);
+    OtaChunk chunk;
+    while (xQueueReceive(p->filled, &chunk, portMAX_DELAY) == pdTRUE && chunk.len > 0) {
+        if (p->write_err == ESP_OK) {
+            esp_err_t err = ota_write_chunk(p, chunk.data, chunk.len);
+            if (err != ESP_OK) {
+                p->write_err = err; // Keep draining so the receiver never blocks
+            }
+        }
+        xQueueSend(p->free_bufs, &chunk.data, portMAX_DELAY);
+    }
+    if (p->inflater) {
+        if (p->write_err == ESP_OK) p->write_err = p->inflater->finish(); // Truncated stream
+        delete p->inflater;
+        p->inflater = nullptr;
+    }
+    xSemaphoreGive(p->done);
+    vTaskDelete(NULL);
+}
+
+static esp_err_t ota_send_error(httpd_req_t *req, const char *status, const char *msg) {
+    ota_set_state(OTA_FAILED, msg);
+    httpd_resp_set_status(req, status);
+    httpd_resp_send(req, msg, HTTPD_RESP_USE_STRLEN);
+    return ESP_FAIL;
+}
+
+// Receives the body, waits for the writer and switches the boot partition
+static esp_err_t ota_receive(OtaPipeline *p) {
+    httpd_req_t *req = p->req;
+
+    // Fill a whole buffer before handing it over so flash writes stay large
+    size_t remaining = req->content_len;
+    bool recv_failed = false;
+    while (remaining > 0 && p->write_err == ESP_OK) {
+        uint8_t *buf = nullptr;
+        xQueueReceive(p->free_bufs, &buf, portMAX_DELAY);
+        size_t fill = 0;
+        while (fill < p->buf_size && remaining > 0) {
+            size_t want = p->buf_size - fill < remaining ? p->buf_size - fill : remaining;
+            int recv_len = httpd_req_recv(req, (char *)buf + fill, want);
+            if (recv_len == HTTPD_SOCK_ERR_TIMEOUT) {
+                continue;
+            }
+            if (recv_len <= 0) {
+                recv_failed = true;
+                break;
+            }
+            fill += recv_len;
+            remaining -= recv_len;
+        }
+        portENTER_CRITICAL(&s_ota_mux);
+        s_ota_status.received += fill;
+        portEXIT_CRITICAL(&s_ota_mux);
+        if (recv_failed) {
+            xQueueSend(p->free_bufs, &buf, 0);
+            break;
+        }
+        OtaChunk chunk = {buf, fill};
+        xQueueSend(p->filled, &chunk, portMAX_DELAY);
+    }
+
+    // Stop the writer and wait until it has flashed everything queued
+    ota_set_state(OTA_FINISHING, nullptr);
+    OtaChunk end = {nullptr, 0};
+    xQueueSend(p->filled, &end, portMAX_DELAY);
+    xSemaphoreTake(p->done, portMAX_DELAY);
+
+    uint8_t digest[32];
+    mbedtls_sha256_finish(&p->sha, digest);
+    char sha_hex[65];
+    for (int i = 0; i < 32; ++i) snprintf(sha_hex + i * 2, 3, "%02x", digest[i]);
+    portENTER_CRITICAL(&s_ota_mux);
+    memcpy(s_ota_status.sha256, sha_hex, sizeof(sha_hex));
+    portEXIT_CRITICAL(&s_ota_mux);
+
+    if (recv_failed) {
+        esp_ota_abort(p->handle);
+        return ota_send_error(req, "500 Internal Server Error", "OTA receive failed");
+    }
+    if (p->write_err != ESP_OK) {
+        esp_ota_abort(p->handle);
+        OTA_LOGE("OTA write failed: %s", esp_err_to_name(p->write_err));
+        return ota_send_error(req, "500 Internal Server Error", esp_err_to_name(p->write_err));
+    }
+    if (p->expected_sha[0] && strcasecmp(p->expected_sha, sha_hex) != 0) {
+        esp_ota_abort(p->handle);
+        OTA_LOGE("OTA SHA-256 mismatch: got %s", sha_hex);
+        return ota_send_error(req, "400 Bad Request", "SHA-256 mismatch");
+    }
+
+    esp_err_t err = esp_ota_end(p->handle);
+    if (err != ESP_OK) {
+        OTA_LOGE("OTA end failed: %s", esp_err_to_name(err));
+        return ota_send_error(req, "500 Internal Server Error", esp_err_to_name(err));
+    }
+
+    err = esp_ota_set_boot_partition(p->partition);
+    if (err != ESP_OK) {
+        OTA_LOGE("OTA set boot failed: %s", esp_err_to_name(err));
+        return ota_send_error(req, "500 Internal Server Error", esp_err_to_name(err));
+    }
+
+    ota_set_state(OTA_DONE, nullptr);
+    portENTER_CRITICAL(&s_ota_mux);
+    int64_t elapsed_ms = s_ota_status.end_ms - s_ota_status.start_ms;
+    portEXIT_CRITICAL(&s_ota_mux);
+    ESP_LOGI(TAG, "OTA written: %u bytes in %lld ms (%lld KB/s), sha256 %s", (unsigned)req->content_len,
+             (long long)elapsed_ms, elapsed_ms > 0 ? (long long)req->content_len * 1000 / 1024 / elapsed_ms : 0LL, sha_hex);
+
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_send(req, "{\"ok\":true,\"rebooting\":true}", HTTPD_RESP_USE_STRLEN);
+    xTaskCreate(ota_reboot_task, "ota_reboot", 2048, NULL, 5, NULL);
+    return ESP_OK;
+}
+
+static void ota_receive_task(void *arg) {
+    OtaPipeline *p = static_cast<OtaPipeline *>(arg);
+    httpd_req_t *req = p->req;
+    ota_receive(p);
+    ota_pipeline_free(p);
+    httpd_req_async_handler_complete(req); // Hands the socket back to httpd
+    vTaskDelete(NULL);
+}
+
 static esp_err_t api_ota_handler(httpd_req_t *req) {
     if (!ota_password_matches(req)) {
         httpd_resp_set_status(req, "403 Forbidden");
@@ -1024,64 +1540,127 @@ static esp_err_t api_ota_handler(httpd_req_t *req) {
         return ESP_OK;
     }
 
-    esp_ota_handle_t ota_handle = 0;
-    esp_err_t err = esp_ota_begin(update_partition, req->content_len, &ota_handle);
-    if (err != ESP_OK) {
-        OTA_LOGE("OTA begin failed: %s", esp_err_to_name(err));
-        httpd_resp_set_status(req, "500 Internal Server Error");
-        httpd_resp_send(req, esp_err_to_name(err), HTTPD_RESP_USE_STRLEN);
-        return ESP_FAIL;
+    // Check and claim in one step; the previous upload may still be finishing
+    portENTER_CRITICAL(&s_ota_mux);
+    bool busy = s_ota_status.state == OTA_RECEIVING || s_ota_status.state == OTA_FINISHING;
+    if (!busy) {
+        s_ota_status = {};
+        s_ota_status.state = OTA_RECEIVING;
+        s_ota_status.total = req->content_len;
+        s_ota_status.start_ms = esp_timer_get_time() / 1000;
+    }
+    portEXIT_CRITICAL(&s_ota_mux);
+    if (busy) {
+        httpd_resp_set_status(req, "409 Conflict");
+        httpd_resp_send(req, "Update already running", HTTPD_RESP_USE_STRLEN);
+        return ESP_OK;
     }
 
-    size_t remaining = req->content_len;
-    uint8_t buf[4096];
-    while (remaining > 0) {
-        int recv_len = httpd_req_recv(req, (char *)buf, remaining > sizeof(buf) ? sizeof(buf) : remaining);
-        if (recv_len == HTTPD_SOCK_ERR_TIMEOUT) {
-            continue;
-        }
-        if (recv_len <= 0) {
-            esp_ota_abort(ota_handle);
-            httpd_resp_set_status(req, "500 Internal Server Error");
-            httpd_resp_send(req, "OTA receive failed", HTTPD_RESP_USE_STRLEN);
-            return ESP_FAIL;
-        }
-        err = esp_ota_write(ota_handle, buf, recv_len);
-        if (err != ESP_OK) {
-            esp_ota_abort(ota_handle);
-            OTA_LOGE("OTA write failed: %s", esp_err_to_name(err));
-            httpd_resp_set_status(req, "500 Internal Server Error");
-            httpd_resp_send(req, esp_err_to_name(err), HTTPD_RESP_USE_STRLEN);
-            return ESP_FAIL;
-        }
-        remaining -= recv_len;
+    size_t buf_size = APP_OTA_BUF_SIZE;
+    int buf_count = APP_OTA_BUF_COUNT;
+    uint8_t *pool = (uint8_t *)heap_caps_malloc(buf_size * buf_count, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (!pool) {
+        buf_size = 4096;
+        buf_count = 2;
+        pool = (uint8_t *)heap_caps_malloc(buf_size * buf_count, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    }
+    OtaPipeline *p = (OtaPipeline *)calloc(1, sizeof(OtaPipeline));
+    if (p) {
+        p->partition = update_partition;
+        p->pool = pool;
+        p->buf_size = buf_size;
+        p->filled = xQueueCreate(buf_count + 1, sizeof(OtaChunk));
+        p->free_bufs = xQueueCreate(buf_count, sizeof(uint8_t *));
+        p->done = xSemaphoreCreateBinary();
+        // Optional digest of the image, checked before switching the boot partition
+        httpd_req_get_hdr_value_str(req, "X-OTA-SHA256", p->expected_sha, sizeof(p->expected_sha));
+    } else {
+        free(pool);
+    }
+    if (!pool || !p || !p->filled || !p->free_bufs || !p->done) {
+        ota_pipeline_free(p);
+        return ota_send_error(req, "500 Internal Server Error", "Out of memory");
+    }
+    for (int i = 0; i < buf_count; ++i) {
+        uint8_t *buf = pool + i * buf_size;
+        xQueueSend(p->free_bufs, &buf, 0);
     }
 
-    err = esp_ota_end(ota_handle);
+    // Sectors are erased as the writer reaches them (overlapping the receive);
+    // the final image size is not known up front for gzip uploads anyway.
+    esp_err_t err = esp_ota_begin(update_partition, OTA_WITH_SEQUENTIAL_WRITES, &p->handle);
     if (err != ESP_OK) {
-        OTA_LOGE("OTA end failed: %s", esp_err_to_name(err));
-        httpd_resp_set_status(req, "500 Internal Server Error");
-        httpd_resp_send(req, esp_err_to_name(err), HTTPD_RESP_USE_STRLEN);
-        return ESP_FAIL;
+        OTA_LOGE("OTA begin failed: %s", esp_err_to_name(err));
+        ota_pipeline_free(p);
+        return ota_send_error(req, "500 Internal Server Error", esp_err_to_name(err));
     }
+    mbedtls_sha256_init(&p->sha);
+    mbedtls_sha256_starts(&p->sha, 0);
+    p->write_err = ESP_OK;
 
-    err = esp_ota_set_boot_partition(update_partition);
+    err = httpd_req_async_handler_begin(req, &p->req);
     if (err != ESP_OK) {
-        OTA_LOGE("OTA set boot failed: %s", esp_err_to_name(err));
-        httpd_resp_set_status(req, "500 Internal Server Error");
-        httpd_resp_send(req, esp_err_to_name(err), HTTPD_RESP_USE_STRLEN);
-        return ESP_FAIL;
+        esp_ota_abort(p->handle);
+        ota_pipeline_free(p);
+        return ota_send_error(req, "500 Internal Server Error", esp_err_to_name(err));
+    }
+    if (xTaskCreate(ota_writer_task, "ota_writer", 4096, p, 5, NULL) != pdPASS) {
+        httpd_req_t *async_req = p->req;
+        esp_ota_abort(p->handle);
+        ota_pipeline_free(p);
+        ota_send_error(async_req, "500 Internal Server Error", "Writer task failed");
+        httpd_req_async_handler_complete(async_req);
+        return ESP_OK;
+    }
+    if (xTaskCreate(ota_receive_task, "ota_recv", 4096, p, 5, NULL) != pdPASS) {
+        // The writer is already waiting for chunks: stop it before freeing
+        OtaChunk end = {nullptr, 0};
+        xQueueSend(p->filled, &end, portMAX_DELAY);
+        xSemaphoreTake(p->done, portMAX_DELAY);
+        httpd_req_t *async_req = p->req;
+        esp_ota_abort(p->handle);
+        ota_pipeline_free(p);
+        ota_send_error(async_req, "500 Internal Server Error", "Receive task failed");
+        httpd_req_async_handler_complete(async_req);
+        return ESP_OK;
     }
-
-    httpd_resp_set_type(req, "application/json");
-    httpd_resp_send(req, "{\"ok\":true,\"rebooting\":true}", HTTPD_RESP_USE_STRLEN);
-    xTaskCreate(ota_reboot_task, "ota_reboot", 2048, NULL, 5, NULL);
     return ESP_OK;
 }
 
-static esp_err_t api_settings_get_handler(httpd_req_t *req) {
-    httpd_resp_set_type(req, "application/json");
-    cJSON *root = cJSON_CreateObject();
+// Arena for parsing one request: body plus cJSON tree, with headroom for node overhead
+static size_t json_arena_size(size_t content_len) {
+    return content_len * APP_HTTP_JSON_ARENA_FACTOR + 1024;
+}
+
+// Streaming JSON responses: JsonWriter output goes straight into chunked replies
+static bool httpd_chunk_sink(void *ctx, const char *data, size_t len) {
+    return httpd_resp_send_chunk((httpd_req_t *)ctx, data, len) == ESP_OK;
+}
+
+static size_t web_heap_diag_begin() {
+#if APP_WEB_HEAP_DIAG_LOG
+    heap_caps_monitor_local_minimum_free_size_start();
+#endif
+    return heap_caps_get_free_size(MALLOC_CAP_8BIT);
+}
+
+static esp_err_t finish_json_response(httpd_req_t *req, JsonWriter &out, const char *endpoint, size_t heap_before) {
+    bool ok = out.finish();
+    if (ok) ok = httpd_resp_send_chunk(req, NULL, 0) == ESP_OK;
+#if APP_WEB_HEAP_DIAG_LOG
+    size_t heap_min = heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT);
+    heap_caps_monitor_local_minimum_free_size_stop();
+    ESP_LOGI(TAG, "JSON %s: heap before=%u, lowest during response=%u (peak use %d bytes)",
+             endpoint, (unsigned)heap_before, (unsigned)heap_min, (int)heap_before - (int)heap_min);
+#else
+    (void)endpoint;
+    (void)heap_before;
+#endif
+    return ok ? ESP_OK : ESP_FAIL;
+}
+
+static void write_settings_json(JsonWriter &out) {
+    out.beginObject();
     
     nvs_handle_t my_handle;
     esp_err_t err = nvs_open("dialcharm", NVS_READONLY, &my_handle);
@@ -1095,17 +1674,17 @@ static esp_err_t api_settings_get_handler(httpd_req_t *req) {
     // Language
     len = sizeof(val);
     if (err == ESP_OK && nvs_get_str(my_handle, "src_lang", val, &len) == ESP_OK) {
-        cJSON_AddStringToObject(root, "lang", val);
+        out.field("lang", val);
     } else {
-        cJSON_AddStringToObject(root, "lang", lang_def);
+        out.field("lang", lang_def);
     }
     
     // WiFi SSID (Redacted for security, or show?)
     len = sizeof(val);
     if (err == ESP_OK && nvs_get_str(my_handle, "wifi_ssid", val, &len) == ESP_OK) {
-        cJSON_AddStringToObject(root, "wifi_ssid", val);
+        out.field("wifi_ssid", val);
     } else {
-        cJSON_AddStringToObject(root, "wifi_ssid", "");
+        out.field("wifi_ssid", "");
     }
 
     // IP Address (STA preferred, fallback to AP)
@@ -1118,50 +1697,50 @@ static esp_err_t api_settings_get_handler(httpd_req_t *req) {
     if (netif && esp_netif_get_ip_info(netif, &ip_info) == ESP_OK && ip_info.ip.addr != 0) {
         snprintf(ip_buf, sizeof(ip_buf), IPSTR, IP2STR(&ip_info.ip));
     }
-    cJSON_AddStringToObject(root, "ip", ip_buf);
+    out.field("ip", ip_buf);
 
-    cJSON_AddNumberToObject(root, "boot_count", (double)s_boot_count);
-    cJSON_AddStringToObject(root, "reset_reason", s_reset_reason[0] ? s_reset_reason : "unknown");
-    cJSON_AddNumberToObject(root, "reset_reason_code", s_reset_reason_code);
+    out.field("boot_count", s_boot_count);
+    out.field("reset_reason", s_reset_reason[0] ? s_reset_reason : "unknown");
+    out.field("reset_reason_code", s_reset_reason_code);
 
     uint8_t sd_log_enabled = APP_ENABLE_SD_LOG ? 1 : 0;
     if (err == ESP_OK) {
         nvs_get_u8(my_handle, "sd_log_enabled", &sd_log_enabled);
     }
-    cJSON_AddBoolToObject(root, "sd_log_enabled", s_runtime_logging_enabled && (sd_log_enabled != 0));
+    out.field("sd_log_enabled", s_runtime_logging_enabled && (sd_log_enabled != 0));
 
     // WiFi Pass (Always return empty or placeholder)
-    cJSON_AddStringToObject(root, "wifi_pass", "");
+    out.field("wifi_pass", "");
 
     // System Volume
     // Base Speaker
     uint8_t vol = 60;
     if (err == ESP_OK) nvs_get_u8(my_handle, "volume", &vol);
-    cJSON_AddNumberToObject(root, "volume", vol);
+    out.field("volume", vol);
 
     // Handset Volume (New)
     uint8_t vol_h = APP_DEFAULT_HANDSET_VOLUME;
     if (err == ESP_OK) nvs_get_u8(my_handle, "volume_handset", &vol_h);
-    cJSON_AddNumberToObject(root, "volume_handset", vol_h);
+    out.field("volume_handset", vol_h);
 
     // Alarm Volume
     uint8_t vol_a = APP_ALARM_DEFAULT_VOLUME;
     if (err == ESP_OK) nvs_get_u8(my_handle, "vol_alarm", &vol_a);
-    cJSON_AddNumberToObject(root, "vol_alarm", vol_a);
+    out.field("vol_alarm", vol_a);
     // Send configured minimum to frontend
-    cJSON_AddNumberToObject(root, "vol_alarm_min", APP_ALARM_MIN_VOLUME);
+    out.field("vol_alarm_min", APP_ALARM_MIN_VOLUME);
 
     // Night mode base speaker volume
     uint8_t night_base_vol = 50;
     if (err == ESP_OK) {
         nvs_get_u8(my_handle, NVS_KEY_NIGHT_BASE_VOL, &night_base_vol);
     }
-    cJSON_AddNumberToObject(root, "night_base_volume", night_base_vol);
+    out.field("night_base_volume", night_base_vol);
 
     // Snooze Time
     int32_t snooze = APP_SNOOZE_DEFAULT_MINUTES;
     if (err == ESP_OK) nvs_get_i32(my_handle, "snooze_min", &snooze);
-    cJSON_AddNumberToObject(root, "snooze_min", snooze);
+    out.field("snooze_min", snooze);
 
     // Timer Ringtone
     len = sizeof(val);
@@ -1188,56 +1767,184 @@ static esp_err_t api_settings_get_handler(httpd_req_t *req) {
         ringtone_name = APP_DEFAULT_TIMER_RINGTONE;
     }
 
-    cJSON_AddStringToObject(root, "timer_ringtone", ringtone_name.c_str());
+    out.field("timer_ringtone", ringtone_name);
 
     // LED signal lamp settings
     AppLedSettings led_settings = app_default_led_settings();
     if (err == ESP_OK) {
         app_load_led_settings_from_handle(my_handle, &led_settings);
     }
-    cJSON_AddBoolToObject(root, "led_enabled", led_settings.enabled != 0);
-    cJSON_AddNumberToObject(root, "led_day_pct", led_settings.day_pct);
-    cJSON_AddNumberToObject(root, "led_night_pct", led_settings.night_pct);
-    cJSON_AddNumberToObject(root, "led_day_start", led_settings.day_start);
-    cJSON_AddNumberToObject(root, "led_night_start", led_settings.night_start);
+    out.field("led_enabled", led_settings.enabled != 0);
+    out.field("led_day_pct", led_settings.day_pct);
+    out.field("led_night_pct", led_settings.night_pct);
+    out.field("led_day_start", led_settings.day_start);
+    out.field("led_night_start", led_settings.night_start);
 
     
     // --- Time & Timezone ---
     struct tm now = TimeManager::getCurrentTime();
     char timeStr[64];
     strftime(timeStr, sizeof(timeStr), "%Y-%m-%d %H:%M:%S", &now);
-    cJSON_AddStringToObject(root, "current_time", timeStr);
-    cJSON_AddBoolToObject(root, "time_synchronized", TimeManager::getLastNtpSync() > 0);
+    out.field("current_time", timeStr);
+    out.field("time_synchronized", TimeManager::getLastNtpSync() > 0);
     
     std::string tz = TimeManager::getTimezone();
     if(tz.empty()) tz = "CET-1CEST,M3.5.0,M10.5.0/3"; // Fallback default in UI
-    cJSON_AddStringToObject(root, "timezone", tz.c_str());
+    out.field("timezone", tz);
     // -----------------------
 
     // --- Alarms ---
-    cJSON *alarms = cJSON_CreateArray();
+    out.key("alarms");
+    out.beginArray();
+    WeekSchedule week = TimeManager::getSchedule();
     for (int i=0; i<7; i++) {
-        DayAlarm a = TimeManager::getAlarm(i);
-        cJSON *itm = cJSON_CreateObject();
-        cJSON_AddNumberToObject(itm, "d", i);
-        cJSON_AddNumberToObject(itm, "h", a.hour);
-        cJSON_AddNumberToObject(itm, "m", a.minute);
-        cJSON_AddBoolToObject(itm, "en", a.active);
-        cJSON_AddBoolToObject(itm, "rmp", a.volumeRamp);
-        cJSON_AddBoolToObject(itm, "msg", a.useRandomMsg);
-        cJSON_AddStringToObject(itm, "snd", a.ringtone.c_str());
-        cJSON_AddItemToArray(alarms, itm);
-    }
-    cJSON_AddItemToObject(root, "alarms", alarms);
+        const DayAlarm &a = week.days[i];
+        out.beginObject();
+        out.field("d", i);
+        out.field("h", a.hour);
+        out.field("m", a.minute);
+        out.field("en", a.active);
+        out.field("rmp", a.volumeRamp);
+        out.field("msg", a.useRandomMsg);
+        out.field("snd", a.ringtone);
+        out.endObject();
+    }
+    out.endArray();
+
+    // Additional alarms: "days" bit mask (bit0=Sunday), or 0 with "date" for one-shot
+    out.key("extra_alarms");
+    out.beginArray();
+    for (const AlarmEntry &a : TimeManager::getExtraAlarms()) {
+        out.beginObject();
+        out.field("id", a.id);
+        out.field("days", a.days);
+        out.field("h", a.hour);
+        out.field("m", a.minute);
+        char date[16] = "";
+        if (a.days == 0) snprintf(date, sizeof(date), "%04d-%02d-%02d", a.year, a.month, a.mday);
+        out.field("date", date);
+        out.field("en", a.active);
+        out.field("rmp", a.volumeRamp);
+        out.field("msg", a.useRandomMsg);
+        out.field("snd", a.ringtone);
+        out.endObject();
+    }
+    out.endArray();
     // --------------
     
     if (err == ESP_OK) nvs_close(my_handle);
 
-    const char *json_str = cJSON_PrintUnformatted(root);
-    httpd_resp_send(req, json_str, strlen(json_str));
-    free((void*)json_str);
-    cJSON_Delete(root);
-    return ESP_OK;
+    out.endObject();
+}
+
+// Progress of the running (or last) update for the web UI
+static esp_err_t api_ota_status_handler(httpd_req_t *req) {
+    static const char *const kStateNames[] = {"idle", "receiving", "finishing", "done", "failed"};
+    portENTER_CRITICAL(&s_ota_mux);
+    OtaStatus st = s_ota_status;
+    portEXIT_CRITICAL(&s_ota_mux);
+
+    int64_t end_ms = (st.state == OTA_DONE || st.state == OTA_FAILED) ? st.end_ms : esp_timer_get_time() / 1000;
+    int64_t elapsed_ms = st.start_ms ? end_ms - st.start_ms : 0;
+
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+    JsonWriter out(httpd_chunk_sink, req);
+    out.beginObject();
+    out.field("state", kStateNames[st.state]);
+    out.field("total", st.total);
+    out.field("received", st.received);
+    out.field("consumed", st.consumed);
+    out.field("written", st.written);
+    out.field("compressed", st.compressed);
+    out.field("elapsed_ms", elapsed_ms);
+    out.field("kbps", elapsed_ms > 0 ? (int64_t)st.written * 1000 / 1024 / elapsed_ms : (int64_t)0);
+    out.field("sha256", st.sha256);
+    out.field("error", st.error);
+    out.endObject();
+    return finish_json_response(req, out, "ota_status", 0);
+}
+
+static esp_err_t api_settings_get_handler(httpd_req_t *req) {
+    size_t heap_before = web_heap_diag_begin();
+    httpd_resp_set_type(req, "application/json");
+    JsonWriter out(httpd_chunk_sink, req);
+    write_settings_json(out);
+    return finish_json_response(req, out, "settings", heap_before);
+}
+
+// Ringtone file names (.wav) on the SD card
+static void write_ringtones_json(JsonWriter &out) {
+    out.beginArray();
+    DIR *dir = opendir("/sdcard/ringtones");
+    if (dir) {
+        struct dirent *ent;
+        while ((ent = readdir(dir)) != NULL) {
+            if (ent->d_type != DT_REG) {
+                continue;
+            }
+
+            const char *name = ent->d_name;
+            size_t len = strlen(name);
+            if (len >= 4 && strcasecmp(name + len - 4, ".wav") == 0) {
+                out.value(name);
+            }
+        }
+        closedir(dir);
+    } else {
+        ESP_LOGW(TAG, "Ringtones folder not accessible: /sdcard/ringtones");
+    }
+    out.endArray();
+}
+
+static esp_err_t api_ringtones_handler(httpd_req_t *req) {
+    size_t heap_before = web_heap_diag_begin();
+    httpd_resp_set_type(req, "application/json");
+    JsonWriter out(httpd_chunk_sink, req);
+    write_ringtones_json(out);
+    return finish_json_response(req, out, "ringtones", heap_before);
+}
+
+// One request for everything the UI loads. Only sections changed after
+// ?since=<version> are included; 304 if nothing changed.
+static esp_err_t api_state_handler(httpd_req_t *req) {
+    uint32_t since = 0;
+    char query[48];
+    char param[16];
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK &&
+        httpd_query_key_value(query, "since", param, sizeof(param)) == ESP_OK) {
+        since = strtoul(param, nullptr, 10);
+    }
+
+    state_version::Snapshot snap = state_version::snapshot();
+    if (since < snap.base || since > snap.current) {
+        since = 0; // Version from another boot: send everything
+    }
+    if (since == snap.current) {
+        httpd_resp_set_status(req, "304 Not Modified");
+        return httpd_resp_send(req, NULL, 0);
+    }
+
+    size_t heap_before = web_heap_diag_begin();
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+    JsonWriter out(httpd_chunk_sink, req);
+    out.beginObject();
+    out.field("version", snap.current);
+    if (snap.section[STATE_SETTINGS] > since) {
+        out.key("settings");
+        write_settings_json(out);
+    }
+    if (snap.section[STATE_RINGTONES] > since) {
+        out.key("ringtones");
+        write_ringtones_json(out);
+    }
+    if (snap.section[STATE_PHONEBOOK] > since) {
+        out.key("phonebook");
+        phonebook.writeJson(out);
+    }
+    out.endObject();
+    return finish_json_response(req, out, "state", heap_before);
 }
 
 static esp_err_t api_settings_post_handler(httpd_req_t *req) {
@@ -1246,8 +1953,15 @@ static esp_err_t api_settings_post_handler(httpd_req_t *req) {
         httpd_resp_send(req, "Missing body", HTTPD_RESP_USE_STRLEN);
         return ESP_FAIL;
     }
+    if (req->content_len > APP_HTTP_JSON_MAX_BODY) {
+        httpd_resp_set_status(req, "413 Payload Too Large");
+        httpd_resp_send(req, "Body too large", HTTPD_RESP_USE_STRLEN);
+        return ESP_FAIL;
+    }
 
-    char *buf = (char *)malloc(req->content_len + 1);
+    // Body and parsed tree live in one arena released when the handler returns
+    CjsonArenaScope arena(json_arena_size(req->content_len));
+    char *buf = (char *)cJSON_malloc(req->content_len + 1);
     if (!buf) {
         httpd_resp_send_500(req);
         return ESP_FAIL;
@@ -1261,7 +1975,7 @@ static esp_err_t api_settings_post_handler(httpd_req_t *req) {
             continue;
         }
         if (ret <= 0) {
-            free(buf);
+            cJSON_free(buf);
             httpd_resp_set_status(req, "400 Bad Request");
             httpd_resp_send(req, "Failed to read body", HTTPD_RESP_USE_STRLEN);
             return ESP_FAIL;
@@ -1273,7 +1987,7 @@ static esp_err_t api_settings_post_handler(httpd_req_t *req) {
     
     cJSON *root = cJSON_Parse(buf);
     if (root == NULL) {
-        free(buf);
+        cJSON_free(buf);
         httpd_resp_set_status(req, "400 Bad Request");
         httpd_resp_send(req, "Invalid JSON", HTTPD_RESP_USE_STRLEN);
         return ESP_FAIL;
@@ -1426,14 +2140,9 @@ static esp_err_t api_settings_post_handler(httpd_req_t *req) {
         // --- Alarms ---
         cJSON *alarms_arr = cJSON_GetObjectItem(root, "alarms");
         if (cJSON_IsArray(alarms_arr)) {
+            // Merge into the current week and persist once instead of one commit per day
+            WeekSchedule schedule = TimeManager::getSchedule();
             int alarm_updates = 0;
-            bool has_day0 = false;
-            int day0_h = 0;
-            int day0_m = 0;
-            bool day0_active = false;
-            bool day0_ramp = false;
-            bool day0_msg = false;
-            std::string day0_ringtone;
             cJSON *elem;
             cJSON_ArrayForEach(elem, alarms_arr) {
                 cJSON *d = cJSON_GetObjectItem(elem, "d");
@@ -1445,6 +2154,7 @@ static esp_err_t api_settings_post_handler(httpd_req_t *req) {
                 cJSON *snd = cJSON_GetObjectItem(elem, "snd");
                 
                 if (cJSON_IsNumber(d) && cJSON_IsNumber(h) && cJSON_IsNumber(m)) {
+                    if (d->valueint < 0 || d->valueint > 6) continue;
                     bool active = false;
                     bool ramp = false;
                     bool useMsg = false;
@@ -1458,26 +2168,59 @@ static esp_err_t api_settings_post_handler(httpd_req_t *req) {
                     if (cJSON_IsNumber(msg)) useMsg = (msg->valueint == 1);
 
                     const char* ringtone = (snd && cJSON_IsString(snd)) ? snd->valuestring : "";
-                    if (d->valueint == 0) {
-                        has_day0 = true;
-                        day0_h = h->valueint;
-                        day0_m = m->valueint;
-                        day0_active = active;
-                        day0_ramp = ramp;
-                        day0_msg = useMsg;
-                        day0_ringtone = ringtone ? ringtone : "";
-                        continue;
-                    }
-                    TimeManager::setAlarm(d->valueint, h->valueint, m->valueint, active, ramp, useMsg, ringtone);
+                    DayAlarm &day = schedule.days[d->valueint];
+                    day.hour = h->valueint;
+                    day.minute = m->valueint;
+                    day.active = active;
+                    day.volumeRamp = ramp;
+                    day.useRandomMsg = useMsg;
+                    day.ringtone = (ringtone && strlen(ringtone) > 0) ? ringtone : APP_DEFAULT_TIMER_RINGTONE;
                     alarm_updates++;
                 }
             }
-            if (has_day0) {
-                TimeManager::setAlarm(0, day0_h, day0_m, day0_active, day0_ramp, day0_msg, day0_ringtone.c_str());
-                alarm_updates++;
+            if (alarm_updates > 0) {
+                mark_nvs_write(TimeManager::setSchedule(schedule), "alm_sched");
             }
             ESP_LOGI(TAG, "Alarm settings saved: %d entries", alarm_updates);
         }
+
+        cJSON *extra_arr = cJSON_GetObjectItem(root, "extra_alarms");
+        if (cJSON_IsArray(extra_arr)) {
+            std::vector<AlarmEntry> extra;
+            bool extra_valid = true;
+            cJSON *elem;
+            cJSON_ArrayForEach(elem, extra_arr) {
+                cJSON *h = cJSON_GetObjectItem(elem, "h");
+                cJSON *m = cJSON_GetObjectItem(elem, "m");
+                cJSON *days = cJSON_GetObjectItem(elem, "days");
+                cJSON *date = cJSON_GetObjectItem(elem, "date");
+                cJSON *snd = cJSON_GetObjectItem(elem, "snd");
+                if (!cJSON_IsNumber(h) || !cJSON_IsNumber(m)) {
+                    extra_valid = false;
+                    break;
+                }
+
+                AlarmEntry a = {};
+                a.hour = h->valueint;
+                a.minute = m->valueint;
+                a.days = cJSON_IsNumber(days) ? (uint8_t)(days->valueint & 0x7F) : 0;
+                if (a.days == 0 && cJSON_IsString(date) &&
+                    sscanf(date->valuestring, "%d-%d-%d", &a.year, &a.month, &a.mday) != 3) {
+                    extra_valid = false;
+                    break;
+                }
+                a.active = cJSON_IsTrue(cJSON_GetObjectItem(elem, "en"));
+                a.volumeRamp = cJSON_IsTrue(cJSON_GetObjectItem(elem, "rmp"));
+                a.useRandomMsg = cJSON_IsTrue(cJSON_GetObjectItem(elem, "msg"));
+                a.ringtone = cJSON_IsString(snd) ? snd->valuestring : "";
+                extra.push_back(a);
+            }
+            if (extra_valid) {
+                mark_nvs_write(TimeManager::setExtraAlarms(extra), "alm_sched");
+            } else {
+                mark_nvs_write(ESP_ERR_INVALID_ARG, "extra_alarms");
+            }
+        }
         // --------------
 
         if (!nvs_write_failed) {
@@ -1497,7 +2240,7 @@ static esp_err_t api_settings_post_handler(httpd_req_t *req) {
 
     if (nvs_write_failed) {
         cJSON_Delete(root);
-        free(buf);
+        cJSON_free(buf);
         httpd_resp_set_status(req, "500 Internal Server Error");
         httpd_resp_send(req, esp_err_to_name(nvs_first_err), HTTPD_RESP_USE_STRLEN);
         return ESP_FAIL;
@@ -1514,7 +2257,8 @@ static esp_err_t api_settings_post_handler(httpd_req_t *req) {
     }
     
     cJSON_Delete(root);
-    free(buf);
+    cJSON_free(buf);
+    state_version::bump(STATE_SETTINGS);
     httpd_resp_send(req, "{\"status\":\"ok\"}", HTTPD_RESP_USE_STRLEN);
     
     if (wifi_updated) {
@@ -1527,74 +2271,112 @@ static esp_err_t api_settings_post_handler(httpd_req_t *req) {
 }
 
 static esp_err_t api_phonebook_get_handler(httpd_req_t *req) {
+    size_t heap_before = web_heap_diag_begin();
     httpd_resp_set_type(req, "application/json");
-    std::string json = phonebook.getJson();
-    httpd_resp_send(req, json.c_str(), json.length());
-    return ESP_OK;
+    JsonWriter out(httpd_chunk_sink, req);
+    phonebook.writeJson(out);
+    return finish_json_response(req, out, "phonebook", heap_before);
 }
 
-static esp_err_t api_wifi_scan_handler(httpd_req_t *req) {
-    wifi_scan_config_t scan_config = {
-        .ssid = NULL,
-        .bssid = NULL,
-        .channel = 0,
-        .show_hidden = true,
-        .scan_type = WIFI_SCAN_TYPE_ACTIVE,
-        .scan_time = {
-            .active = { .min = 100, .max = 300 },
-            .passive = 100
-        },
-        .home_chan_dwell_time = 0,
-        .channel_bitmap = { .ghz_2_channels = 0, .ghz_5_channels = 0 },
-        .coex_background_scan = false
-    };
+// Replaces the whole phonebook with the posted JSON (same shape as GET) and persists it
+static esp_err_t api_phonebook_post_handler(httpd_req_t *req) {
+    if (req->content_len <= 0 || req->content_len > APP_PB_FILE_MAX_BYTES) {
+        httpd_resp_set_status(req, "400 Bad Request");
+        httpd_resp_send(req, "Missing or oversized body", HTTPD_RESP_USE_STRLEN);
+        return ESP_FAIL;
+    }
 
-    // Trigger scan (blocking)
-    // Note: In strict AP mode, scan might not work on all ESP32 revisions without APSTA.
-    // However, esp_wifi_scan_start usually works.
-    esp_err_t err = esp_wifi_scan_start(&scan_config, true);
-    if (err != ESP_OK) {
-        ESP_LOGE(TAG, "WiFi Scan failed: %s", esp_err_to_name(err));
+    CjsonArenaScope arena(json_arena_size(req->content_len));
+    char *body = (char *)cJSON_malloc(req->content_len + 1);
+    if (!body) {
         httpd_resp_send_500(req);
         return ESP_FAIL;
     }
 
-    uint16_t ap_count = 0;
-    esp_wifi_scan_get_ap_num(&ap_count);
-    
-    // Limit to 20 for memory safety
-    if (ap_count > 20) ap_count = 20;
-
-    wifi_ap_record_t *ap_list = (wifi_ap_record_t *)malloc(sizeof(wifi_ap_record_t) * ap_count);
-    if (!ap_list) {
-         httpd_resp_send_500(req);
-         return ESP_FAIL;
+    size_t offset = 0;
+    while (offset < (size_t)req->content_len) {
+        int ret = httpd_req_recv(req, body + offset, req->content_len - offset);
+        if (ret == HTTPD_SOCK_ERR_TIMEOUT) {
+            continue;
+        }
+        if (ret <= 0) {
+            cJSON_free(body);
+            httpd_resp_set_status(req, "400 Bad Request");
+            httpd_resp_send(req, "Failed to read body", HTTPD_RESP_USE_STRLEN);
+            return ESP_FAIL;
+        }
+        offset += (size_t)ret;
     }
+    body[offset] = '\0';
 
-    esp_wifi_scan_get_ap_records(&ap_count, ap_list);
+    bool parsed = phonebook.saveFromJson(body);
+    cJSON_free(body);
+    if (!parsed) {
+        httpd_resp_set_status(req, "400 Bad Request");
+        httpd_resp_send(req, "Invalid JSON", HTTPD_RESP_USE_STRLEN);
+        return ESP_FAIL;
+    }
 
-    cJSON *root = cJSON_CreateArray();
-    for (int i = 0; i < ap_count; i++) {
-        // Filter out empty SSIDs
-        if (strlen((char*)ap_list[i].ssid) > 0) {
-            cJSON *item = cJSON_CreateObject();
-            cJSON_AddStringToObject(item, "ssid", (char *)ap_list[i].ssid);
-            cJSON_AddNumberToObject(item, "rssi", ap_list[i].rssi);
-            cJSON_AddNumberToObject(item, "auth", ap_list[i].authmode);
-            cJSON_AddItemToArray(root, item);
-        }
+    esp_err_t err = phonebook.saveChanges();
+    if (err != ESP_OK) {
+        httpd_resp_set_status(req, "500 Internal Server Error");
+        httpd_resp_send(req, esp_err_to_name(err), HTTPD_RESP_USE_STRLEN);
+        return ESP_FAIL;
     }
-    free(ap_list);
 
-    const char *json_str = cJSON_PrintUnformatted(root);
     httpd_resp_set_type(req, "application/json");
-    httpd_resp_send(req, json_str, strlen(json_str));
-    
-    free((void*)json_str);
-    cJSON_Delete(root);
+    httpd_resp_send(req, "{\"status\":\"ok\"}", HTTPD_RESP_USE_STRLEN);
     return ESP_OK;
 }
 
+// Returns the cached scan at once and starts a refresh in the background when
+// the cache is stale (or ?refresh=1). "scanning" tells the UI to ask again.
+static esp_err_t api_wifi_scan_handler(httpd_req_t *req) {
+    size_t heap_before = web_heap_diag_begin();
+    bool force = false;
+    char query[32];
+    char param[8];
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK &&
+        httpd_query_key_value(query, "refresh", param, sizeof(param)) == ESP_OK) {
+        force = strcmp(param, "1") == 0;
+    }
+
+    int64_t now_ms = esp_timer_get_time() / 1000;
+    portENTER_CRITICAL(&s_scan_mux);
+    int64_t done_ms = s_scan_done_ms;
+    bool running = s_scan_running && now_ms - s_scan_started_ms < 15000; // Lost SCAN_DONE: allow a retry
+    portEXIT_CRITICAL(&s_scan_mux);
+
+    bool stale = done_ms == 0 || now_ms - done_ms > APP_WIFI_SCAN_MAX_AGE_MS;
+    if ((stale || force) && !running) {
+        running = wifi_scan_start_async() == ESP_OK;
+    }
+
+    WifiScanEntry list[APP_WIFI_SCAN_MAX_RESULTS];
+    portENTER_CRITICAL(&s_scan_mux);
+    size_t count = s_scan_count;
+    memcpy(list, s_scan_list, count * sizeof(list[0]));
+    portEXIT_CRITICAL(&s_scan_mux);
+
+    httpd_resp_set_type(req, "application/json");
+    JsonWriter out(httpd_chunk_sink, req);
+    out.beginObject();
+    out.field("scanning", running);
+    out.field("age_ms", done_ms ? now_ms - done_ms : (int64_t)-1);
+    out.key("networks");
+    out.beginArray();
+    for (size_t i = 0; i < count; ++i) {
+        out.beginObject();
+        out.field("ssid", list[i].ssid);
+        out.field("rssi", list[i].rssi);
+        out.field("auth", list[i].auth);
+        out.endObject();
+    }
+    out.endArray();
+    out.endObject();
+    return finish_json_response(req, out, "wifi_scan", heap_before);
+}
+
 // Embedded Files
 extern const char index_html_start[] asm("_binary_index_html_start");
 extern const char index_html_end[]   asm("_binary_index_html_end");
@@ -1607,12 +2389,199 @@ extern const char font_plaisir_end[]   asm("_binary_3620_plaisir_app_otf_end");
 extern const char font_aatriple_start[] asm("_binary_AATriple_otf_start");
 extern const char font_aatriple_end[]   asm("_binary_AATriple_otf_end");
 
+#if __has_include("web_assets_gz.h")
+#include "web_assets_gz.h" // Generated by utils/build_web_assets.py
+#define WEB_HAVE_GZ_ASSETS 1
+#else
+#define WEB_HAVE_GZ_ASSETS 0
+#endif
+
+enum EmbeddedAssetId { ASSET_INDEX = 0, ASSET_STYLE, ASSET_APP, ASSET_FONT_PLAISIR, ASSET_FONT_AATRIPLE, ASSET_COUNT };
+
+// ETag source and optional gzip copy per embedded asset, resolved on first use.
+// Only touched from the httpd task.
+struct EmbeddedAssetInfo {
+    const char *name;
+    bool ready;
+    uint32_t crc;
+    const uint8_t *gz;
+    size_t gz_len;
+};
+
+static EmbeddedAssetInfo s_asset_info[ASSET_COUNT] = {
+    {"index.html"}, {"style.css"}, {"app.js"}, {"3620-plaisir-app.otf"}, {"AATriple.otf"},
+};
+
+static const EmbeddedAssetInfo &embedded_asset_info(int id, const char *data, size_t size) {
+    EmbeddedAssetInfo &info = s_asset_info[id];
+    if (info.ready) return info;
+    info.ready = true;
+    info.crc = esp_rom_crc32_le(0, (const uint8_t *)data, size);
+#if WEB_HAVE_GZ_ASSETS
+    for (const WebAssetGz *gz = web_assets_gz; gz->name; ++gz) {
+        if (strcmp(gz->name, info.name) != 0) continue;
+        if (gz->src_crc == info.crc && gz->src_len == size) {
+            info.gz = gz->data;
+            info.gz_len = gz->len;
+        } else {
+            // Header was generated from an older web_ui; serve the original
+            ESP_LOGW(TAG, "Stale gzip copy of %s ignored, rerun utils/build_web_assets.py", info.name);
+        }
+    }
+#endif
+    return info;
+}
+
+// True if the request header contains token (e.g. "gzip" in Accept-Encoding)
+static bool request_header_contains(httpd_req_t *req, const char *field, const char *token) {
+    char value[128];
+    if (httpd_req_get_hdr_value_str(req, field, value, sizeof(value)) != ESP_OK) {
+        return false;
+    }
+    return strstr(value, token) != nullptr;
+}
+
+// Read buffer for SD file responses, allocated once and reused. Only the
+// httpd task serves files, so no lock is needed.
+static char *s_file_buf = nullptr;
+static size_t s_file_buf_size = 0;
+
+static bool ensure_file_buffer() {
+    if (s_file_buf) return true;
+    s_file_buf = (char *)heap_caps_malloc(APP_WEB_FILE_BUF_SIZE, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    s_file_buf_size = APP_WEB_FILE_BUF_SIZE;
+    if (!s_file_buf) {
+        s_file_buf_size = 4096;
+        s_file_buf = (char *)heap_caps_malloc(s_file_buf_size, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    }
+    return s_file_buf != nullptr;
+}
+
+// Parses a single "bytes=a-b", "bytes=a-" or "bytes=-n" range.
+// Returns 1 with [start, end] set, 0 to ignore the header (serve the whole
+// file, e.g. multiple ranges) or -1 if the range cannot be satisfied.
+static int parse_byte_range(const char *value, int64_t size, int64_t *start, int64_t *end) {
+    if (strncmp(value, "bytes=", 6) != 0 || strchr(value, ',')) return 0;
+    const char *spec = value + 6;
+    const char *dash = strchr(spec, '-');
+    if (!dash) return 0;
+
+    char *parse_end = nullptr;
+    if (dash == spec) {
+        long long suffix = strtoll(dash + 1, &parse_end, 10);
+        if (parse_end == dash + 1 || suffix <= 0 || size == 0) return -1;
+        *start = suffix >= size ? 0 : size - suffix;
+        *end = size - 1;
+        return 1;
+    }
+
+    long long first = strtoll(spec, &parse_end, 10);
+    if (parse_end != dash || first < 0) return 0;
+    if (first >= size) return -1;
+    long long last = size - 1;
+    if (dash[1] != '\0') {
+        last = strtoll(dash + 1, &parse_end, 10);
+        if (parse_end == dash + 1 || last < first) return 0;
+        if (last >= size) last = size - 1;
+    }
+    *start = first;
+    *end = last;
+    return 1;
+}
+
+static esp_err_t send_raw(httpd_req_t *req, const char *data, size_t len) {
+    while (len > 0) {
+        int sent = httpd_send(req, data, len);
+        if (sent <= 0) return ESP_FAIL;
+        data += sent;
+        len -= sent;
+    }
+    return ESP_OK;
+}
+
+// Streams an SD file with Content-Length and single-range (206) support.
+// Headers are written directly because httpd_resp_send_chunk() cannot
+// carry a Content-Length.
+static esp_err_t serve_sd_file(httpd_req_t *req, const char *path, int64_t size) {
+    int64_t start = 0;
+    int64_t end = size - 1;
+    int range = 0;
+    char range_hdr[64];
+    if (httpd_req_get_hdr_value_str(req, "Range", range_hdr, sizeof(range_hdr)) == ESP_OK) {
+        range = parse_byte_range(range_hdr, size, &start, &end);
+    }
+
+    char head[256];
+    if (range < 0) {
+        int n = snprintf(head, sizeof(head),
+                         "HTTP/1.1 416 Range Not Satisfiable\r\nContent-Range: bytes */%lld\r\nContent-Length: 0\r\n\r\n",
+                         (long long)size);
+        return send_raw(req, head, n);
+    }
+
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        ESP_LOGE(TAG, "Failed to open allowed SD file: %s", path);
+        esp_err_t send_404_err = httpd_resp_send_404(req);
+        note_http_error("static_file_handler:sd_open_404", send_404_err);
+        return ESP_FAIL;
+    }
+    if (!ensure_file_buffer()) {
+        fclose(f);
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Out of memory");
+        return ESP_FAIL;
+    }
+    setvbuf(f, NULL, _IONBF, 0); // Reads already match the buffer size
+    if (start > 0 && fseek(f, (long)start, SEEK_SET) != 0) {
+        fclose(f);
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Seek failed");
+        return ESP_FAIL;
+    }
+
+    int64_t length = size > 0 ? end - start + 1 : 0;
+    int n;
+    if (range > 0) {
+        n = snprintf(head, sizeof(head),
+                     "HTTP/1.1 206 Partial Content\r\nContent-Type: %s\r\nContent-Length: %lld\r\n"
+                     "Content-Range: bytes %lld-%lld/%lld\r\nAccept-Ranges: bytes\r\n\r\n",
+                     get_mime_type(path), (long long)length, (long long)start, (long long)end, (long long)size);
+    } else {
+        n = snprintf(head, sizeof(head),
+                     "HTTP/1.1 200 OK\r\nContent-Type: %s\r\nContent-Length: %lld\r\nAccept-Ranges: bytes\r\n\r\n",
+                     get_mime_type(path), (long long)length);
+    }
+
+    int64_t t0 = esp_timer_get_time();
+    esp_err_t err = send_raw(req, head, n);
+    int64_t remaining = length;
+    while (err == ESP_OK && remaining > 0) {
+        size_t want = remaining < (int64_t)s_file_buf_size ? (size_t)remaining : s_file_buf_size;
+        size_t got = fread(s_file_buf, 1, want, f);
+        if (got == 0) {
+            err = ESP_FAIL; // File shrank; the client sees a short body
+            break;
+        }
+        err = send_raw(req, s_file_buf, got);
+        remaining -= got;
+    }
+    fclose(f);
+
+    int64_t elapsed_ms = (esp_timer_get_time() - t0) / 1000;
+    int64_t sent = length - remaining;
+    ESP_LOGI(TAG, "Served %s: %lld bytes%s in %lld ms (%lld KB/s)", path, (long long)sent,
+             range > 0 ? " (range)" : "", (long long)elapsed_ms,
+             elapsed_ms > 0 ? (long long)(sent * 1000 / 1024 / elapsed_ms) : 0LL);
+    note_http_error("static_file_handler:sd_send", err);
+    return err;
+}
+
 static esp_err_t static_file_handler(httpd_req_t *req) {
     const char* file_path = req->uri;
     const char* file_start = NULL;
     const char* file_end = NULL;
     const char* mime_type = "text/plain";
     bool is_font = false;
+    int asset_id = ASSET_INDEX;
 
     ESP_LOGI(TAG, "Handling URI: %s", file_path);
 
@@ -1630,24 +2599,29 @@ static esp_err_t static_file_handler(httpd_req_t *req) {
         file_start = index_html_start;
         file_end = index_html_end;
         mime_type = "text/html";
+        asset_id = ASSET_INDEX;
     } else if (strcmp(file_path, "/style.css") == 0) {
         file_start = style_css_start;
         file_end = style_css_end;
         mime_type = "text/css";
+        asset_id = ASSET_STYLE;
     } else if (strcmp(file_path, "/app.js") == 0) {
         file_start = app_js_start;
         file_end = app_js_end;
         mime_type = "application/javascript";
+        asset_id = ASSET_APP;
     } else if (strncmp(file_path, "/fonts/3620-plaisir-app.otf", 27) == 0) {
         file_start = font_plaisir_start;
         file_end = font_plaisir_end;
         mime_type = "application/font-otf";
         is_font = true;
+        asset_id = ASSET_FONT_PLAISIR;
     } else if (strncmp(file_path, "/fonts/AATriple.otf", 19) == 0) {
         file_start = font_aatriple_start;
         file_end = font_aatriple_end;
         mime_type = "application/font-otf";
         is_font = true;
+        asset_id = ASSET_FONT_AATRIPLE;
     } else if (strcmp(file_path, "/favicon.ico") == 0) {
         httpd_resp_set_status(req, "204 No Content");
         httpd_resp_send(req, NULL, 0);
@@ -1660,6 +2634,7 @@ static esp_err_t static_file_handler(httpd_req_t *req) {
         file_start = index_html_start;
         file_end = index_html_end;
         mime_type = "text/html";
+        asset_id = ASSET_INDEX;
     }
 
     if (file_start) {
@@ -1669,12 +2644,39 @@ static esp_err_t static_file_handler(httpd_req_t *req) {
             file_size--;
         }
 
-        ESP_LOGI(TAG, "Serving embedded file: %s (Size: %d)", file_path, (int)file_size);
+        // Revalidate everything except fonts, which only change with a firmware
+        // update and are cached for a year.
+        const EmbeddedAssetInfo &info = embedded_asset_info(asset_id, file_start, file_size);
+        bool use_gz = info.gz && request_header_contains(req, "Accept-Encoding", "gzip");
+        char etag[16];
+        snprintf(etag, sizeof(etag), "\"%08lx%s\"", (unsigned long)info.crc, use_gz ? "g" : "");
+        httpd_resp_set_hdr(req, "ETag", etag);
+        httpd_resp_set_hdr(req, "Cache-Control", is_font ? "public, max-age=31536000, immutable" : "no-cache");
+        if (info.gz) {
+            httpd_resp_set_hdr(req, "Vary", "Accept-Encoding");
+        }
         if (is_font) {
             httpd_resp_set_hdr(req, "Access-Control-Allow-Origin", "*");
         }
+
+        if (request_header_contains(req, "If-None-Match", etag)) {
+            ESP_LOGI(TAG, "Serving embedded file: %s (304 Not Modified)", file_path);
+            httpd_resp_set_status(req, "304 Not Modified");
+            esp_err_t send_err = httpd_resp_send(req, NULL, 0);
+            note_http_error("static_file_handler:embedded_304", send_err);
+            return send_err;
+        }
+
         httpd_resp_set_type(req, mime_type);
-        esp_err_t send_err = httpd_resp_send(req, file_start, file_size);
+        esp_err_t send_err;
+        if (use_gz) {
+            ESP_LOGI(TAG, "Serving embedded file: %s (Size: %d, gzip %d)", file_path, (int)file_size, (int)info.gz_len);
+            httpd_resp_set_hdr(req, "Content-Encoding", "gzip");
+            send_err = httpd_resp_send(req, (const char *)info.gz, info.gz_len);
+        } else {
+            ESP_LOGI(TAG, "Serving embedded file: %s (Size: %d)", file_path, (int)file_size);
+            send_err = httpd_resp_send(req, file_start, file_size);
+        }
         note_http_error("static_file_handler:embedded_send", send_err);
         return send_err;
     } else {
@@ -1710,32 +2712,7 @@ static esp_err_t static_file_handler(httpd_req_t *req) {
             return ESP_FAIL;
         }
         
-        FILE* f = fopen(filepath, "r");
-        if (!f) {
-            ESP_LOGE(TAG, "Failed to open allowed SD file: %s", filepath);
-            esp_err_t send_404_err = httpd_resp_send_404(req);
-            note_http_error("static_file_handler:sd_open_404", send_404_err);
-            return ESP_FAIL;
-        }
-
-        httpd_resp_set_type(req, get_mime_type(filepath));
-        
-        char sendbuf[1024];
-        size_t chunksize;
-        while ((chunksize = fread(sendbuf, 1, sizeof(sendbuf), f)) > 0) {
-            esp_err_t chunk_err = httpd_resp_send_chunk(req, sendbuf, chunksize);
-            if (chunk_err != ESP_OK) {
-                note_http_error("static_file_handler:sd_chunk", chunk_err);
-                fclose(f);
-                esp_err_t end_err = httpd_resp_send_chunk(req, NULL, 0);
-                note_http_error("static_file_handler:sd_end_chunk_fail", end_err);
-                return chunk_err;
-            }
-        }
-        fclose(f);
-        esp_err_t end_err = httpd_resp_send_chunk(req, NULL, 0);
-        note_http_error("static_file_handler:sd_end_chunk", end_err);
-        return end_err;
+        return serve_sd_file(req, filepath, (int64_t)st.st_size);
     }
 }
 
@@ -1895,14 +2872,192 @@ void WebManager::setupMdns() {
     ESP_LOGI(TAG, "mDNS started: http://dial-a-charmer.local");
 }
 
+// --- Server-Sent Events (/api/events) ---
+// The client list and all socket writes are only touched from the httpd task
+// (handlers, httpd_queue_work callbacks and the close callback).
+static httpd_handle_t s_httpd = NULL;
+static int s_sse_fds[APP_SSE_MAX_CLIENTS];
+static volatile int s_sse_client_count = 0;
+static uint32_t s_sse_log_seq = 0; // Last log line pushed to clients
+static esp_timer_handle_t s_sse_timer = NULL;
+static volatile bool s_sse_tick_pending = false;
+#if APP_WEB_SSE_DIAG_LOG
+static uint32_t s_sse_events = 0;
+static uint32_t s_sse_bytes = 0;
+static uint32_t s_sse_diag_ticks = 0;
+#endif
+
+static void sse_remove_client(int fd) {
+    for (int i = 0; i < s_sse_client_count; ++i) {
+        if (s_sse_fds[i] != fd) continue;
+        s_sse_fds[i] = s_sse_fds[s_sse_client_count - 1];
+        s_sse_client_count--;
+        ESP_LOGI(TAG, "Event stream closed (fd %d, %d left)", fd, s_sse_client_count);
+        if (s_sse_client_count == 0 && s_sse_timer) {
+            esp_timer_stop(s_sse_timer);
+        }
+        return;
+    }
+}
+
+// httpd close_fn: forget the socket before its fd number can be reused
+static void web_close_session(httpd_handle_t hd, int sockfd) {
+    sse_remove_client(sockfd);
+    close(sockfd);
+}
+
+static void sse_broadcast(const char *msg, size_t len) {
+    for (int i = s_sse_client_count - 1; i >= 0; --i) {
+        int fd = s_sse_fds[i];
+        size_t off = 0;
+        while (off < len) {
+            int sent = httpd_socket_send(s_httpd, fd, msg + off, len - off, 0);
+            if (sent <= 0) break;
+            off += sent;
+        }
+        if (off < len) {
+            sse_remove_client(fd);
+            httpd_sess_trigger_close(s_httpd, fd);
+        }
+    }
+#if APP_WEB_SSE_DIAG_LOG
+    s_sse_events++;
+    s_sse_bytes += len;
+#endif
+}
+
+static bool string_sink(void *ctx, const char *data, size_t len) {
+    static_cast<std::string *>(ctx)->append(data, len);
+    return true;
+}
+
+// Periodic push: clock and any log lines added since the last tick
+static void sse_tick_work(void *arg) {
+    s_sse_tick_pending = false;
+    if (s_sse_client_count == 0) return;
+
+    struct tm now = TimeManager::getCurrentTime();
+    char msg[64];
+    int n = strftime(msg, sizeof(msg), "event: time\ndata: {\"time\":\"%H:%M:%S\"}\n\n", &now);
+    sse_broadcast(msg, n);
+
+    char lines[LOG_LINE_COUNT][LOG_LINE_MAX];
+    size_t count = 0;
+    portENTER_CRITICAL(&s_log_mux);
+    uint32_t fresh = s_log_seq - s_sse_log_seq;
+    s_sse_log_seq = s_log_seq;
+    count = fresh < s_log_count ? fresh : s_log_count;
+    size_t start = (s_log_head + LOG_LINE_COUNT - count) % LOG_LINE_COUNT;
+    for (size_t i = 0; i < count; ++i) {
+        size_t idx = (start + i) % LOG_LINE_COUNT;
+        strncpy(lines[i], s_log_lines[idx], LOG_LINE_MAX - 1);
+        lines[i][LOG_LINE_MAX - 1] = '\0';
+    }
+    portEXIT_CRITICAL(&s_log_mux);
+
+    if (count > 0) {
+        std::string body = "event: log\ndata: ";
+        JsonWriter out(string_sink, &body);
+        out.beginObject();
+        out.key("lines");
+        out.beginArray();
+        for (size_t i = 0; i < count; ++i) {
+            char compacted[LOG_LINE_MAX];
+            compact_log_line(lines[i], compacted, sizeof(compacted));
+            out.value(compacted);
+        }
+        out.endArray();
+        out.endObject();
+        out.finish();
+        body.append("\n\n");
+        sse_broadcast(body.data(), body.size());
+    }
+
+#if APP_WEB_SSE_DIAG_LOG
+    if (++s_sse_diag_ticks * APP_SSE_TICK_MS >= 60000) {
+        ESP_LOGI(TAG, "SSE: clients=%d events=%lu bytes=%lu poll_requests=%lu (last minute)", s_sse_client_count,
+                 (unsigned long)s_sse_events, (unsigned long)s_sse_bytes, (unsigned long)s_poll_requests);
+        s_sse_diag_ticks = 0;
+        s_sse_events = 0;
+        s_sse_bytes = 0;
+        s_poll_requests = 0;
+    }
+#endif
+}
+
+static void sse_timer_cb(void *arg) {
+    if (s_sse_client_count == 0 || s_sse_tick_pending) return;
+    s_sse_tick_pending = true;
+    if (httpd_queue_work(s_httpd, sse_tick_work, NULL) != ESP_OK) {
+        s_sse_tick_pending = false;
+    }
+}
+
+// Queued from notifyState(); arg is a malloc'd event message
+static void sse_send_work(void *arg) {
+    char *msg = static_cast<char *>(arg);
+    sse_broadcast(msg, strlen(msg));
+    free(msg);
+}
+
+void WebManager::notifyState(const char *event, const char *json) {
+    if (!s_httpd || s_sse_client_count == 0 || !event || !json) return;
+    size_t len = strlen(event) + strlen(json) + 24;
+    char *msg = (char *)malloc(len);
+    if (!msg) return;
+    snprintf(msg, len, "event: %s\ndata: %s\n\n", event, json);
+    if (httpd_queue_work(s_httpd, sse_send_work, msg) != ESP_OK) {
+        free(msg);
+    }
+}
+
+// Keeps the socket open after returning; events are written by the work
+// callbacks above until the client disconnects.
+static esp_err_t api_events_handler(httpd_req_t *req) {
+    if (s_sse_client_count >= APP_SSE_MAX_CLIENTS) {
+        httpd_resp_set_status(req, "503 Service Unavailable");
+        httpd_resp_set_hdr(req, "Retry-After", "10");
+        return httpd_resp_send(req, "Too many event streams", HTTPD_RESP_USE_STRLEN);
+    }
+
+    static const char head[] = "HTTP/1.1 200 OK\r\nContent-Type: text/event-stream\r\n"
+                               "Cache-Control: no-cache\r\n\r\nretry: 3000\n\n";
+    esp_err_t err = send_raw(req, head, sizeof(head) - 1);
+    if (err != ESP_OK) {
+        note_http_error("api_events_handler:head", err);
+        return err;
+    }
+
+    int fd = httpd_req_to_sockfd(req);
+    s_sse_fds[s_sse_client_count++] = fd;
+    if (s_sse_client_count == 1) {
+        // Clients load the backlog from /api/logs; the stream only carries new lines
+        portENTER_CRITICAL(&s_log_mux);
+        s_sse_log_seq = s_log_seq;
+        portEXIT_CRITICAL(&s_log_mux);
+        esp_timer_start_periodic(s_sse_timer, (uint64_t)APP_SSE_TICK_MS * 1000);
+    }
+    ESP_LOGI(TAG, "Event stream opened (fd %d, %d active)", fd, s_sse_client_count);
+    return ESP_OK;
+}
+
 void WebManager::setupWebServer() {
     httpd_config_t config = HTTPD_DEFAULT_CONFIG();
-    config.max_uri_handlers = 15;
+    config.max_uri_handlers = 20;
     config.stack_size = 16384; // Larger stack to avoid httpd task overflow
     config.uri_match_fn = httpd_uri_match_wildcard; // Enable wildcard matching
+    config.close_fn = web_close_session; // Drops event-stream clients on disconnect
 
     ESP_LOGI(TAG, "Starting Web Server...");
     if (httpd_start(&server, &config) == ESP_OK) {
+        s_httpd = server;
+        if (!s_sse_timer) {
+            esp_timer_create_args_t timer_args = {};
+            timer_args.callback = sse_timer_cb;
+            timer_args.name = "sse_tick";
+            esp_timer_create(&timer_args, &s_sse_timer);
+        }
+
         // API Handlers (Specific)
         httpd_uri_t status_uri = {
             .uri       = "/api/status",
@@ -1960,6 +3115,14 @@ void WebManager::setupWebServer() {
         };
         httpd_register_uri_handler(server, &pb_get_uri);
 
+        httpd_uri_t pb_post_uri = {
+            .uri       = "/api/phonebook",
+            .method    = HTTP_POST,
+            .handler   = api_phonebook_post_handler,
+            .user_ctx  = NULL
+        };
+        httpd_register_uri_handler(server, &pb_post_uri);
+
         httpd_uri_t logs_uri = {
             .uri       = "/api/logs",
             .method    = HTTP_GET,
@@ -1984,6 +3147,30 @@ void WebManager::setupWebServer() {
         };
         httpd_register_uri_handler(server, &logs_clear_uri);
 
+        httpd_uri_t input_trace_uri = {
+            .uri       = "/api/input/trace",
+            .method    = HTTP_GET,
+            .handler   = api_input_trace_handler,
+            .user_ctx  = NULL
+        };
+        httpd_register_uri_handler(server, &input_trace_uri);
+
+        httpd_uri_t events_uri = {
+            .uri       = "/api/events",
+            .method    = HTTP_GET,
+            .handler   = api_events_handler,
+            .user_ctx  = NULL
+        };
+        httpd_register_uri_handler(server, &events_uri);
+
+        httpd_uri_t state_uri = {
+            .uri       = "/api/state",
+            .method    = HTTP_GET,
+            .handler   = api_state_handler,
+            .user_ctx  = NULL
+        };
+        httpd_register_uri_handler(server, &state_uri);
+
         httpd_uri_t time_uri = {
             .uri       = "/api/time",
             .method    = HTTP_GET,
@@ -2000,6 +3187,14 @@ void WebManager::setupWebServer() {
         };
         httpd_register_uri_handler(server, &ota_uri);
 
+        httpd_uri_t ota_status_uri = {
+            .uri       = "/api/ota/status",
+            .method    = HTTP_GET,
+            .handler   = api_ota_status_handler,
+            .user_ctx  = NULL
+        };
+        httpd_register_uri_handler(server, &ota_status_uri);
+
         // Files (Catch-all)
         // Registration runs last to preserve handler precedence.
         httpd_uri_t file_uri = {
@@ -2017,6 +3212,7 @@ void WebManager::setupDnsServer() {
 }
 
 void WebManager::begin() {
+    state_version::init();
     startLogCapture();
     setupWifi();
     setupMdns();
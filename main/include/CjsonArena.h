@@ -0,0 +1,122 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "cJSON.h"
+#include "app_config.h"
+
+// Per-request bump arena for cJSON. While a CjsonArenaScope is alive, cJSON
+// allocations made by the owning task (including cJSON_malloc) come from one
+// block, preferably in PSRAM, and are released together when the scope ends.
+// Other tasks and arena overflow transparently use the regular heap.
+namespace cjson_arena {
+
+struct State {
+    TaskHandle_t owner;
+    uint8_t *base;
+    size_t size;
+    size_t used;
+    uint32_t fallbacks;
+    size_t min_largest_internal; // Lowest largest-free-block seen after a request
+};
+
+inline State g_state = {};
+inline portMUX_TYPE g_mux = portMUX_INITIALIZER_UNLOCKED;
+
+inline void *hook_malloc(size_t sz) {
+    State &st = g_state;
+    if (st.base && st.owner == xTaskGetCurrentTaskHandle()) {
+        size_t aligned = (sz + 7) & ~(size_t)7;
+        if (aligned <= st.size - st.used) {
+            void *p = st.base + st.used;
+            st.used += aligned;
+            return p;
+        }
+        st.fallbacks++;
+    }
+    return malloc(sz);
+}
+
+inline void hook_free(void *ptr) {
+    const State &st = g_state;
+    const uint8_t *p = (const uint8_t *)ptr;
+    if (st.base && p >= st.base && p < st.base + st.size) {
+        return; // Released with the whole arena
+    }
+    free(ptr);
+}
+
+inline void install_hooks() {
+    static bool installed = false;
+    if (installed) return;
+    cJSON_Hooks hooks = {};
+    hooks.malloc_fn = hook_malloc;
+    hooks.free_fn = hook_free;
+    cJSON_InitHooks(&hooks);
+    installed = true;
+}
+
+} // namespace cjson_arena
+
+class CjsonArenaScope {
+public:
+    explicit CjsonArenaScope(size_t size) {
+        cjson_arena::install_hooks();
+
+        uint8_t *block = (uint8_t *)heap_caps_malloc(size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        if (!block) block = (uint8_t *)heap_caps_malloc(size, MALLOC_CAP_8BIT);
+        if (!block) return;
+
+        cjson_arena::State &st = cjson_arena::g_state;
+        portENTER_CRITICAL(&cjson_arena::g_mux);
+        if (!st.base) {
+            st.owner = xTaskGetCurrentTaskHandle();
+            st.size = size;
+            st.used = 0;
+            st.fallbacks = 0;
+            st.base = block;
+            _block = block;
+        }
+        portEXIT_CRITICAL(&cjson_arena::g_mux);
+        if (!_block) heap_caps_free(block); // Another request owns the arena
+    }
+
+    ~CjsonArenaScope() {
+        if (!_block) return;
+        cjson_arena::State &st = cjson_arena::g_state;
+        size_t used = st.used;
+        uint32_t fallbacks = st.fallbacks;
+
+        portENTER_CRITICAL(&cjson_arena::g_mux);
+        st.base = NULL;
+        st.owner = NULL;
+        portEXIT_CRITICAL(&cjson_arena::g_mux);
+        heap_caps_free(_block);
+
+        size_t largest = heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+        if (st.min_largest_internal == 0 || largest < st.min_largest_internal) {
+            st.min_largest_internal = largest;
+        }
+#if APP_WEB_HEAP_DIAG_LOG
+        ESP_LOGI("JSON_ARENA", "used %u/%u bytes, %u heap fallbacks, largest internal block %u (lowest %u)",
+                 (unsigned)used, (unsigned)st.size, (unsigned)fallbacks,
+                 (unsigned)largest, (unsigned)st.min_largest_internal);
+#else
+        (void)used;
+        (void)fallbacks;
+#endif
+    }
+
+    CjsonArenaScope(const CjsonArenaScope &) = delete;
+    CjsonArenaScope &operator=(const CjsonArenaScope &) = delete;
+
+    bool active() const { return _block != NULL; }
+
+private:
+    uint8_t *_block = NULL;
+};
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <string_view>
+#include <type_traits>
+
+// Minimal streaming JSON writer. Output is staged in a fixed buffer and handed
+// to a sink (e.g. httpd_resp_send_chunk) whenever it fills up, so memory use
+// does not depend on the size of the document.
+class JsonWriter {
+public:
+    typedef bool (*sink_t)(void *ctx, const char *data, size_t len);
+
+    JsonWriter(sink_t sink, void *ctx) : _sink(sink), _ctx(ctx) {}
+
+    void beginObject() { open('{'); }
+    void endObject() { close('}'); }
+    void beginArray() { open('['); }
+    void endArray() { close(']'); }
+
+    void key(std::string_view name) {
+        separator();
+        writeString(name);
+        put(':');
+        _after_key = true;
+    }
+
+    void value(std::string_view str) { separator(); writeString(str); }
+    void value(const char *str) { value(std::string_view(str ? str : "")); }
+    void value(bool b) { separator(); write(b ? "true" : "false"); }
+
+    template <typename T, typename std::enable_if<std::is_integral<T>::value && !std::is_same<T, bool>::value, int>::type = 0>
+    void value(T number) {
+        char tmp[24];
+        int n = std::is_signed<T>::value ? snprintf(tmp, sizeof(tmp), "%lld", (long long)number)
+                                         : snprintf(tmp, sizeof(tmp), "%llu", (unsigned long long)number);
+        separator();
+        write(std::string_view(tmp, n));
+    }
+
+    template <typename T>
+    void field(std::string_view name, T v) {
+        key(name);
+        value(v);
+    }
+
+    // Sends any buffered output; false if the sink failed at any point
+    bool finish() {
+        flush();
+        return !_failed;
+    }
+
+private:
+    void open(char c) {
+        separator();
+        put(c);
+        if (_depth < 31) _depth++;
+        _comma_mask &= ~(1u << _depth);
+    }
+
+    void close(char c) {
+        if (_depth > 0) _depth--;
+        put(c);
+    }
+
+    void separator() {
+        if (_after_key) {
+            _after_key = false;
+            return;
+        }
+        if (_comma_mask & (1u << _depth)) put(',');
+        _comma_mask |= (1u << _depth);
+    }
+
+    void writeString(std::string_view str) {
+        put('"');
+        for (char c : str) {
+            switch (c) {
+                case '"': write("\\\""); break;
+                case '\\': write("\\\\"); break;
+                case '\n': write("\\n"); break;
+                case '\r': write("\\r"); break;
+                case '\t': write("\\t"); break;
+                default:
+                    if ((unsigned char)c < 0x20) {
+                        char esc[8];
+                        snprintf(esc, sizeof(esc), "\\u%04x", (unsigned)(unsigned char)c);
+                        write(esc);
+                    } else {
+                        put(c);
+                    }
+            }
+        }
+        put('"');
+    }
+
+    void write(std::string_view str) {
+        for (char c : str) put(c);
+    }
+
+    void put(char c) {
+        if (_len == sizeof(_buf)) flush();
+        _buf[_len++] = c;
+    }
+
+    void flush() {
+        if (_len > 0 && !_failed && !_sink(_ctx, _buf, _len)) _failed = true;
+        _len = 0;
+    }
+
+    sink_t _sink;
+    void *_ctx;
+    char _buf[256];
+    size_t _len = 0;
+    uint32_t _comma_mask = 0; // Bit per nesting level: a value was already written
+    int _depth = 0;
+    bool _after_key = false;
+    bool _failed = false;
+};
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <atomic>
+#include <stdint.h>
+#include <time.h>
+
+// Broken-down local time for one wall-clock second, keyed by the epoch second
+// and a generation the owner bumps on SNTP sync and timezone changes.
+// Published with a sequence lock: readers never block, an odd sequence means
+// a writer is active, and a reader that races a writer just misses.
+class LocalTimeCache {
+public:
+    // false on a miss (other second or generation) or a concurrent publish
+    bool read(time_t now, uint32_t gen, struct tm *out) const {
+        for (int attempt = 0; attempt < 3; ++attempt) {
+            uint32_t seq1 = _seq.load(std::memory_order_acquire);
+            if (seq1 & 1) continue; // Writer active
+            time_t epoch = _epoch;
+            uint32_t cached_gen = _gen;
+            struct tm local = _local;
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (_seq.load(std::memory_order_relaxed) != seq1) continue;
+            if (epoch != now || cached_gen != gen) return false;
+            *out = local;
+            return true;
+        }
+        return false;
+    }
+
+    void publish(time_t now, uint32_t gen, const struct tm &local) {
+        uint32_t seq = _seq.load(std::memory_order_relaxed);
+        // Only one writer publishes; a concurrent caller just keeps its own result
+        if ((seq & 1) || !_seq.compare_exchange_strong(seq, seq + 1, std::memory_order_acquire)) return;
+        std::atomic_thread_fence(std::memory_order_release);
+        _epoch = now;
+        _gen = gen;
+        _local = local;
+        _seq.store(seq + 2, std::memory_order_release);
+    }
+
+private:
+    std::atomic<uint32_t> _seq{0};
+    time_t _epoch = 0;
+    uint32_t _gen = 0;
+    struct tm _local = {};
+};
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// Lock-free ring of variable-length log records: many producers (any task,
+// either core), one consumer. A producer reserves space with a single CAS,
+// copies its bytes and publishes the record header last. The consumer zeroes
+// every record it has read, so an unpublished header always reads as 0.
+template <size_t kBytes>
+class LogRing {
+    static_assert(kBytes >= 1024 && (kBytes & (kBytes - 1)) == 0, "ring size must be a power of two");
+
+public:
+    struct Record {
+        int64_t time_us; // esp_timer time of the log call
+        const char *text; // Not terminated; valid only inside the drain callback
+        size_t len;
+    };
+
+    static const size_t kMaxText = 0xFFFF;
+
+    // false when the ring is full; the record is dropped and counted
+    bool push(int64_t time_us, const char *text, size_t len) {
+        if (len > kMaxText) len = kMaxText;
+        const uint32_t need = recordSize(len);
+        uint32_t pos = _reserve.load(std::memory_order_relaxed);
+        uint32_t pad;
+        do {
+            uint32_t off = pos & (kBytes - 1);
+            pad = (kBytes - off < need) ? kBytes - off : 0; // Records never wrap
+            if (pos + pad + need - _tail.load(std::memory_order_acquire) > kBytes) {
+                _dropped.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+        } while (!_reserve.compare_exchange_weak(pos, pos + pad + need, std::memory_order_acq_rel,
+                                                 std::memory_order_relaxed));
+
+        if (pad) publish(pos, kPadFlag | pad);
+        uint8_t *at = bytes() + ((pos + pad) & (kBytes - 1));
+        memcpy(at + kHeader, &time_us, sizeof(time_us));
+        memcpy(at + kHeader + sizeof(time_us), text, len);
+        publish(pos + pad, kDataFlag | (uint32_t)len);
+        return true;
+    }
+
+    // Hands published records to fn(const Record &) in order; stops at the
+    // first one still being written. Single consumer only.
+    template <typename Fn>
+    size_t drain(Fn &&fn) {
+        uint32_t tail = _tail.load(std::memory_order_relaxed);
+        size_t count = 0;
+        for (;;) {
+            uint32_t off = tail & (kBytes - 1);
+            uint32_t hdr = __atomic_load_n(&_words[off / 4], __ATOMIC_ACQUIRE);
+            if (hdr == 0) break;
+            uint32_t size = hdr & 0xFFFF;
+            if (hdr & kDataFlag) {
+                Record rec;
+                memcpy(&rec.time_us, bytes() + off + kHeader, sizeof(rec.time_us));
+                rec.text = (const char *)bytes() + off + kHeader + sizeof(rec.time_us);
+                rec.len = size;
+                fn(rec);
+                size = recordSize(size);
+                count++;
+            }
+            memset(bytes() + off, 0, size);
+            tail += size;
+            _tail.store(tail, std::memory_order_release);
+        }
+        return count;
+    }
+
+    // Records lost to a full ring since the last call
+    uint32_t takeDropped() { return _dropped.exchange(0, std::memory_order_relaxed); }
+
+private:
+    static const uint32_t kHeader = 4;
+    static const uint32_t kDataFlag = 0x80000000u;
+    static const uint32_t kPadFlag = 0x40000000u;
+
+    static uint32_t recordSize(size_t len) {
+        return (kHeader + sizeof(int64_t) + (uint32_t)len + 3) & ~3u;
+    }
+
+    void publish(uint32_t pos, uint32_t hdr) {
+        __atomic_store_n(&_words[(pos & (kBytes - 1)) / 4], hdr, __ATOMIC_RELEASE);
+    }
+
+    uint8_t *bytes() { return reinterpret_cast<uint8_t *>(_words); }
+
+    uint32_t _words[kBytes / 4] = {};
+    std::atomic<uint32_t> _reserve{0};
+    std::atomic<uint32_t> _tail{0};
+    std::atomic<uint32_t> _dropped{0};
+};
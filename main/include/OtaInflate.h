@@ -0,0 +1,196 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "esp_err.h"
+#include "esp_heap_caps.h"
+#include "esp_rom_crc.h"
+#include "rom/miniz.h"
+
+// Streaming gunzip for OTA images, built on the tinfl inflater in ROM.
+// Compressed bytes may arrive in pieces of any size; inflated data is handed
+// to the sink straight out of the 32 KB dictionary window, so RAM use is fixed
+// (~43 KB, PSRAM when available) however large the image is. The gzip CRC32
+// and length trailer are checked in finish().
+class GzipInflater {
+public:
+    typedef esp_err_t (*sink_t)(void *ctx, const uint8_t *data, size_t len);
+
+    static bool isGzip(const uint8_t *data, size_t len) {
+        return len >= 2 && data[0] == 0x1f && data[1] == 0x8b;
+    }
+
+    ~GzipInflater() { end(); }
+
+    esp_err_t begin(sink_t sink, void *ctx) {
+        end();
+        _w = (Window *)heap_caps_malloc(sizeof(Window), MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        if (!_w) _w = (Window *)heap_caps_malloc(sizeof(Window), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+        if (!_w) return ESP_ERR_NO_MEM;
+        tinfl_init(&_w->decomp);
+        _sink = sink;
+        _ctx = ctx;
+        _stage = STAGE_HEADER;
+        _pos = 0;
+        _dict_ofs = 0;
+        _crc = 0;
+        _out_len = 0;
+        return ESP_OK;
+    }
+
+    void end() {
+        free(_w);
+        _w = nullptr;
+    }
+
+    // ESP_ERR_INVALID_ARG: not a gzip/DEFLATE stream, ESP_ERR_INVALID_RESPONSE: corrupt data
+    esp_err_t feed(const uint8_t *data, size_t len) {
+        if (!_w) return ESP_ERR_INVALID_STATE;
+        while (len > 0) {
+            if (_stage == STAGE_DEFLATE) {
+                size_t used = 0;
+                esp_err_t err = inflate(data, len, &used);
+                if (err != ESP_OK) return err;
+                data += used;
+                len -= used;
+                continue;
+            }
+            if (_stage == STAGE_DONE) return ESP_OK; // Trailing padding is ignored
+            esp_err_t err = headerByte(*data++);
+            len--;
+            if (err != ESP_OK) return err;
+        }
+        return ESP_OK;
+    }
+
+    // ESP_OK only once a complete stream with matching CRC32 and length was seen
+    esp_err_t finish() const {
+        return _stage == STAGE_DONE ? ESP_OK : ESP_ERR_INVALID_SIZE;
+    }
+
+    uint32_t outputSize() const { return _out_len; }
+
+private:
+    enum Stage : uint8_t {
+        STAGE_HEADER = 0, // Fixed 10-byte member header
+        STAGE_EXTRA_LEN,
+        STAGE_EXTRA,
+        STAGE_NAME,
+        STAGE_COMMENT,
+        STAGE_HCRC,
+        STAGE_DEFLATE,
+        STAGE_TRAILER,    // CRC32 + ISIZE, little endian
+        STAGE_DONE
+    };
+
+    enum : uint8_t { FLAG_HCRC = 0x02, FLAG_EXTRA = 0x04, FLAG_NAME = 0x08, FLAG_COMMENT = 0x10 };
+
+    struct Window {
+        tinfl_decompressor decomp;
+        uint8_t dict[TINFL_LZ_DICT_SIZE];
+    };
+
+    // Next optional header field after the one just finished
+    void nextHeaderStage(Stage after) {
+        _pos = 0;
+        if (after < STAGE_EXTRA_LEN && (_flags & FLAG_EXTRA)) { _stage = STAGE_EXTRA_LEN; return; }
+        if (after < STAGE_NAME && (_flags & FLAG_NAME)) { _stage = STAGE_NAME; return; }
+        if (after < STAGE_COMMENT && (_flags & FLAG_COMMENT)) { _stage = STAGE_COMMENT; return; }
+        if (after < STAGE_HCRC && (_flags & FLAG_HCRC)) { _stage = STAGE_HCRC; return; }
+        _stage = STAGE_DEFLATE;
+    }
+
+    esp_err_t headerByte(uint8_t b) {
+        switch (_stage) {
+            case STAGE_HEADER:
+                if ((_pos == 0 && b != 0x1f) || (_pos == 1 && b != 0x8b) || (_pos == 2 && b != 8)) {
+                    return ESP_ERR_INVALID_ARG;
+                }
+                if (_pos == 3) _flags = b;
+                if (++_pos == 10) nextHeaderStage(STAGE_HEADER);
+                return ESP_OK;
+            case STAGE_EXTRA_LEN:
+                _skip = (_pos == 0) ? b : (_skip | ((uint32_t)b << 8));
+                if (++_pos == 2) {
+                    _pos = 0;
+                    if (_skip > 0) _stage = STAGE_EXTRA;
+                    else nextHeaderStage(STAGE_EXTRA);
+                }
+                return ESP_OK;
+            case STAGE_EXTRA:
+                if (--_skip == 0) nextHeaderStage(STAGE_EXTRA);
+                return ESP_OK;
+            case STAGE_NAME:
+            case STAGE_COMMENT:
+                if (b == 0) nextHeaderStage(_stage);
+                return ESP_OK;
+            case STAGE_HCRC:
+                if (++_pos == 2) nextHeaderStage(STAGE_HCRC);
+                return ESP_OK;
+            case STAGE_TRAILER:
+                _trailer[_pos++] = b;
+                if (_pos == 8) {
+                    uint32_t crc = _trailer[0] | (_trailer[1] << 8) | (_trailer[2] << 16) | ((uint32_t)_trailer[3] << 24);
+                    uint32_t isize = _trailer[4] | (_trailer[5] << 8) | (_trailer[6] << 16) | ((uint32_t)_trailer[7] << 24);
+                    if (crc != _crc || isize != _out_len) return ESP_ERR_INVALID_CRC;
+                    _stage = STAGE_DONE;
+                }
+                return ESP_OK;
+            default:
+                return ESP_ERR_INVALID_STATE;
+        }
+    }
+
+    // The ROM tinfl (miniz 1.x) reads ahead into its bit buffer and does not
+    // hand unused whole bytes back on DONE; they already belong to the trailer.
+    esp_err_t takeBitBuffer() {
+        uint32_t bits = _w->decomp.m_num_bits;
+        uint64_t buf = (uint64_t)_w->decomp.m_bit_buf >> (bits & 7); // Rest of the last DEFLATE byte
+        bits -= bits & 7;
+        for (; bits >= 8 && _stage != STAGE_DONE; bits -= 8, buf >>= 8) {
+            esp_err_t err = headerByte((uint8_t)buf);
+            if (err != ESP_OK) return err;
+        }
+        return ESP_OK;
+    }
+
+    // Runs tinfl over the input until it needs more or the DEFLATE stream ends
+    esp_err_t inflate(const uint8_t *in, size_t len, size_t *used) {
+        *used = 0;
+        for (;;) {
+            size_t in_size = len - *used;
+            size_t out_size = TINFL_LZ_DICT_SIZE - _dict_ofs;
+            tinfl_status status = tinfl_decompress(&_w->decomp, in + *used, &in_size, _w->dict,
+                                                   _w->dict + _dict_ofs, &out_size, TINFL_FLAG_HAS_MORE_INPUT);
+            *used += in_size;
+            if (out_size > 0) {
+                const uint8_t *out = _w->dict + _dict_ofs;
+                _crc = esp_rom_crc32_le(_crc, out, out_size);
+                _out_len += out_size;
+                esp_err_t err = _sink(_ctx, out, out_size);
+                if (err != ESP_OK) return err;
+                _dict_ofs = (_dict_ofs + out_size) & (TINFL_LZ_DICT_SIZE - 1);
+            }
+            if (status == TINFL_STATUS_DONE) {
+                _stage = STAGE_TRAILER;
+                _pos = 0;
+                return takeBitBuffer();
+            }
+            if (status < 0) return ESP_ERR_INVALID_RESPONSE;
+            if (status == TINFL_STATUS_NEEDS_MORE_INPUT && *used == len) return ESP_OK;
+        }
+    }
+
+    Window *_w = nullptr;
+    sink_t _sink = nullptr;
+    void *_ctx = nullptr;
+    Stage _stage = STAGE_HEADER;
+    uint8_t _flags = 0;
+    uint8_t _trailer[8];
+    uint32_t _pos = 0;
+    uint32_t _skip = 0;
+    size_t _dict_ofs = 0;
+    uint32_t _crc = 0;
+    uint32_t _out_len = 0;
+};
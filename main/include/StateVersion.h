@@ -0,0 +1,55 @@
+#pragma once
+
+#include <stdint.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_random.h"
+
+// Versioned view of the state the web UI loads (/api/state). Every change
+// takes the next global version and stamps it on its section, so a client
+// that knows version N only needs the sections stamped after N.
+enum StateSection : uint8_t {
+    STATE_SETTINGS = 0, // NVS settings, alarms, timezone
+    STATE_RINGTONES,    // SD ringtone list (only changes across reboots)
+    STATE_PHONEBOOK,
+    STATE_SECTION_COUNT
+};
+
+namespace state_version {
+
+struct Snapshot {
+    uint32_t base;
+    uint32_t current;
+    uint32_t section[STATE_SECTION_COUNT];
+};
+
+inline portMUX_TYPE g_mux = portMUX_INITIALIZER_UNLOCKED;
+inline Snapshot g_state = {};
+
+// Random base per boot, so a version from before a reboot never matches
+inline void init() {
+    uint32_t base = (esp_random() & 0x3FFFFF00u) + 0x100u;
+    portENTER_CRITICAL(&g_mux);
+    if (g_state.base == 0) {
+        g_state.base = base;
+        g_state.current = base;
+        for (uint32_t &v : g_state.section) v = base;
+    }
+    portEXIT_CRITICAL(&g_mux);
+}
+
+inline Snapshot snapshot() {
+    portENTER_CRITICAL(&g_mux);
+    Snapshot snap = g_state;
+    portEXIT_CRITICAL(&g_mux);
+    return snap;
+}
+
+inline void bump(StateSection s) {
+    portENTER_CRITICAL(&g_mux);
+    if (g_state.base != 0) { // Before init() the first snapshot is complete anyway
+        g_state.section[s] = ++g_state.current;
+    }
+    portEXIT_CRITICAL(&g_mux);
+}
+
+} // namespace state_version
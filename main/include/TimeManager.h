@@ -2,7 +2,9 @@
 #include <time.h>
 #include "esp_err.h"
 
+#include <stdint.h>
 #include <string>
+#include <vector>
 
 struct DayAlarm {
     int hour;
@@ -13,6 +15,26 @@ struct DayAlarm {
     std::string ringtone;
 };
 
+// Full week, indexed like dayIndex (0=Sunday ... 6=Saturday)
+struct WeekSchedule {
+    DayAlarm days[7];
+};
+
+// Additional alarm beyond the weekday slots: recurring on a set of weekdays or one-shot on a date
+struct AlarmEntry {
+    uint16_t id;        // Assigned by setExtraAlarms()
+    uint8_t days;       // Bit mask, bit0=Sunday ... bit6=Saturday; 0 = one-shot
+    int hour;
+    int minute;
+    int year;           // One-shot date (local time), ignored for recurring alarms
+    int month;          // 1-12
+    int mday;
+    bool active;
+    bool volumeRamp;
+    bool useRandomMsg;
+    std::string ringtone;
+};
+
 class TimeManager {
 public:
     static void init();
@@ -20,12 +42,25 @@ public:
     // dayIndex: 0=Sunday, 1=Monday, ..., 6=Saturday
     static void setAlarm(int dayIndex, int hour, int minute, bool active, bool volumeRamp, bool useMsg, const char* ringtone); 
     static DayAlarm getAlarm(int dayIndex);
+
+    // Batch save: validates and writes all seven days with a single NVS commit
+    static esp_err_t setSchedule(const WeekSchedule &schedule);
+    static WeekSchedule getSchedule();
+
+    // Additional alarms (ids >= kFirstExtraAlarmId); setExtraAlarms replaces the whole list
+    static constexpr uint16_t kFirstExtraAlarmId = 7;
+    static std::vector<AlarmEntry> getExtraAlarms();
+    static esp_err_t setExtraAlarms(const std::vector<AlarmEntry> &alarms);
+
+    // Next trigger across all alarms (front of the schedule queue)
+    static bool getNextAlarm(time_t *out_epoch, DayAlarm *out_alarm);
+    static DayAlarm getRingingAlarm(); // Alarm that caused the last checkAlarm() trigger
     
     static bool checkAlarm(); // Returns true if alarm trigger condition is met ONE TIME
     static bool isAlarmRinging();
     static void stopAlarm();
     
-    static struct tm getCurrentTime();
+    static struct tm getCurrentTime(); // Served from a per-second cache, safe from any task
     static struct tm getCurrentTimeRtc();
 
     // SNTP Sync
@@ -9,6 +9,8 @@ public:
     void startAPMode();
     void startLogCapture();
     void setResetInfo(uint32_t boot_count, const char *reason, int reason_code);
+    // Push a state change to /api/events clients (any task). json is the event data object.
+    void notifyState(const char *event, const char *json);
 
 private:
     httpd_handle_t server = NULL;
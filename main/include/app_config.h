@@ -56,10 +56,17 @@
 #define APP_DIAL_TIMEOUT_MS 2000               // Timeout bis gewählte Ziffernfolge verarbeitet wird
 #define APP_DIAL_PULSE_DEBOUNCE_MS 60          // Entprellzeit pro Wählimpuls
 #define APP_DIAL_DIGIT_GAP_MS 500              // Mindestlücke zwischen zwei Ziffern
+#define APP_DIAL_GAP_ADAPTIVE 1                // Ziffernende aus gemessener Impulsperiode ableiten
+#define APP_DIAL_GAP_PERIOD_FACTOR 3           // Ziffernende nach N Impulsperioden ohne Impuls
+#define APP_DIAL_GAP_MIN_MS 250                // Untergrenze für die gelernte Ziffernlücke
+#define APP_DIAL_LEARN_MIN_SAMPLES 8           // Messungen, bevor die gelernte Lücke gilt
+#define APP_DIAL_LEARN_SAVE_INTERVAL_MS 600000 // Gelernte Periode höchstens alle 10 min im NVS sichern
 #define APP_DIALTONE_SILENCE_MS 1000           // Stille nach Dialtone, bevor neue Wiedergabe startet
 #define APP_BUSY_TIMEOUT_MS 5000               // Leerlaufzeit am Hörer bis Besetztton
 #define APP_WAV_SWITCH_DELAY_MS 35             // Kurze Wartezeit beim Umschalten zwischen WAV-Dateien
 #define APP_AUDIO_EVENT_LISTEN_MS 15           // Poll-Intervall für Audio-Event-Loop
+#define APP_INPUT_IDLE_WAIT_MS 500             // Max. Schlafzeit des Input-Tasks ohne Eingabe-Ereignis
+#define APP_INPUT_TRACE_EDGES 256              // Roh-Flanken für /api/input/trace (0 = aus)
 #define APP_OUTPUT_MUTE_DELAY_MS 30            // Mute-Haltezeit beim Stoppen/Umschalten
 #define APP_WAV_FADE_OUT_EXTRA_MS 60           // Zusatzdauer für sanfteres Fade-Out
 #define APP_WAV_FADE_IN_MS 80                  // Standard Fade-In für normale WAV-Wiedergabe
@@ -83,6 +90,7 @@
 // Timer settings
 #define APP_TIMER_MIN_MINUTES 1
 #define APP_TIMER_MAX_MINUTES 500
+#define APP_TIMER_MAX_COUNT 9                  // Gleichzeitige Küchentimer (Löschen per "01".."09")
 #define APP_DEFAULT_TIMER_RINGTONE "standard_ringtone.wav"
 
 // Snooze settings
@@ -90,6 +98,14 @@
 #define APP_SNOOZE_MIN_MINUTES 1
 #define APP_SNOOZE_MAX_MINUTES 60
 
+// Alarm schedule persistence
+#define APP_ALARM_DIAG_LOG (APP_LOGGING_MASTER && 0) // Blob-Größe und Dauer je Weckplan-Speicherung loggen
+#define APP_ALARM_MAX_EXTRA 24                 // Zusätzliche Wecker neben den 7 Wochentagen
+
+// Local time cache diagnostics (hit/miss counts and localtime_r cost)
+#define APP_TIME_DIAG_LOG (APP_LOGGING_MASTER && 0)
+#define APP_TIME_DIAG_INTERVAL_MS 600000
+
 // Software gain defaults
 #define APP_GAIN_DEFAULT_LEFT 0.5f
 #define APP_GAIN_DEFAULT_RIGHT 0.6f
@@ -115,6 +131,8 @@
 
 // OTA
 #define APP_OTA_PASSWORD "dialy1935"
+#define APP_OTA_BUF_COUNT 3                    // Empfangspuffer zwischen HTTP-Empfang und Flash-Schreiber
+#define APP_OTA_BUF_SIZE 16384                 // Bytes je Puffer (PSRAM; intern 4 KB als Fallback)
 
 // Phonebook default numbers (max 3 digits)
 #define APP_PB_NUM_PERSONA_1 "1"
@@ -126,6 +144,7 @@
 #define APP_PB_NUM_RANDOM_MIX "11"
 #define APP_PB_NUM_TIME "110"
 #define APP_PB_NUM_VOICE_MENU "0"
+#define APP_PB_FILE_MAX_BYTES 32768            // Obergrenze für phonebook.bin und POST /api/phonebook
 
 
 // Debug / Monitor
@@ -133,6 +152,14 @@
 #define SYSTEM_MONITOR_INTERVAL_MS 30000
 #define APP_DIAL_DEBUG_SERIAL (APP_LOGGING_MASTER && 0)
 #define APP_OTA_DEBUG (APP_LOGGING_MASTER && 0)
+#define APP_WEB_HEAP_DIAG_LOG (APP_LOGGING_MASTER && 0) // Heap-Tiefstand je JSON-Antwort loggen
+#define APP_WEB_SSE_DIAG_LOG (APP_LOGGING_MASTER && 0)  // Event-Stream: Events/Bytes/Requests je Minute loggen
+#define APP_LOG_CYCLES_DIAG_LOG (APP_LOGGING_MASTER && 0) // CPU-Zyklen je Log-Aufruf (Mittel/Max) loggen
+#define APP_HTTP_JSON_MAX_BODY 16384           // Maximale JSON-Body-Größe für POST /api/settings
+#define APP_HTTP_JSON_ARENA_FACTOR 4           // Arena = Body * Faktor (+1 KB) für den cJSON-Baum
+#define APP_WEB_FILE_BUF_SIZE 16384            // PSRAM-Lesepuffer für SD-Dateien (≥ FAT-Cluster)
+#define APP_SSE_MAX_CLIENTS 3                  // Gleichzeitige /api/events-Verbindungen
+#define APP_SSE_TICK_MS 1000                   // Takt für Uhrzeit und neue Logzeilen im Event-Stream
 
 // Task watchdog
 #define APP_ENABLE_TASK_WDT 1
@@ -147,7 +174,12 @@
 #define APP_SD_LOG_PATH "/sdcard/logs/app.log"
 #define APP_SD_LOG_MAX_BYTES (10 * 1024 * 1024)
 #define APP_SD_LOG_FLUSH_INTERVAL_MS 5000
-#define APP_SD_LOG_BUFFER_LINES 120
+#define APP_SD_LOG_RING_BYTES 32768           // PSRAM-Ringpuffer für fertige Zeilen (Zweierpotenz; 8 KB intern als Fallback)
+#define APP_SD_LOG_WRITE_ALIGN 4096           // Schreibblöcke enden auf dieser Grenze (FAT-Cluster)
+#define APP_SD_LOG_MAX_HOLD_MS 15000          // Unvollständigen Cluster spätestens nach dieser Zeit schreiben
+#define APP_SD_LOG_DIAG_LOG (APP_LOGGING_MASTER && 0) // Bytes und Schreib-/Sync-Dauer je Flush loggen
+#define APP_LOG_RING_BYTES 8192               // Lock-free Puffer zwischen Log-Aufruf und Drain-Task (Zweierpotenz)
+#define APP_LOG_DRAIN_MS 100                  // Takt, in dem der Drain-Task Zeilen aufbereitet
 
 // WiFi reconnect behaviour
 // 0 = infinite retries, otherwise limit before clamping the counter (no AP fallback)
@@ -155,6 +187,10 @@
 // Log every Nth retry after the first to reduce spam
 #define APP_WIFI_RETRY_LOG_EVERY 5
 
+// WiFi scan cache for /api/wifi/scan (scans run in the background)
+#define APP_WIFI_SCAN_MAX_RESULTS 20
+#define APP_WIFI_SCAN_MAX_AGE_MS 30000
+
 // mDNS resilience
 #define APP_MDNS_REANNOUNCE_INTERVAL_MS 90000
 #define APP_MDNS_REANNOUNCE_MIN_GAP_MS 15000
@@ -1,6 +1,7 @@
 #include <string.h>
 #include <string>
 #include <vector>
+#include <algorithm>
 #include <dirent.h>
 #include <strings.h>
 #include <sys/stat.h>
@@ -70,10 +71,25 @@ uint32_t g_off_hook_start_ms = 0;
 int64_t g_last_playback_finished_ms = 0;
 bool g_last_playback_was_dialtone = false;
 
+// Kitchen timers: fixed-capacity min-heap keyed by end time, so the expiry check
+// only looks at the front. Guarded by g_timer_mux (main loop + input_task).
+struct KitchenTimer {
+    uint32_t id;
+    int minutes;
+    int64_t end_ms;
+};
+
+struct KitchenTimerEndsLater {
+    bool operator()(const KitchenTimer &a, const KitchenTimer &b) const { return a.end_ms > b.end_ms; }
+};
+
+static portMUX_TYPE g_timer_mux = portMUX_INITIALIZER_UNLOCKED;
+static KitchenTimer g_timers[APP_TIMER_MAX_COUNT];
+static int g_timer_count = 0;
+static uint32_t g_timer_next_id = 1;
+
+// Pending "timer set" announcement for the most recently added timer
 struct TimerState {
-    bool active = false;
-    int minutes = 0;
-    int64_t end_ms = 0;
     bool announce_pending = false;
     bool intro_playing = false;
     int announce_minutes = 0;
@@ -345,6 +361,7 @@ static void enter_deep_sleep();
 static bool can_trigger_deep_sleep_via_button();
 static void add_number_audio(std::vector<std::string> &files, int value);
 static void log_timer_state(const char *event);
+static int timer_snapshot_sorted(KitchenTimer *out, int max_count);
 
 static const char *lang_code() {
     return app_lang_code();
@@ -390,30 +407,33 @@ static void announce_time_now() {
     start_voice_queue(files);
 }
 
+// Speaks every active timer, nearest first; the order matches the "0N" cancel codes.
 static void announce_timer_remaining() {
-    if (!g_timer_state.active) {
+    KitchenTimer timers[APP_TIMER_MAX_COUNT];
+    int count = timer_snapshot_sorted(timers, APP_TIMER_MAX_COUNT);
+    if (count == 0) {
         log_timer_state("announce_remaining_no_active_timer");
         start_voice_queue({system_path("timer_none")});
         return;
     }
 
     int64_t now_ms = esp_timer_get_time() / 1000;
-    int64_t remaining_ms = g_timer_state.end_ms - now_ms;
-    int remaining_minutes = 0;
-    if (remaining_ms > 0) {
-        remaining_minutes = (int)((remaining_ms + 59999) / 60000);
-    }
-
-    if (remaining_minutes < 0) remaining_minutes = 0;
-    if (remaining_minutes > APP_TIMER_MAX_MINUTES) remaining_minutes = APP_TIMER_MAX_MINUTES;
+    std::vector<std::string> files;
+    for (int i = 0; i < count; ++i) {
+        int64_t remaining_ms = timers[i].end_ms - now_ms;
+        int remaining_minutes = 0;
+        if (remaining_ms > 0) {
+            remaining_minutes = (int)((remaining_ms + 59999) / 60000);
+        }
+        if (remaining_minutes > APP_TIMER_MAX_MINUTES) remaining_minutes = APP_TIMER_MAX_MINUTES;
 
-    ESP_LOGI(TAG, "Timer remaining requested: %d minutes", remaining_minutes);
+        ESP_LOGI(TAG, "Timer %d/%d remaining: %d minutes", i + 1, count, remaining_minutes);
+        if (i > 0) files.push_back("/sdcard/system/silence_300ms.wav");
+        files.push_back(system_path("timer_remaining"));
+        add_number_audio(files, remaining_minutes);
+        files.push_back(system_path("minutes"));
+    }
     log_timer_state("announce_remaining");
-
-    std::vector<std::string> files;
-    files.push_back(system_path("timer_remaining"));
-    add_number_audio(files, remaining_minutes);
-    files.push_back(system_path("minutes"));
     start_voice_queue(files);
 }
 
@@ -887,31 +907,10 @@ static bool play_next_in_queue() {
 
 static bool get_next_alarm(struct tm *out_tm, DayAlarm *out_alarm) {
     if (!out_tm || !out_alarm) return false;
-    time_t now_t;
-    time(&now_t);
-    struct tm now;
-    localtime_r(&now_t, &now);
-
-    for (int i = 0; i < 7; ++i) {
-        int day = (now.tm_wday + i) % 7;
-        DayAlarm a = TimeManager::getAlarm(day);
-        if (!a.active) continue;
-
-        time_t day_t = now_t + (int64_t)i * 24 * 60 * 60;
-        struct tm t;
-        localtime_r(&day_t, &t);
-        t.tm_hour = a.hour;
-        t.tm_min = a.minute;
-        t.tm_sec = 0;
-
-        time_t candidate = mktime(&t);
-        if (candidate <= now_t) continue;
-
-        *out_tm = t;
-        *out_alarm = a;
-        return true;
-    }
-    return false;
+    time_t next_t = 0;
+    if (!TimeManager::getNextAlarm(&next_t, out_alarm)) return false;
+    localtime_r(&next_t, out_tm);
+    return true;
 }
 
 static void add_number_audio(std::vector<std::string> &files, int value) {
@@ -1099,6 +1098,7 @@ static void restore_volume_after_alarm() {
 }
 
 static void reset_alarm_state(bool restore_volume) {
+    if (g_alarm_state.active) webManager.notifyState("alarm", "{\"active\":false}");
     g_alarm_state.active = false;
     g_alarm_state.source = ALARM_NONE;
     g_alarm_state.msg_active = false;
@@ -1137,16 +1137,28 @@ static void force_alarm_volume() {
 
 static void log_timer_state(const char *event) {
     int64_t now_ms = esp_timer_get_time() / 1000;
-    int64_t remaining_ms = g_timer_state.end_ms - now_ms;
+    int count;
+    KitchenTimer nearest = {};
+    portENTER_CRITICAL(&g_timer_mux);
+    count = g_timer_count;
+    if (count > 0) nearest = g_timers[0];
+    portEXIT_CRITICAL(&g_timer_mux);
+    int64_t remaining_ms = (count > 0) ? nearest.end_ms - now_ms : 0;
     ESP_LOGI("TIMER_STATE",
-             "event=%s active=%d minutes=%d announce_pending=%d intro_playing=%d announce_minutes=%d remaining_ms=%lld",
+             "event=%s active=%d nearest_id=%u nearest_minutes=%d announce_pending=%d intro_playing=%d announce_minutes=%d remaining_ms=%lld",
              event ? event : "unknown",
-             g_timer_state.active ? 1 : 0,
-             g_timer_state.minutes,
+             count,
+             (unsigned)nearest.id,
+             nearest.minutes,
              g_timer_state.announce_pending ? 1 : 0,
              g_timer_state.intro_playing ? 1 : 0,
              g_timer_state.announce_minutes,
              remaining_ms);
+
+    char json[96];
+    snprintf(json, sizeof(json), "{\"event\":\"%s\",\"active\":%d,\"remaining_ms\":%lld}",
+             event ? event : "unknown", count, (long long)remaining_ms);
+    webManager.notifyState("timer", json);
 }
 
 static void log_snooze_state(const char *event) {
@@ -1158,6 +1170,11 @@ static void log_snooze_state(const char *event) {
              g_snooze_state.active ? 1 : 0,
              g_snooze_state.msg_active ? 1 : 0,
              remaining_ms);
+
+    char json[96];
+    snprintf(json, sizeof(json), "{\"event\":\"%s\",\"active\":%s,\"remaining_ms\":%lld}",
+             event ? event : "unknown", g_snooze_state.active ? "true" : "false", (long long)remaining_ms);
+    webManager.notifyState("snooze", json);
 }
 
 static void clear_snooze_state(const char *event) {
@@ -1185,24 +1202,90 @@ static void dismiss_timer_alarm_with_feedback(const char *event) {
     play_file(system_path("timer_deleted").c_str());
 }
 
-static void start_timer_minutes(int minutes) {
-    // Override any existing timer or pending timer announcements
-    g_timer_state.active = true;
-    g_timer_state.minutes = minutes;
-    g_timer_state.end_ms = (esp_timer_get_time() / 1000) + (int64_t)minutes * 60 * 1000;
+static bool has_active_timer() {
+    portENTER_CRITICAL(&g_timer_mux);
+    bool active = g_timer_count > 0;
+    portEXIT_CRITICAL(&g_timer_mux);
+    return active;
+}
+
+// Copies the heap and orders it by end time (nearest first). At most APP_TIMER_MAX_COUNT entries.
+static int timer_snapshot_sorted(KitchenTimer *out, int max_count) {
+    portENTER_CRITICAL(&g_timer_mux);
+    int count = std::min(g_timer_count, max_count);
+    std::copy(g_timers, g_timers + count, out);
+    portEXIT_CRITICAL(&g_timer_mux);
+    std::sort(out, out + count, [](const KitchenTimer &a, const KitchenTimer &b) { return a.end_ms < b.end_ms; });
+    return count;
+}
+
+// Removes and returns the front timer if it has expired: O(log n)
+static bool pop_expired_timer(int64_t now_ms, KitchenTimer *out) {
+    bool popped = false;
+    portENTER_CRITICAL(&g_timer_mux);
+    if (g_timer_count > 0 && now_ms >= g_timers[0].end_ms) {
+        std::pop_heap(g_timers, g_timers + g_timer_count, KitchenTimerEndsLater());
+        g_timer_count--;
+        *out = g_timers[g_timer_count];
+        popped = true;
+    }
+    portEXIT_CRITICAL(&g_timer_mux);
+    return popped;
+}
+
+static bool start_timer_minutes(int minutes) {
+    KitchenTimer timer;
+    timer.minutes = minutes;
+    timer.end_ms = (esp_timer_get_time() / 1000) + (int64_t)minutes * 60 * 1000;
+
+    bool added = false;
+    portENTER_CRITICAL(&g_timer_mux);
+    if (g_timer_count < APP_TIMER_MAX_COUNT) {
+        timer.id = g_timer_next_id++;
+        g_timers[g_timer_count++] = timer;
+        std::push_heap(g_timers, g_timers + g_timer_count, KitchenTimerEndsLater());
+        added = true;
+    }
+    portEXIT_CRITICAL(&g_timer_mux);
+
+    if (!added) {
+        ESP_LOGW(TAG, "Timer limit reached (%d), %d minutes not added", APP_TIMER_MAX_COUNT, minutes);
+        return false;
+    }
     g_timer_state.announce_pending = false;
     g_timer_state.intro_playing = false;
     log_timer_state("set");
+    return true;
 }
 
+// Cancels the timer at `position` in end-time order (0 = nearest), or all timers when position < 0.
+static bool cancel_timer_with_feedback(const char *reason, int position = 0) {
+    int removed = 0;
+    portENTER_CRITICAL(&g_timer_mux);
+    if (position < 0) {
+        removed = g_timer_count;
+        g_timer_count = 0;
+    } else if (position < g_timer_count) {
+        // n <= APP_TIMER_MAX_COUNT, so locating the n-th nearest by partial sort is cheap
+        KitchenTimer ordered[APP_TIMER_MAX_COUNT];
+        std::copy(g_timers, g_timers + g_timer_count, ordered);
+        std::nth_element(ordered, ordered + position, ordered + g_timer_count,
+                         [](const KitchenTimer &a, const KitchenTimer &b) { return a.end_ms < b.end_ms; });
+        uint32_t target_id = ordered[position].id;
+        for (int i = 0; i < g_timer_count; ++i) {
+            if (g_timers[i].id == target_id) {
+                g_timers[i] = g_timers[g_timer_count - 1];
+                g_timer_count--;
+                std::make_heap(g_timers, g_timers + g_timer_count, KitchenTimerEndsLater());
+                removed = 1;
+                break;
+            }
+        }
+    }
+    portEXIT_CRITICAL(&g_timer_mux);
+    if (removed == 0) return false;
 
-static bool cancel_timer_with_feedback(const char *reason) {
-    if (!g_timer_state.active) return false;
-
-    ESP_LOGI(TAG, "Timer active -> deleted via %s", reason ? reason : "unknown");
-    g_timer_state.active = false;
-    g_timer_state.minutes = 0;
-    g_timer_state.end_ms = 0;
+    ESP_LOGI(TAG, "%d timer(s) deleted via %s", removed, reason ? reason : "unknown");
     g_timer_state.announce_pending = false;
     g_timer_state.intro_playing = false;
     g_timer_state.announce_minutes = 0;
@@ -1271,6 +1354,7 @@ static int g_gain_sample_rate = 44100;
 static uint8_t *g_stereo_buf = NULL;
 static size_t g_stereo_buf_size = 0;
 static volatile bool g_key3_pressed = false;
+static bool g_key3_polled = false; // Key3 edges cannot wake input_task
 static int64_t g_last_hook_change_ms = 0;
 static float g_noise_gate_factor = 1.0f;
 
@@ -1404,6 +1488,7 @@ void update_audio_output() {
         effective_handset = false; 
     }
     g_effective_handset = effective_handset;
+    dial.notify();
 
     bool output_changed = (g_last_effective_handset < 0) || (effective_handset != (g_last_effective_handset != 0));
     if (output_changed) {
@@ -1450,7 +1535,7 @@ void update_audio_output() {
         g_last_effective_handset = effective_handset ? 1 : 0;
     }
 }
-std::string get_random_file(std::string folderPath) {
+std::string get_random_file(const std::string &folderPath) {
     std::vector<std::string> files;
     DIR *dir;
     struct dirent *ent;
@@ -1562,6 +1647,7 @@ static void play_file_immediate(const char* path) {
     // Apply initial fade-in ramp
     g_gain_ramp_ms = is_system_prompt ? APP_SYSTEM_WAV_FADE_IN_MS : APP_WAV_FADE_IN_MS;
     g_fade_in_end_time = (esp_timer_get_time() / 1000) + g_gain_ramp_ms + 100;
+    dial.notify(); // Input task recomputes gain targets right away
 
 
     // Track last playback type
@@ -1672,6 +1758,8 @@ void play_busy_tone() {
 void play_timer_alarm(AlarmSource source = ALARM_TIMER, int loop_minutes = APP_TIMER_ALARM_LOOP_MINUTES) {
     g_alarm_state.active = true;
     g_alarm_state.source = source;
+    webManager.notifyState("alarm", source == ALARM_TIMER ? "{\"active\":true,\"source\":\"timer\"}"
+                                                          : "{\"active\":true,\"source\":\"daily\"}");
     clear_snooze_state("cleared_start_alarm");
     g_alarm_state.end_ms = (esp_timer_get_time() / 1000) + (int64_t)loop_minutes * 60 * 1000;
     g_alarm_state.fade_active = false;
@@ -1720,51 +1808,88 @@ static void play_persona_with_hook_sfx(const std::string &file) {
 }
 
 
-void process_phonebook_function(PhonebookEntry entry) {
-    if (entry.type == "FUNCTION") {
-        if (entry.value == "COMPLIMENT_CAT") {
-            // Parameter is "1", "2", etc. Map to persona_0X
-            std::string folder = "/sdcard/persona_0" + entry.parameter + "/" + lang_code();
-            std::string file = get_random_file(folder);
-            if (!file.empty()) {
-                wait_for_dialtone_silence_if_needed();
-                play_persona_with_hook_sfx(file);
-            }
-            else play_file(system_path("error_msg").c_str());
-        }
-        else if (entry.value == "COMPLIMENT_MIX") {
-            // Pick random persona 1-5
-            int persona = (esp_random() % 5) + 1;
-            std::string folder = "/sdcard/persona_0" + std::to_string(persona) + "/" + lang_code();
-            std::string file = get_random_file(folder);
-            if (!file.empty()) {
-                wait_for_dialtone_silence_if_needed();
-                play_persona_with_hook_sfx(file);
-            }
-        }
-        else if (entry.value == "ANNOUNCE_TIME") {
-            announce_time_now();
-        }
-        else if (entry.value == "ANNOUNCE_TIMER_REMAINING") {
-            announce_timer_remaining();
-        }
-        else if (entry.value == "VOICE_MENU") {
-            g_voice_menu_active = true;
-            g_voice_menu_reannounce = false;
-            play_voice_menu_prompt();
-        }
-        else {
-            ESP_LOGW(TAG, "Unknown Function: %s", entry.value.c_str());
-            play_file(system_path("error_msg").c_str());
-        }
-    } 
-    else if (entry.type == "TTS" || entry.type == "AUDIO") {
-        // Direct file mapping
-        if (entry.value.rfind("/", 0) == 0) {
-            play_file(entry.value.c_str());
-        } else {
-             ESP_LOGW(TAG, "Invalid path: %s", entry.value.c_str());
-        }
+// "/sdcard/persona_NN/<lang>", resolved once per persona and language.
+// Only used from input_task (dial dispatch and pickup).
+static const std::string &persona_folder(int persona) {
+    static std::vector<std::string> s_folders;
+    static std::string s_lang;
+    if (s_lang != lang_code()) {
+        s_lang = lang_code();
+        s_folders.clear();
+    }
+    if (persona < 0 || persona > 99) persona = 0; // Folders are numbered 01..99
+    if ((size_t)persona >= s_folders.size()) s_folders.resize(persona + 1);
+    std::string &folder = s_folders[persona];
+    if (folder.empty()) {
+        char path[48];
+        snprintf(path, sizeof(path), "/sdcard/persona_%02d/%s", persona, s_lang.c_str());
+        folder = path;
+    }
+    return folder;
+}
+
+static void play_random_persona(int persona) {
+    std::string file = get_random_file(persona_folder(persona));
+    if (!file.empty()) {
+        wait_for_dialtone_silence_if_needed();
+        play_persona_with_hook_sfx(file);
+    }
+    else play_file(system_path("error_msg").c_str());
+}
+
+// Phonebook action handlers, bound once via register_phonebook_actions()
+static void action_compliment_category(const PhonebookEntry &entry) {
+    // Parameter is "1", "2", etc., pre-parsed into entry.arg
+    if (entry.arg <= 0 || entry.arg > 99) {
+        ESP_LOGW(TAG, "Invalid persona parameter: %s", entry.parameter.data());
+        play_file(system_path("error_msg").c_str());
+        return;
+    }
+    play_random_persona(entry.arg);
+}
+
+static void action_compliment_mix(const PhonebookEntry &entry) {
+    // Pick random persona 1-5
+    play_random_persona((esp_random() % 5) + 1);
+}
+
+static void action_announce_time(const PhonebookEntry &entry) {
+    announce_time_now();
+}
+
+static void action_announce_timer_remaining(const PhonebookEntry &entry) {
+    announce_timer_remaining();
+}
+
+static void action_voice_menu(const PhonebookEntry &entry) {
+    g_voice_menu_active = true;
+    g_voice_menu_reannounce = false;
+    play_voice_menu_prompt();
+}
+
+static void action_play_file(const PhonebookEntry &entry) {
+    // Direct file mapping
+    if (entry.value.rfind("/", 0) == 0) {
+        play_file(entry.value.data());
+    } else {
+         ESP_LOGW(TAG, "Invalid path: %s", entry.value.data());
+    }
+}
+
+static void register_phonebook_actions() {
+    phonebook.registerAction("COMPLIMENT_CAT", action_compliment_category);
+    phonebook.registerAction("COMPLIMENT_MIX", action_compliment_mix);
+    phonebook.registerAction("ANNOUNCE_TIME", action_announce_time);
+    phonebook.registerAction("ANNOUNCE_TIMER_REMAINING", action_announce_timer_remaining);
+    phonebook.registerAction("VOICE_MENU", action_voice_menu);
+    phonebook.registerAction("AUDIO", action_play_file);
+    phonebook.registerAction("TTS", action_play_file);
+}
+
+void process_phonebook_function(const PhonebookEntry &entry) {
+    if (!phonebook.dispatch(entry)) {
+        ESP_LOGW(TAG, "Unknown Function: %s/%s", entry.type.data(), entry.value.data());
+        play_file(system_path("error_msg").c_str());
     }
 }
 
@@ -1788,6 +1913,84 @@ void safe_reboot() {
     esp_restart();
 }
 
+// Dispatch the collected digits: voice menu, kitchen timer (on-hook) or phonebook
+static void process_dialed_number() {
+    // Voice menu (single digit)
+    if (g_voice_menu_active && g_off_hook) {
+        if (dial_buffer.size() == 1) {
+            int digit = dial_buffer[0] - '0';
+            handle_voice_menu_digit(digit);
+        } else {
+            start_voice_queue({system_path("error_msg")});
+        }
+    }
+    // On-hook -> Timer mode: 1-3 digits add a timer (up to 500 minutes),
+    // "0N" cancels the N-th nearest timer, "00" cancels all timers
+    else if (!g_off_hook) {
+        if (dial_buffer.size() == 2 && dial_buffer[0] == '0') {
+            int position = dial_buffer[1] - '0';
+            if (!cancel_timer_with_feedback("dial", position == 0 ? -1 : position - 1)) {
+                ESP_LOGI(TAG, "Timer cancel %s: no such timer", dial_buffer.c_str());
+                start_voice_queue({system_path("timer_none")});
+            }
+        } else if (dial_buffer.size() >= 1 && dial_buffer.size() <= 3) {
+            int minutes = atoi(dial_buffer.c_str());
+            if (minutes >= APP_TIMER_MIN_MINUTES && minutes <= APP_TIMER_MAX_MINUTES) {
+                ESP_LOGI(TAG, "Timer set: %d minutes", minutes);
+                // Reset alarm file to default for kitchen timer
+                g_alarm_state.current_file = get_timer_ringtone_path();
+                clear_snooze_state("cleared_dial_timer_set");
+
+                if (start_timer_minutes(minutes)) {
+                    g_timer_state.announce_minutes = minutes;
+                    g_timer_state.announce_pending = true;
+                    g_timer_state.intro_playing = true;
+                    log_timer_state("set_dial_announce_pending");
+
+                    // Force Base Speaker for announcement
+                    force_base_output_with_pending_restore(false);
+
+                    play_file(system_path("timer_set").c_str());
+                } else {
+                    // All timer slots in use
+                    start_voice_queue({system_path("timer_invalid")});
+                }
+            } else {
+                ESP_LOGW(TAG, "Invalid timer value: %d", minutes);
+                std::vector<std::string> files;
+                files.push_back(system_path("timer_invalid"));
+                files.push_back(system_path("timer_max"));
+                add_number_audio(files, APP_TIMER_MAX_MINUTES);
+                files.push_back(system_path("minutes"));
+                start_voice_queue(files);
+            }
+        } else {
+            ESP_LOGW(TAG, "Timer requires 1-3 digits. Got: %s", dial_buffer.c_str());
+            std::vector<std::string> files;
+            files.push_back(system_path("timer_invalid"));
+            files.push_back(system_path("timer_max"));
+            add_number_audio(files, APP_TIMER_MAX_MINUTES);
+            files.push_back(system_path("minutes"));
+            start_voice_queue(files);
+        }
+    } else {
+        // Lookup
+        if (PhonebookEntryRef entry = phonebook.find(dial_buffer)) {
+             ESP_LOGI(TAG, "Phonebook Match: %s (%s)", entry->name.data(), entry->value.data());
+             process_phonebook_function(*entry);
+        } else {
+            ESP_LOGI(TAG, "Number %s not found.", dial_buffer.c_str());
+            std::vector<std::string> sequence;
+            sequence.push_back(system_path("number_invalid"));
+            sequence.push_back("/sdcard/system/busy_tone.wav");
+            sequence.push_back("/sdcard/system/busy_tone.wav");
+            start_voice_queue(sequence);
+        }
+    }
+
+    dial_buffer = ""; // Reset buffer
+}
+
 // Callbacks
 void on_dial_complete(int number) {
     if (g_line_busy) {
@@ -1849,12 +2052,12 @@ void on_button_press() {
 }
 
 static bool can_trigger_deep_sleep_via_button() {
-    return (!g_off_hook && !g_alarm_state.active && !g_timer_state.active);
+    return (!g_off_hook && !g_alarm_state.active && !has_active_timer());
 }
 
 static void handle_extra_button_short_press() {
-    if (!g_alarm_state.active && g_timer_state.active) {
-        cancel_timer_with_feedback("Key 5");
+    if (!g_alarm_state.active && has_active_timer()) {
+        cancel_timer_with_feedback("Key 5"); // Nearest timer first
         return;
     }
     // Handle Timer/Alarm Mute
@@ -1935,6 +2138,7 @@ void on_hook_change(bool off_hook) {
     ESP_LOGI(TAG, "--- HOOK STATE: %s ---", off_hook ? "OFF HOOK (Active/Pickup)" : "ON HOOK (Idle/Hangup)");
 
     g_off_hook = off_hook;
+    webManager.notifyState("hook", off_hook ? "{\"off_hook\":true}" : "{\"off_hook\":false}");
 
     if (off_hook) {
         // CRITICAL: Set timestamp IMMEDIATELY to prevent race with busy-timeout check in main loop
@@ -1969,9 +2173,7 @@ void on_hook_change(bool off_hook) {
             update_audio_output();
 
             if (play_random_msg) {
-                int persona = (esp_random() % 5) + 1;
-                std::string folder = "/sdcard/persona_0" + std::to_string(persona) + "/" + lang_code();
-                std::string file = get_random_file(folder);
+                std::string file = get_random_file(persona_folder((esp_random() % 5) + 1));
 
                 if (!file.empty()) {
                     play_persona_with_padding(file);
@@ -1997,9 +2199,7 @@ void on_hook_change(bool off_hook) {
                 // Play specific message if enabled for this alarm
                 if (play_random_msg) {
                     // Logic from "11" (COMPLIMENT_MIX)
-                    int persona = (esp_random() % 5) + 1;
-                    std::string folder = "/sdcard/persona_0" + std::to_string(persona) + "/" + lang_code();
-                    std::string file = get_random_file(folder);
+                    std::string file = get_random_file(persona_folder((esp_random() % 5) + 1));
                     
                     if (!file.empty()) {
                         play_persona_with_padding(file);
@@ -2081,6 +2281,7 @@ void input_task(void *pvParameters) {
             target_left = 0.0f;
         }
 
+        bool key3_settling = false;
         if (APP_PIN_KEY3 >= 0) {
             int level = gpio_get_level((gpio_num_t)APP_PIN_KEY3);
             bool sampled_pressed = APP_KEY3_ACTIVE_LOW ? (level == 0) : (level == 1);
@@ -2098,6 +2299,7 @@ void input_task(void *pvParameters) {
                 g_key3_pressed = s_key3_stable;
                 ESP_LOGI(TAG, "Key3 %s", g_key3_pressed ? "pressed" : "released");
             }
+            key3_settling = (s_key3_stable != s_key3_last_sample);
 
             if (g_key3_pressed) {
                 target_right = 0.0f; // Mute Right on Key3
@@ -2133,9 +2335,14 @@ void input_task(void *pvParameters) {
             esp_task_wdt_reset();
         }
     #endif
-        // Yield to IDLE task to reset WDT using vTaskDelay
-        // Ensure strictly positive delay to allow IDLE task to run
-        vTaskDelay(pdMS_TO_TICKS(50)); 
+        // Sleep until a hook/button/pulse/Key3 edge or the dial's next deadline.
+        // Gain ramps, playback and the alarm fade still need the 50 ms cadence.
+        uint32_t wait_ms = dial.nextWakeMs();
+        bool periodic = is_playing || g_alarm_state.active || g_extra_btn_active || key3_settling ||
+                        g_key3_polled || g_gain_ramp_ms != APP_GAIN_RAMP_MS;
+        if (periodic && wait_ms > 50) wait_ms = 50;
+        if (wait_ms > APP_INPUT_IDLE_WAIT_MS) wait_ms = APP_INPUT_IDLE_WAIT_MS;
+        dial.waitForEvent(wait_ms); // Always blocks at least one tick so IDLE can run
     }
 }
 
@@ -2321,6 +2528,10 @@ extern "C" void app_main(void)
     dial.begin();
     dial.setModeActiveLow(APP_DIAL_MODE_ACTIVE_LOW); 
     dial.setPulseActiveLow(APP_DIAL_PULSE_ACTIVE_LOW); 
+    if (APP_PIN_KEY3 >= 0 && !dial.addWakeInput(APP_PIN_KEY3)) {
+        g_key3_polled = true;
+        ESP_LOGW(TAG, "Key3 (GPIO %d) has no edge wakeup; polling every 50 ms", APP_PIN_KEY3);
+    }
     bool boot_off_hook = dial.isOffHook();
     if (boot_off_hook) {
         ESP_LOGW(TAG, "Detected OFF HOOK during boot");
@@ -2338,6 +2549,7 @@ extern "C" void app_main(void)
     dial.onButtonPress(on_button_press);
 
     // Initialize Phonebook (Now that SD is ready)
+    register_phonebook_actions();
     phonebook.begin();
 
     // --- 3b. Web / Network ---
@@ -2499,9 +2711,8 @@ extern "C" void app_main(void)
                  // Enable Base Speaker for Alarm
                  update_audio_output();
 
-                 // Get specifics for today
-                 struct tm now_tm = TimeManager::getCurrentTime();
-                 DayAlarm today = TimeManager::getAlarm(now_tm.tm_wday);
+                 // Get specifics of the alarm that just fired
+                 DayAlarm today = TimeManager::getRingingAlarm();
                  g_alarm_state.msg_active = today.useRandomMsg;
                  
                  // Handle Fade
@@ -2551,73 +2762,14 @@ extern "C" void app_main(void)
         // --- Logic: Check Dial Timeout ---
         if (!dial_buffer.empty()) {
             int64_t now = esp_timer_get_time() / 1000;
-            if (!dial.isDialing() && (now - last_digit_time) > DIAL_TIMEOUT_MS) {
-                ESP_LOGI(TAG, "Dial Timeout. Processing Number: %s", dial_buffer.c_str());
-                
-                // Voice menu (single digit)
-                if (g_voice_menu_active && g_off_hook) {
-                    if (dial_buffer.size() == 1) {
-                        int digit = dial_buffer[0] - '0';
-                        handle_voice_menu_digit(digit);
-                    } else {
-                        start_voice_queue({system_path("error_msg")});
-                    }
-                }
-                // On-hook -> Timer mode (1-3 digits, up to 500 minutes)
-                else if (!g_off_hook) {
-                    if (dial_buffer.size() >= 1 && dial_buffer.size() <= 3) {
-                        int minutes = atoi(dial_buffer.c_str());
-                        if (minutes >= APP_TIMER_MIN_MINUTES && minutes <= APP_TIMER_MAX_MINUTES) {
-                            ESP_LOGI(TAG, "Timer set: %d minutes", minutes);
-                            // Reset alarm file to default for kitchen timer
-                            g_alarm_state.current_file = get_timer_ringtone_path();
-                            clear_snooze_state("cleared_dial_timer_set");
-
-                            start_timer_minutes(minutes);
-                            g_timer_state.announce_minutes = minutes;
-                            g_timer_state.announce_pending = true;
-                            g_timer_state.intro_playing = true;
-                            log_timer_state("set_dial_announce_pending");
-
-                            // Force Base Speaker for announcement
-                            force_base_output_with_pending_restore(false);
-
-                            play_file(system_path("timer_set").c_str());
-                        } else {
-                            ESP_LOGW(TAG, "Invalid timer value: %d", minutes);
-                            std::vector<std::string> files;
-                            files.push_back(system_path("timer_invalid"));
-                            files.push_back(system_path("timer_max"));
-                            add_number_audio(files, APP_TIMER_MAX_MINUTES);
-                            files.push_back(system_path("minutes"));
-                            start_voice_queue(files);
-                        }
-                    } else {
-                        ESP_LOGW(TAG, "Timer requires 1-3 digits. Got: %s", dial_buffer.c_str());
-                        std::vector<std::string> files;
-                        files.push_back(system_path("timer_invalid"));
-                        files.push_back(system_path("timer_max"));
-                        add_number_audio(files, APP_TIMER_MAX_MINUTES);
-                        files.push_back(system_path("minutes"));
-                        start_voice_queue(files);
-                    }
-                } else {
-                    // Lookup
-                    if (phonebook.hasEntry(dial_buffer)) {
-                         PhonebookEntry entry = phonebook.getEntry(dial_buffer);
-                         ESP_LOGI(TAG, "Phonebook Match: %s (%s)", entry.name.c_str(), entry.value.c_str());
-                         process_phonebook_function(entry);
-                    } else {
-                        ESP_LOGI(TAG, "Number %s not found.", dial_buffer.c_str());
-                        std::vector<std::string> sequence;
-                        sequence.push_back(system_path("number_invalid"));
-                        sequence.push_back("/sdcard/system/busy_tone.wav");
-                        sequence.push_back("/sdcard/system/busy_tone.wav");
-                        start_voice_queue(sequence);
-                    }
-                }
-
-                dial_buffer = ""; // Reset buffer
+            bool timed_out = (now - last_digit_time) > DIAL_TIMEOUT_MS;
+            // Off-hook numbers with no longer extension in the phonebook
+            // (e.g. "5", but not "11" because of "110") need no timeout
+            bool unique = g_off_hook && !g_voice_menu_active &&
+                          phonebook.matchPrefix(dial_buffer) == PhonebookMatch::Unique;
+            if (!dial.isDialing() && (timed_out || unique)) {
+                ESP_LOGI(TAG, "%s. Processing Number: %s", timed_out ? "Dial Timeout" : "Unique prefix", dial_buffer.c_str());
+                process_dialed_number();
             }
         }
 
@@ -2659,19 +2811,12 @@ extern "C" void app_main(void)
             }
         }
 
-        // Timer alarm check
-        if (g_timer_state.active && !g_alarm_state.active) {
-            int64_t now = esp_timer_get_time() / 1000;
-            if (now >= g_timer_state.end_ms) {
-                ESP_LOGI(TAG, "Timer expired -> alarm");
+        // Timer alarm check (heap front only; further expired timers ring after this one is dismissed)
+        if (!g_alarm_state.active) {
+            KitchenTimer expired;
+            if (pop_expired_timer(esp_timer_get_time() / 1000, &expired)) {
+                ESP_LOGI(TAG, "Timer %u (%d min) expired -> alarm", (unsigned)expired.id, expired.minutes);
                 log_timer_state("expired");
-                g_timer_state.active = false;
-                g_timer_state.minutes = 0;
-                g_timer_state.end_ms = 0;
-                g_timer_state.announce_pending = false;
-                g_timer_state.intro_playing = false;
-                g_timer_state.announce_minutes = 0;
-                log_timer_state("cleared_after_expire");
                 play_timer_alarm();
             }
         }
@@ -7,7 +7,12 @@ const state = {
     loading: true,
     phonebook: {},
     logLines: [],
-    logTimer: null
+    logTimer: null,
+    logView: false,
+    version: 0, // Last /api/state version applied
+    events: null, // EventSource while /api/events is connected
+    eventsLost: false,
+    device: {} // Last pushed hook/alarm/timer/snooze state
 };
 
 // --- Debugging ---
@@ -41,6 +46,10 @@ const TEXT = {
         setup: "Einrichtung",
         name_header: "Name",
         loading_alarms: "Wecker werden geladen...",
+        extra_alarms: "Weitere Wecker",
+        add_alarm: "Wecker hinzufügen",
+        once_on: "Einmalig am",
+        remove: "Entfernen",
         minutes_short: "min",
         wifi_network: "WLAN Netzwerk",
         ip_address: "IP-Adresse",
@@ -114,6 +123,10 @@ const TEXT = {
         setup: "Setup",
         name_header: "Name",
         loading_alarms: "Loading alarms...",
+        extra_alarms: "Additional Alarms",
+        add_alarm: "Add alarm",
+        once_on: "Once on",
+        remove: "Remove",
         minutes_short: "min",
         wifi_network: "WiFi Network",
         ip_address: "IP Address",
@@ -192,12 +205,16 @@ function renderHourOptions(selectedHour) {
 const API = {
     getSettings: () => fetch('/api/settings').then(r => r.json()),
     saveSettings: (data) => fetch('/api/settings', { method: 'POST', body: JSON.stringify(data) }),
-    scanWifi: () => fetch('/api/wifi/scan').then(r => r.json()),
+    // {scanning, age_ms, networks}; the device refreshes stale results in the background
+    scanWifi: (refresh) => fetch(`/api/wifi/scan${refresh ? '?refresh=1' : ''}`).then(r => r.json()),
     getRingtones: () => fetch('/api/ringtones').then(r => r.json()),
     getLogs: () => fetch('/api/logs').then(r => r.json()),
     clearLogs: () => fetch('/api/logs/clear', { method: 'POST' }),
     getPhonebook: () => fetch('/api/phonebook').then(r => r.json()),
     getTime: () => fetch('/api/time').then(r => r.json()),
+    // Sections changed since `since`; null when nothing changed (304)
+    getState: (since) => fetch(`/api/state?since=${since || 0}`).then(r => r.status === 304 ? null : r.json()),
+    getOtaStatus: () => fetch('/api/ota/status').then(r => r.json()),
     uploadOta: (file, password, onProgress) => {
         return new Promise((resolve, reject) => {
             const xhr = new XMLHttpRequest();
@@ -339,6 +356,7 @@ async function clearLogs() {
 
 // Update alarm clock time display
 function updateAlarmTime() {
+    if (state.events) return; // Pushed by the event stream
     const timeEl = document.getElementById('alarm-current-time');
     if (timeEl && state.page === '/alarm') {
         API.getTime()
@@ -349,10 +367,30 @@ function updateAlarmTime() {
     }
 }
 
+// Merges an /api/state response; false if nothing changed
+function applyState(data) {
+    if (!data) return false;
+    state.version = data.version;
+    if (data.settings) {
+        state.settings = data.settings;
+        state.lang = data.settings.lang || 'de';
+    }
+    if (data.ringtones) state.ringtones = data.ringtones;
+    if (data.phonebook) state.phonebook = data.phonebook;
+    return true;
+}
+
+function refreshState() {
+    return API.getState(state.version)
+        .then(data => { if (applyState(data)) render(); })
+        .catch(() => {});
+}
+
 async function init() {
     onInitStart();
     
-    // Start alarm time polling
+    // Live updates; the polling below only runs while the stream is down
+    startEventStream();
     setInterval(updateAlarmTime, 1000);
     try {
         console.log("Fetching Settings...");
@@ -361,14 +399,7 @@ async function init() {
         const statusResp = await fetch('/api/status');
         const status = await statusResp.json();
         
-        const [settings, ringtones] = await Promise.all([
-            API.getSettings(),
-            API.getRingtones()
-        ]);
-        
-        state.settings = settings;
-        state.ringtones = ringtones || [];
-        state.lang = settings.lang || 'de';
+        applyState(await API.getState(0));
         
         // Logic: Force Setup if AP mode OR no SSID config
         // Also check hostname (Captive Portal usually uses IP or .local)
@@ -385,12 +416,22 @@ async function init() {
         }
         
         render();
+        logLoadMetrics();
     } catch (e) {
         console.error(e);
         document.getElementById('app').innerHTML = `<h1 style='color:red;'>${t('network_error')}</h1><p>${e.message}</p><p>${t('check_console')}</p>`;
     }
 }
 
+// Page weight and time to first render, for checking asset caching/compression
+function logLoadMetrics() {
+    if (!window.performance || !performance.getEntriesByType) return;
+    const nav = performance.getEntriesByType('navigation')[0];
+    const entries = [nav, ...performance.getEntriesByType('resource')].filter(Boolean);
+    const bytes = entries.reduce((sum, e) => sum + (e.transferSize || 0), 0);
+    console.log(`Page load: ${Math.round(performance.now())} ms to interactive, ${(bytes / 1024).toFixed(1)} KB transferred`);
+}
+
 function t(key) {
     return TEXT[state.lang][key] || key;
 }
@@ -430,17 +471,7 @@ function render() {
         html += renderSetup();
         // Trigger scan automatically if not done
         if (!state.wifiList && !state.scanning) {
-            state.scanning = true;
-            API.scanWifi().then(list => {
-                state.wifiList = list;
-                state.scanning = false;
-                render();
-            }).catch(e => {
-                console.error(e);
-                state.scanning = false;
-                state.wifiError = e.message;
-                render();
-            });
+            pollWifiScan(false);
         }
     } else {
         html += renderHome();
@@ -481,7 +512,48 @@ function updateCrt(lines) {
     crt.textContent = (lines && lines.length) ? lines.join('\n') : 'READY>_';
 }
 
+// Server-Sent Events replace the time and log polling. The browser
+// reconnects on its own; if the server refuses (e.g. too many streams),
+// the UI falls back to polling.
+function startEventStream() {
+    if (!window.EventSource || state.events) return;
+    const es = new EventSource('/api/events');
+    es.addEventListener('open', () => {
+        if (state.eventsLost) refreshState(); // Catch up on changes missed while disconnected
+        state.eventsLost = false;
+        state.events = es;
+        if (state.logTimer) {
+            clearInterval(state.logTimer);
+            state.logTimer = null;
+        }
+    });
+    es.addEventListener('error', () => {
+        state.eventsLost = true;
+        if (es.readyState !== EventSource.CLOSED) return;
+        state.events = null;
+        if (state.logView) startLogPolling();
+    });
+    es.addEventListener('time', (e) => {
+        const timeEl = document.getElementById('alarm-current-time');
+        const data = JSON.parse(e.data);
+        if (timeEl && state.page === '/alarm' && data.time) timeEl.textContent = data.time;
+    });
+    es.addEventListener('log', (e) => {
+        const data = JSON.parse(e.data);
+        if (!Array.isArray(data.lines)) return;
+        state.logLines = [...state.logLines, ...data.lines].slice(-10);
+        if (state.logView) updateCrt(state.logLines);
+    });
+    ['hook', 'alarm', 'timer', 'snooze'].forEach(name => {
+        es.addEventListener(name, (e) => {
+            state.device[name] = JSON.parse(e.data);
+            console.log(`State ${name}: ${e.data}`);
+        });
+    });
+}
+
 function startLogPolling() {
+    state.logView = true;
     if (state.logTimer) return;
     const fetchLogs = () => {
         API.getLogs().then(data => {
@@ -492,7 +564,8 @@ function startLogPolling() {
             updateCrt(state.logLines);
         });
     };
-    fetchLogs();
+    fetchLogs(); // Backlog; new lines then arrive on the event stream
+    if (state.events) return;
     state.logTimer = setInterval(fetchLogs, 1500);
 }
 
@@ -504,6 +577,7 @@ function logLampSettings(label, patch) {
 }
 
 function stopLogPolling() {
+    state.logView = false;
     if (!state.logTimer) return;
     clearInterval(state.logTimer);
     state.logTimer = null;
@@ -758,6 +832,8 @@ function renderSettings() {
             `;
         });
 
+        rows += renderExtraAlarms(days, ringtones);
+
         // Snooze Selection
         const currentSnooze = state.settings.snooze_min || 5;
         let snoozeOpts = "";
@@ -787,12 +863,85 @@ function renderSettings() {
     `;
 }
 
+// Additional alarms: recurring on selected weekdays, or once on a date when no day is ticked
+function renderExtraAlarms(days, ringtones) {
+    const extra = state.settings.extra_alarms || [];
+    const displayOrder = [1, 2, 3, 4, 5, 6, 0];
+
+    let html = `
+        <div style="margin-top:20px; padding-top:10px; border-top:1px solid #444;">
+            <div class="alarm-day" style="font-family: 'Plaisir', serif; margin-bottom:8px;">${t('extra_alarms')}</div>
+    `;
+
+    extra.forEach((a, i) => {
+        const timeVal = `${String(a.h).padStart(2,'0')}:${String(a.m).padStart(2,'0')}`;
+        const currentSound = a.snd || "digital_alarm.wav";
+        let soundOpts = ringtones.map(r => `<option value="${r}" ${r === currentSound ? "selected" : ""}>${r}</option>`).join('');
+        if (ringtones.length === 0) soundOpts = `<option>${currentSound}</option>`;
+
+        const dayBoxes = displayOrder.map(d => `
+            <label style="display:inline-flex; flex-direction:column; align-items:center; margin-right:4px; font-size:0.7rem; color:#aaa;">
+                <input type="checkbox" id="x-day-${i}-${d}" ${(a.days & (1 << d)) ? "checked" : ""}>
+                ${days[d].substring(0, 2)}
+            </label>`).join('');
+
+        html += `
+            <div class="alarm-card" style="flex-direction: column; align-items: flex-start;">
+                <div style="display:flex; justify-content:space-between; width:100%; align-items:center; margin-bottom: 3px;">
+                    <div style="display:flex; align-items:center;">
+                        <label class="switch" title="${t('active')}">
+                            <input type="checkbox" id="x-en-${i}" ${a.en ? "checked" : ""}>
+                            <span class="slider"></span>
+                        </label>
+                        <span class="alarm-label">${t('active')}</span>
+                    </div>
+                    <input type="time" value="${timeVal}" id="x-time-${i}" class="alarm-time-input">
+                </div>
+                <div style="width:100%; margin: 4px 0;">${dayBoxes}</div>
+                <div style="width:100%; display:flex; align-items:center; margin-bottom: 3px;">
+                    <span class="alarm-label" style="margin-left:0; margin-right:8px;">${t('once_on')}</span>
+                    <input type="date" id="x-date-${i}" value="${a.date || ''}" style="background:#222; color:#f0e6d2; border:1px solid #666; border-radius:4px;">
+                </div>
+                <div style="width: 100%; display: flex; justify-content: space-between; align-items: center;">
+                    <div style="display:flex; align-items:center;">
+                        <label class="switch" title="${t('fade')}">
+                            <input type="checkbox" id="x-rmp-${i}" ${a.rmp ? "checked" : ""}>
+                            <span class="slider"></span>
+                        </label>
+                        <span class="alarm-label">${t('fade')}</span>
+                    </div>
+                    <select id="x-snd-${i}" onchange="previewTone(this.value)" class="alarm-sound-select">
+                        ${soundOpts}
+                    </select>
+                </div>
+                <div style="width: 100%; display: flex; justify-content: space-between; align-items: center; margin-top: 3px;">
+                    <div style="display:flex; align-items:center;">
+                        <label class="switch" title="${t('msg')}">
+                            <input type="checkbox" id="x-msg-${i}" ${a.msg ? "checked" : ""}>
+                            <span class="slider"></span>
+                        </label>
+                        <span class="alarm-label">${t('msg')}</span>
+                    </div>
+                    <button onclick="removeExtraAlarm(${i})">${t('remove')}</button>
+                </div>
+            </div>
+        `;
+    });
+
+    html += `
+            <div style="text-align:center; margin-top:0.5rem;"><button onclick="addExtraAlarm()">${t('add_alarm')}</button></div>
+        </div>
+    `;
+    return html;
+}
+
 function renderHelp() {
     const usageItems = [
         'Lift receiver + dial 1-5 to play persona content.',
-        'Receiver on hook + dial 1-500 to set kitchen timer in minutes.',
-        'If a timer is active, press the extra button to reset/delete it.',
-        'Lift receiver + dial 8 to announce remaining active timer minutes.',
+        'Receiver on hook + dial 1-500 to add a kitchen timer in minutes (up to 9 at once).',
+        'Receiver on hook + dial 01-09 to cancel the N-th nearest timer, 00 to cancel all.',
+        'If a timer is active, press the extra button to delete the nearest one.',
+        'Lift receiver + dial 8 to announce the remaining minutes of all active timers.',
         'Snooze while alarm rings by pressing the extra button.',
         'Idle deep sleep: keep receiver on hook and press the extra button 5 times within 3 seconds.',
         'Before deep sleep, the signal lamp is turned off to reduce power draw.',
@@ -868,7 +1017,51 @@ window.previewTone = (filename) => {
     }, PREVIEW_DEBOUNCE_MS);
 };
 
-window.saveAlarms = () => {
+function collectExtraAlarms() {
+    const extra = [];
+    (state.settings.extra_alarms || []).forEach((a, i) => {
+        const timeInput = document.getElementById(`x-time-${i}`);
+        if (!timeInput) {
+            extra.push(a);
+            return;
+        }
+        const [h, m] = timeInput.value.split(':').map(Number);
+        let daysMask = 0;
+        for (let d = 0; d < 7; d++) {
+            const box = document.getElementById(`x-day-${i}-${d}`);
+            if (box && box.checked) daysMask |= (1 << d);
+        }
+        const dateInput = document.getElementById(`x-date-${i}`);
+        const sndInput = document.getElementById(`x-snd-${i}`);
+        extra.push({
+            h: h, m: m, days: daysMask,
+            date: daysMask === 0 && dateInput ? dateInput.value : "",
+            en: document.getElementById(`x-en-${i}`).checked,
+            rmp: document.getElementById(`x-rmp-${i}`).checked,
+            msg: document.getElementById(`x-msg-${i}`).checked,
+            snd: sndInput ? sndInput.value : "digital_alarm.wav"
+        });
+    });
+    return extra;
+}
+
+window.addExtraAlarm = () => {
+    state.settings.alarms = collectAlarms();
+    const extra = collectExtraAlarms();
+    extra.push({h: 7, m: 0, days: 0, date: new Date().toISOString().slice(0, 10), en: true, rmp: false, msg: false, snd: "digital_alarm.wav"});
+    state.settings.extra_alarms = extra;
+    render();
+};
+
+window.removeExtraAlarm = (index) => {
+    state.settings.alarms = collectAlarms();
+    const extra = collectExtraAlarms();
+    extra.splice(index, 1);
+    state.settings.extra_alarms = extra;
+    render();
+};
+
+function collectAlarms() {
     const newAlarms = [];
     for(let i=0; i<7; i++) {
         const timeInput = document.getElementById(`time-${i}`);
@@ -887,17 +1080,24 @@ window.saveAlarms = () => {
             newAlarms.push({d: i, h: h, m: m, en: en, rmp: rmp, msg: msg, snd: snd});
         }
     }
+    return newAlarms;
+}
+
+window.saveAlarms = () => {
+    const newAlarms = collectAlarms();
+    const extraAlarms = collectExtraAlarms().filter(a => a.days !== 0 || a.date);
     
     const snoozeInput = document.getElementById('snooze-time');
     const snoozeVal = snoozeInput ? parseInt(snoozeInput.value) : 5;
 
     // Optimistic update
     state.settings.alarms = newAlarms;
+    state.settings.extra_alarms = extraAlarms;
     state.settings.snooze_min = snoozeVal;
     
     document.getElementById('app').innerHTML = `<div style="text-align:center; padding:50px; color:#d4af37;"><h3>${t('save')}...</h3></div>`;
     
-    API.saveSettings({alarms: newAlarms, snooze_min: snoozeVal}).then(() => {
+    API.saveSettings({alarms: newAlarms, extra_alarms: extraAlarms, snooze_min: snoozeVal}).then(() => {
         render(); // Redraw
     });
 }
@@ -1073,7 +1273,7 @@ function renderAdvanced() {
                 <div style="padding:10px 12px 12px; border-top:1px solid #333;">
                     <div style="margin-top:10px;">
                         <label style="font-size:0.8rem; color:#aaa; text-transform:uppercase;">${t('ota_select')}</label>
-                        <input type="file" id="ota-file" accept=".bin" style="margin-top:6px;" />
+                        <input type="file" id="ota-file" accept=".bin,.gz" style="margin-top:6px;" />
                     </div>
 
                     <div style="margin-top:10px;">
@@ -1182,18 +1382,54 @@ window.startOtaUpload = async () => {
     if (statusEl) statusEl.textContent = t('ota_status_uploading');
     if (progressEl) progressEl.textContent = '0%';
 
+    // Upload progress only covers the network side; the device reports how much is already flashed
+    let uploadPct = 0;
+    let flashPct = 0;
+    const showProgress = () => {
+        if (progressEl) progressEl.textContent = `${uploadPct}% / Flash ${flashPct}%`;
+    };
+    const statusTimer = setInterval(() => {
+        API.getOtaStatus().then(st => {
+            if (st.total > 0) flashPct = Math.round((st.consumed / st.total) * 100);
+            showProgress();
+        }).catch(() => {});
+    }, 1000);
+
     API.uploadOta(file, password, (pct) => {
-        if (progressEl) progressEl.textContent = `${pct}%`;
+        uploadPct = pct;
+        showProgress();
     }).then(() => {
+        clearInterval(statusTimer);
+        flashPct = 100;
+        showProgress();
         if (statusEl) statusEl.textContent = t('ota_status_done');
     }).catch(() => {
+        clearInterval(statusTimer);
         if (statusEl) statusEl.textContent = t('ota_status_failed');
     });
 };
 
+// Shows cached results right away and asks again while the device is scanning
+function pollWifiScan(refresh) {
+    state.scanning = true;
+    API.scanWifi(refresh).then(data => {
+        state.wifiError = null;
+        state.wifiList = data.networks || [];
+        state.wifiAgeMs = data.age_ms;
+        state.scanning = !!data.scanning;
+        if (state.scanning) setTimeout(() => pollWifiScan(false), 1500);
+        if (!state.selectedWifi) render();
+    }).catch(e => {
+        console.error(e);
+        state.scanning = false;
+        state.wifiError = e.message;
+        render();
+    });
+}
+
 function renderSetup() {
     let content = "";
-    if (state.scanning) {
+    if (state.scanning && !(state.wifiList && state.wifiList.length)) {
         content = `<p style='text-align:center;'>${t('scanning_wifi')} <br> (${t('please_wait')})</p>`;
     } else if (state.wifiError) {
         content = `<p style='color:red'>${t('scan_error')}: ${state.wifiError}. <a href='#' onclick='window.location.reload()'>${t('retry')}</a></p>`;
@@ -1206,6 +1442,10 @@ function renderSetup() {
             </li>`;
         });
         content += "</ul>";
+        const age = state.wifiAgeMs >= 0 ? ` · ${Math.round(state.wifiAgeMs / 1000)} s` : '';
+        content += state.scanning
+            ? `<p style='text-align:center;'><small>${t('scanning_wifi')}${age}</small></p>`
+            : `<p style='text-align:center;'><small><a href='#' onclick='pollWifiScan(true); return false;'>${t('retry')}</a>${age}</small></p>`;
     }
 
     // Modal or Input Area
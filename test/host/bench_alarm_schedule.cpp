@@ -0,0 +1,127 @@
+// Saving the weekly alarm schedule against the in-memory NVS stub: the
+// legacy per-day keys (6 keys and a commit per day, as setAlarm() wrote them
+// before the schedule blob), setAlarm() per day on top of the blob, and one
+// setSchedule(). First it migrates a legacy store and checks the result.
+// Host times only show the relative cost; set/commit counts carry over to
+// the device, where every commit rewrites NVS pages on flash.
+//
+//   bench_alarm_schedule [rounds]
+#include <chrono>
+#include <string>
+#include <stdio.h>
+#include <stdlib.h>
+#include "TimeManager.h"
+#include "app_config.h"
+#include "host_test.h"
+#include "nvs.h"
+
+// Pre-blob TimeManager::setAlarm(), kept here as the baseline
+static void legacy_set_alarm(int day, int hour, int minute, bool active, bool ramp, bool msg, const char *tone) {
+    nvs_handle_t handle;
+    if (nvs_open("dialcharm", NVS_READWRITE, &handle) != ESP_OK) return;
+    char key[16];
+    snprintf(key, sizeof(key), "alm_%d_h", day);
+    nvs_set_i32(handle, key, hour);
+    snprintf(key, sizeof(key), "alm_%d_m", day);
+    nvs_set_i32(handle, key, minute);
+    snprintf(key, sizeof(key), "alm_%d_en", day);
+    nvs_set_u8(handle, key, active ? 1 : 0);
+    snprintf(key, sizeof(key), "alm_%d_rmp", day);
+    nvs_set_u8(handle, key, ramp ? 1 : 0);
+    snprintf(key, sizeof(key), "alm_%d_msg", day);
+    nvs_set_u8(handle, key, msg ? 1 : 0);
+    snprintf(key, sizeof(key), "alm_%d_snd", day);
+    nvs_set_str(handle, key, tone);
+    nvs_commit(handle);
+    nvs_close(handle);
+}
+
+static DayAlarm week_day(int day, int round) {
+    return {6 + day % 3, (day * 7 + round) % 60, day != 0 && day != 6, day % 2 == 0, day == 3, "tone_" + std::to_string(day) + ".wav"};
+}
+
+// Runs before anything else touches TimeManager: the schedule loads only once
+static bool check_migration() {
+    host_nvs_clear();
+    for (int day = 0; day < 7; ++day) {
+        DayAlarm d = week_day(day, 1);
+        legacy_set_alarm(day, d.hour, d.minute, d.active, d.volumeRamp, d.useRandomMsg, d.ringtone.c_str());
+    }
+    int legacy_keys = host_nvs_key_count();
+    int commits_before = host_nvs_commit_count();
+
+    auto start = std::chrono::steady_clock::now();
+    WeekSchedule loaded = TimeManager::getSchedule(); // Migrates on first load
+    double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+    for (int day = 0; day < 7; ++day) {
+        DayAlarm want = week_day(day, 1);
+        const DayAlarm &got = loaded.days[day];
+        CHECK_EQ(got.hour, want.hour);
+        CHECK_EQ(got.minute, want.minute);
+        CHECK_EQ(got.active, want.active);
+        CHECK_EQ(got.volumeRamp, want.volumeRamp);
+        CHECK_EQ(got.useRandomMsg, want.useRandomMsg);
+        CHECK(got.ringtone == want.ringtone);
+    }
+    CHECK_EQ(legacy_keys, 42);
+    CHECK_EQ(host_nvs_key_count(), 1); // Only the blob is left
+    int commits = host_nvs_commit_count() - commits_before;
+    CHECK_EQ(commits, 2); // Blob first, key erase after it
+
+    printf("migration: %d legacy keys -> %d key, %d commits, %.1f us\n", legacy_keys, host_nvs_key_count(), commits, us);
+    return g_host_test_failures == 0;
+}
+
+struct Cost {
+    int sets;
+    int commits;
+    double us;
+};
+
+template <typename Fn>
+static Cost measure(int rounds, Fn &&save_week) {
+    int sets = host_nvs_write_count();
+    int commits = host_nvs_commit_count();
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < rounds; ++r) save_week(r);
+    double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    return {(host_nvs_write_count() - sets) / rounds, (host_nvs_commit_count() - commits) / rounds, us / rounds};
+}
+
+int main(int argc, char **argv) {
+    int rounds = argc > 1 ? atoi(argv[1]) : 200;
+    bool ok = check_migration();
+
+    Cost legacy = measure(rounds, [](int r) {
+        for (int day = 0; day < 7; ++day) {
+            DayAlarm d = week_day(day, r);
+            legacy_set_alarm(day, d.hour, d.minute, d.active, d.volumeRamp, d.useRandomMsg, d.ringtone.c_str());
+        }
+    });
+    Cost per_day = measure(rounds, [](int r) {
+        for (int day = 0; day < 7; ++day) {
+            DayAlarm d = week_day(day, r);
+            TimeManager::setAlarm(day, d.hour, d.minute, d.active, d.volumeRamp, d.useRandomMsg, d.ringtone.c_str());
+        }
+    });
+    Cost batch = measure(rounds, [](int r) {
+        WeekSchedule week;
+        for (int day = 0; day < 7; ++day) week.days[day] = week_day(day, r);
+        TimeManager::setSchedule(week);
+    });
+
+    WeekSchedule saved = TimeManager::getSchedule();
+    for (int day = 0; day < 7; ++day) CHECK_EQ(saved.days[day].minute, week_day(day, rounds - 1).minute);
+
+    printf("save one week, %d rounds\n", rounds);
+    printf("%-28s %6s %8s %10s\n", "method", "sets", "commits", "us/week");
+    printf("%-28s %6d %8d %10.1f\n", "legacy keys, 7 setAlarm", legacy.sets, legacy.commits, legacy.us);
+    printf("%-28s %6d %8d %10.1f\n", "blob, 7 setAlarm", per_day.sets, per_day.commits, per_day.us);
+    printf("%-28s %6d %8d %10.1f\n", "blob, 1 setSchedule", batch.sets, batch.commits, batch.us);
+    CHECK_EQ(legacy.sets, 42);
+    CHECK_EQ(legacy.commits, 7);
+    CHECK_EQ(batch.sets, 1);
+    CHECK_EQ(batch.commits, 1);
+    return host_test_result("bench_alarm_schedule") || !ok;
+}
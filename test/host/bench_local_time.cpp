@@ -0,0 +1,87 @@
+// TimeManager::getCurrentTime() and its per-second LocalTimeCache against a
+// plain localtime_r() with a POSIX TZ rule, as newlib has it on the device.
+// Host times only show the ratio; on the ESP32 localtime_r re-parses TZ and
+// walks the DST rules on every call, the cache hit is a copy.
+//
+//   bench_local_time [calls]
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "LocalTimeCache.h"
+#include "TimeManager.h"
+#include "host_test.h"
+
+static volatile int g_sink;
+
+template <typename Fn>
+static double ns_per_call(int calls, Fn &&fn) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < calls; ++i) fn(i);
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / calls;
+}
+
+static bool same_tm(const struct tm &a, const struct tm &b) {
+    return a.tm_sec == b.tm_sec && a.tm_min == b.tm_min && a.tm_hour == b.tm_hour && a.tm_mday == b.tm_mday &&
+           a.tm_mon == b.tm_mon && a.tm_year == b.tm_year && a.tm_isdst == b.tm_isdst;
+}
+
+static void check_cache() {
+    LocalTimeCache cache;
+    time_t now = 1711846799; // 2024-03-31 01:59:59 CET, one second before the DST switch
+    struct tm local, out;
+    CHECK(!cache.read(now, 1, &out)); // Empty
+    localtime_r(&now, &local);
+    cache.publish(now, 1, local);
+    CHECK(cache.read(now, 1, &out) && same_tm(out, local));
+    CHECK(!cache.read(now + 1, 1, &out)); // Next second
+    CHECK(!cache.read(now, 2, &out));     // Timezone changed
+
+    struct tm direct;
+    time_t t = time(nullptr);
+    struct tm served = TimeManager::getCurrentTime();
+    localtime_r(&t, &direct);
+    CHECK(labs((long)(mktime(&served) - mktime(&direct))) <= 1);
+}
+
+int main(int argc, char **argv) {
+    int calls = argc > 1 ? atoi(argv[1]) : 1000000;
+    setenv("TZ", "CET-1CEST,M3.5.0,M10.5.0/3", 1);
+    tzset();
+    check_cache();
+
+    LocalTimeCache cache;
+    time_t base = time(nullptr);
+    struct tm t;
+    localtime_r(&base, &t);
+    cache.publish(base, 1, t);
+
+    double raw = ns_per_call(calls, [](int) {
+        struct tm tm;
+        time_t now = time(nullptr);
+        localtime_r(&now, &tm);
+        g_sink = tm.tm_sec;
+    });
+    double served = ns_per_call(calls, [](int) { g_sink = TimeManager::getCurrentTime().tm_sec; });
+    double hit = ns_per_call(calls, [&](int) {
+        struct tm tm;
+        g_sink = cache.read(base, 1, &tm) ? tm.tm_sec : -1;
+    });
+    double miss = ns_per_call(calls, [&](int i) { // A new second on every call
+        struct tm tm;
+        time_t now = base + i + 1;
+        if (!cache.read(now, 1, &tm)) {
+            localtime_r(&now, &tm);
+            cache.publish(now, 1, tm);
+        }
+        g_sink = tm.tm_sec;
+    });
+
+    printf("local time, %d calls, TZ=%s\n", calls, getenv("TZ"));
+    printf("%-28s %10s\n", "path", "ns/call");
+    printf("%-28s %10.1f\n", "time + localtime_r", raw);
+    printf("%-28s %10.1f\n", "getCurrentTime", served);
+    printf("%-28s %10.1f\n", "cache hit (read only)", hit);
+    printf("%-28s %10.1f\n", "cache miss + localtime_r", miss);
+    return host_test_result("bench_local_time");
+}
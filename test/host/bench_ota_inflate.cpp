@@ -0,0 +1,50 @@
+// Host throughput of GzipInflater per feed size. The inflate itself is zlib
+// here, not the ROM tinfl, so the numbers compare feed sizes and the per-call
+// overhead of the wrapper; they are not device figures.
+#include <chrono>
+#include <random>
+#include <vector>
+#include <stdlib.h>
+#include <zlib.h>
+#include "OtaInflate.h"
+
+static esp_err_t count_sink(void *ctx, const uint8_t *data, size_t len) {
+    *static_cast<size_t *>(ctx) += len;
+    return ESP_OK;
+}
+
+int main(int argc, char **argv) {
+    size_t image_kb = argc > 1 ? (size_t)atoi(argv[1]) : 1024;
+    std::mt19937 rng(1);
+    std::vector<uint8_t> image(image_kb * 1024);
+    for (size_t i = 0; i < image.size(); ++i) image[i] = (rng() % 4) ? (uint8_t)(i >> 4) : (uint8_t)rng();
+
+    uLongf gz_len = compressBound(image.size()) + 64;
+    std::vector<uint8_t> gz(gz_len);
+    z_stream zs = {};
+    deflateInit2(&zs, 9, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY);
+    zs.next_in = image.data();
+    zs.avail_in = (uInt)image.size();
+    zs.next_out = gz.data();
+    zs.avail_out = (uInt)gz.size();
+    deflate(&zs, Z_FINISH);
+    gz.resize(zs.total_out);
+    deflateEnd(&zs);
+
+    printf("image %zu KB, gzip %zu KB\n", image.size() / 1024, gz.size() / 1024);
+    printf("%8s %10s %10s\n", "feed", "ms", "MB/s out");
+    for (size_t piece : {(size_t)1, (size_t)16, (size_t)512, (size_t)1436, (size_t)4096, (size_t)16384}) {
+        GzipInflater inflater;
+        size_t out = 0;
+        auto start = std::chrono::steady_clock::now();
+        inflater.begin(count_sink, &out);
+        for (size_t pos = 0; pos < gz.size(); pos += piece) {
+            inflater.feed(gz.data() + pos, std::min(piece, gz.size() - pos));
+        }
+        bool ok = inflater.finish() == ESP_OK && out == image.size();
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        printf("%8zu %10.2f %10.1f%s\n", piece, ms, image.size() / 1048576.0 / (ms / 1000.0), ok ? "" : "  FAILED");
+        if (!ok) return 1;
+    }
+    return 0;
+}
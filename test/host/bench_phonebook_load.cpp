@@ -0,0 +1,127 @@
+// Boot-time cost of the phonebook: the CRC-checked binary file (save() and
+// load() through saveChanges() and begin()) against the same book in its JSON
+// form through cJSON, bare and with the table build of saveFromJson().
+// Built against the real cJSON (see CMakeLists.txt); host times only show the
+// ratio, the device adds SD access on top.
+//
+//   bench_phonebook_load [entries] [rounds]
+#include <chrono>
+#include <memory>
+#include <random>
+#include <string>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "PhonebookManager.h"
+#include "cJSON.h"
+#include "host_test.h"
+
+static const char *const kNames[] = {"Oma Erika", "Pizza Roma", "Zahnarzt Dr. Keller", "Buero", "Tante Gisela",
+                                     "Wetterbericht", "Weckzeit ansagen", "Hausmeister"};
+
+// Mix of the entry kinds the web UI creates: recorded audio, spoken text and functions
+static std::string make_book_json(size_t entries, std::mt19937 &rng) {
+    std::string json = "{";
+    for (size_t i = 0; i < entries; ++i) {
+        std::string number = std::to_string(100 + i * 37 % 90000);
+        std::string name = std::string(kNames[rng() % 8]) + " " + std::to_string(i);
+        std::string type, value, parameter;
+        switch (rng() % 3) {
+            case 0:
+                type = "AUDIO";
+                value = "/sdcard/audio/message_" + std::to_string(i) + ".wav";
+                break;
+            case 1:
+                type = "TTS";
+                value = "Hallo, hier spricht " + name + ". Bitte rufen Sie spaeter noch einmal an.";
+                break;
+            default:
+                type = "FUNCTION";
+                value = "COMPLIMENT_CAT";
+                parameter = std::to_string(1 + rng() % 5);
+                break;
+        }
+        json += (i ? ",\"" : "\"") + number + "\":{\"name\":\"" + name + "\",\"type\":\"" + type +
+                "\",\"value\":\"" + value + "\",\"parameter\":\"" + parameter + "\"}";
+    }
+    return json + "}";
+}
+
+template <typename Fn>
+static double us_per_round(int rounds, Fn &&fn) {
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < rounds; ++r) fn();
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / rounds;
+}
+
+// What the JSON import has to do before it can build the table
+static size_t parse_json_form(const char *json) {
+    cJSON *root = cJSON_Parse(json);
+    size_t count = 0;
+    cJSON *item = NULL;
+    cJSON_ArrayForEach(item, root) {
+        count += cJSON_IsString(cJSON_GetObjectItem(item, "name")) && cJSON_IsString(cJSON_GetObjectItem(item, "type")) &&
+                 cJSON_IsString(cJSON_GetObjectItem(item, "value"));
+    }
+    cJSON_Delete(root);
+    return count;
+}
+
+int main(int argc, char **argv) {
+    size_t entries = argc > 1 ? (size_t)atoi(argv[1]) : 150;
+    int rounds = argc > 2 ? atoi(argv[2]) : 200;
+
+    char dir[] = "/tmp/pb_bench_XXXXXX";
+    if (!mkdtemp(dir)) {
+        perror("mkdtemp");
+        return 1;
+    }
+    std::string file = std::string(dir) + "/phonebook.bin";
+    std::string tmp_file = std::string(dir) + "/phonebook.tmp";
+
+    std::mt19937 rng(1);
+    PhonebookManager book;
+    book.setFiles(file.c_str(), tmp_file.c_str());
+    book.begin();
+    CHECK(book.saveFromJson(make_book_json(entries, rng).c_str()));
+    CHECK_EQ(book.saveChanges(), ESP_OK);
+    book.begin(); // Adds the default numbers back, so loading below saves nothing
+    std::string json = book.getJson(); // The form GET /api/phonebook serves
+    size_t total = parse_json_form(json.c_str());
+
+    double save_us = us_per_round(rounds, [&] { CHECK_EQ(book.saveChanges(), ESP_OK); });
+    double load_us = us_per_round(rounds, [&] {
+        PhonebookManager loaded;
+        loaded.setFiles(file.c_str(), tmp_file.c_str());
+        loaded.begin();
+        CHECK(loaded.hasEntry("100"));
+    });
+    PhonebookManager check;
+    check.setFiles(file.c_str(), tmp_file.c_str());
+    check.begin();
+    CHECK(check.getJson() == json); // Lossless round trip
+
+    double parse_us = us_per_round(rounds, [&] { CHECK_EQ(parse_json_form(json.c_str()), total); });
+    double build_us = us_per_round(rounds, [&] { CHECK(book.saveFromJson(json.c_str())); });
+    double import_us = us_per_round(rounds, [&] { // POST /api/phonebook
+        CHECK(book.saveFromJson(json.c_str()));
+        CHECK_EQ(book.saveChanges(), ESP_OK);
+    });
+
+    struct stat st = {};
+    stat(file.c_str(), &st);
+    printf("phonebook %zu entries, binary %ld bytes, JSON %zu bytes, %d rounds\n", total, (long)st.st_size,
+           json.size(), rounds);
+    printf("%-36s %10s\n", "operation", "us");
+    printf("%-36s %10.1f\n", "binary save (write, fsync, rename)", save_us);
+    printf("%-36s %10.1f\n", "binary load (begin)", load_us);
+    printf("%-36s %10.1f\n", "cJSON parse + field walk", parse_us);
+    printf("%-36s %10.1f\n", "JSON load (saveFromJson)", build_us);
+    printf("%-36s %10.1f\n", "saveFromJson + saveChanges", import_us);
+
+    unlink(file.c_str());
+    unlink(tmp_file.c_str());
+    rmdir(dir);
+    return host_test_result("bench_phonebook_load");
+}
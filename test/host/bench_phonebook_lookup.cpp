@@ -0,0 +1,75 @@
+// Host cost of find() and hasEntry() on a 1,000-entry phonebook, for hits
+// and misses. Each lookup takes a table snapshot (portMUX + shared_ptr copy)
+// and does one binary search. Configure with -DHOST_TEST_SANITIZE=OFF
+// -DCMAKE_BUILD_TYPE=Release for numbers without sanitizer overhead.
+//
+//   bench_phonebook_lookup [entries] [rounds]
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+#include <stdlib.h>
+#include "PhonebookManager.h"
+
+// Distinct numbers of 3..7 digits, like a real book
+static std::vector<std::string> make_numbers(std::mt19937 &rng, size_t count, std::set<std::string> &taken) {
+    std::vector<std::string> numbers;
+    while (numbers.size() < count) {
+        std::string number = std::to_string(rng() % 10000000);
+        number.resize(3 + rng() % 5, '0');
+        if (taken.insert(number).second) numbers.push_back(number);
+    }
+    return numbers;
+}
+
+template <typename Fn>
+static double ns_per_call(const std::vector<std::string> &numbers, int rounds, size_t &found, Fn &&lookup) {
+    found = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < rounds; ++r) {
+        for (const std::string &number : numbers) found += lookup(number);
+    }
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    return ns / ((double)rounds * numbers.size());
+}
+
+int main(int argc, char **argv) {
+    size_t entries = argc > 1 ? (size_t)atoi(argv[1]) : 1000;
+    int rounds = argc > 2 ? atoi(argv[2]) : 200;
+    std::mt19937 rng(1);
+    std::set<std::string> taken;
+    std::vector<std::string> hits = make_numbers(rng, entries, taken);
+    std::vector<std::string> misses = make_numbers(rng, entries, taken);
+
+    std::string json = "{";
+    for (size_t i = 0; i < hits.size(); ++i) {
+        json += (i ? ",\"" : "\"") + hits[i] + "\":{\"name\":\"Entry " + std::to_string(i) +
+                "\",\"type\":\"TTS\",\"value\":\"Text " + std::to_string(i) + "\",\"parameter\":\"\"}";
+    }
+    json += "}";
+    phonebook.begin();
+    if (!phonebook.saveFromJson(json.c_str())) {
+        fprintf(stderr, "saveFromJson failed\n");
+        return 1;
+    }
+
+    std::shuffle(hits.begin(), hits.end(), rng); // Lookup order unrelated to the sort order
+    printf("phonebook %zu entries, %d rounds\n", entries, rounds);
+    printf("%-16s %10s\n", "lookup", "ns/call");
+    size_t found = 0;
+    bool ok = true;
+    auto report = [&](const char *name, double ns, size_t want) {
+        bool good = found == want;
+        ok = ok && good;
+        printf("%-16s %10.1f%s\n", name, ns, good ? "" : "  FAILED");
+    };
+    auto find = [](const std::string &n) { return (bool)phonebook.find(n); };
+    auto has = [](const std::string &n) { return phonebook.hasEntry(n); };
+    report("find hit", ns_per_call(hits, rounds, found, find), hits.size() * rounds);
+    report("find miss", ns_per_call(misses, rounds, found, find), 0);
+    report("hasEntry hit", ns_per_call(hits, rounds, found, has), hits.size() * rounds);
+    report("hasEntry miss", ns_per_call(misses, rounds, found, has), 0);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,33 @@
+#pragma once
+#include <stdio.h>
+
+// Minimal check macros: failures are printed and counted, main() returns
+// host_test_result() so CTest sees a non-zero exit code.
+inline int g_host_test_failures = 0;
+
+#define CHECK(cond)                                                              \
+    do {                                                                         \
+        if (!(cond)) {                                                           \
+            fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond); \
+            g_host_test_failures++;                                              \
+        }                                                                        \
+    } while (0)
+
+#define CHECK_EQ(a, b)                                                           \
+    do {                                                                         \
+        long long va_ = (long long)(a), vb_ = (long long)(b);                    \
+        if (va_ != vb_) {                                                        \
+            fprintf(stderr, "%s:%d: CHECK_EQ failed: %s == %s (%lld vs %lld)\n", \
+                    __FILE__, __LINE__, #a, #b, va_, vb_);                       \
+            g_host_test_failures++;                                              \
+        }                                                                        \
+    } while (0)
+
+inline int host_test_result(const char *name) {
+    if (g_host_test_failures) {
+        fprintf(stderr, "%s: %d check(s) failed\n", name, g_host_test_failures);
+        return 1;
+    }
+    printf("%s: all checks passed\n", name);
+    return 0;
+}
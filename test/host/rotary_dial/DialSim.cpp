@@ -0,0 +1,139 @@
+#include "DialSim.h"
+#include "HostDialHal.h"
+#include <algorithm>
+#include <fstream>
+
+DialSim *DialSim::s_active = nullptr;
+
+static void add_edge(std::vector<DialWave> &out, int64_t t, int pin, int level, int bounces, int bounce_us) {
+    // A bouncing contact reaches its new level, falls back and settles again
+    for (int b = 0; b < bounces; ++b) {
+        out.push_back({t, pin, level});
+        out.push_back({t + bounce_us / 2, pin, !level});
+        t += bounce_us;
+    }
+    out.push_back({t, pin, level});
+}
+
+std::vector<DialWave> dial_synthesize(const DialScenario &sc, std::mt19937 &rng) {
+    std::uniform_real_distribution<double> unit(-1.0, 1.0);
+    std::vector<DialWave> out;
+    int64_t t = 200000;
+    add_edge(out, t, DialSim::kHookPin, 0, 2, 2000); // Lift the handset
+    t += 800000;
+
+    for (const char *d = sc.digits; *d; ++d) {
+        int pulses = *d == '0' ? 10 : *d - '0';
+        for (int k = 0; k < pulses; ++k) {
+            int64_t period_us = (int64_t)(1e6 / sc.pps * (1.0 + sc.jitter * unit(rng)));
+            // Idle low with the pull-up and an active-low contact: a pulse is high
+            add_edge(out, t, DialSim::kPulsePin, 1, sc.break_bounces, sc.bounce_us);
+            add_edge(out, t + (int64_t)(period_us * sc.break_ratio), DialSim::kPulsePin, 0, sc.make_bounces, sc.bounce_us);
+            t += period_us;
+        }
+        for (int g = 0; g < sc.hook_glitches; ++g) {
+            int64_t at = t + 20000 + (int64_t)(rng() % 100000);
+            out.push_back({at, DialSim::kHookPin, 1});
+            out.push_back({at + 2000 + (int64_t)(rng() % 20000), DialSim::kHookPin, 0});
+        }
+        t += (int64_t)sc.pause_ms * 1000;
+    }
+
+    t += 2500000;
+    add_edge(out, t, DialSim::kHookPin, 1, 2, 2000); // Hang up
+    std::stable_sort(out.begin(), out.end(), [](const DialWave &a, const DialWave &b) { return a.time_us < b.time_us; });
+    return out;
+}
+
+DialSim::DialSim() {
+    host_dial::reset();
+    host_dial::setLevelQuiet(kPulsePin, 0);
+    s_active = this;
+    _dial = new RotaryDial(kPulsePin, kHookPin, kButtonPin, -1);
+    _dial->setHal(&host_dial::kHal);
+    _dial->setPulseActiveLow(APP_DIAL_PULSE_ACTIVE_LOW);
+    _dial->onDialComplete(onDigit);
+    _dial->onHookChange(onHook);
+    _dial->begin();
+}
+
+DialSim::~DialSim() {
+    delete _dial;
+    if (s_active == this) s_active = nullptr;
+}
+
+void DialSim::onDigit(int digit) {
+    if (s_active) s_active->digits.push_back({digit, host_dial::now(), s_active->_last_pulse_us});
+}
+
+void DialSim::onHook(bool off_hook) {
+    if (s_active) s_active->hook_changes.push_back(off_hook);
+}
+
+void DialSim::runUntil(int64_t time_us) {
+    while (host_dial::now() <= time_us) {
+        _dial->loop();
+        loops++;
+        uint32_t wait_ms = _dial->nextWakeMs();
+        if (wait_ms > APP_INPUT_IDLE_WAIT_MS) wait_ms = APP_INPUT_IDLE_WAIT_MS;
+        if (wait_ms < 1) wait_ms = 1; // waitForEvent() always yields a tick
+        int64_t next = host_dial::now() + (int64_t)wait_ms * 1000;
+        if (next > time_us) break;
+        host_dial::setTime(next);
+    }
+    host_dial::setTime(time_us);
+}
+
+void DialSim::apply(const DialWave &wave) {
+    runUntil(wave.time_us);
+    if (wave.pin == kPulsePin && wave.level == (APP_DIAL_PULSE_ACTIVE_LOW ? 1 : 0)) _last_pulse_us = wave.time_us;
+    host_dial::setLevel(wave.pin, wave.level);
+    if (host_dial::takeEvent()) {
+        _dial->loop(); // The ISR woke the input task
+        loops++;
+    }
+}
+
+void DialSim::replay(const RotaryDial::TraceEdge &edge) {
+    runUntil(edge.time_us);
+    static const int pins[] = {kPulsePin, kHookPin, kButtonPin};
+    if (edge.source > RotaryDial::EDGE_BUTTON) return;
+    if (edge.source == RotaryDial::EDGE_PULSE && edge.level == (APP_DIAL_PULSE_ACTIVE_LOW ? 1 : 0)) {
+        _last_pulse_us = edge.time_us;
+    }
+    host_dial::setLevelQuiet(pins[edge.source], edge.level);
+    _dial->feedEdge(edge.source, edge.level, edge.time_us, edge.mode_active);
+    _dial->loop();
+    loops++;
+}
+
+void DialSim::play(const std::vector<DialWave> &waves, int64_t settle_us) {
+    for (const DialWave &w : waves) apply(w);
+    runUntil(host_dial::now() + settle_us);
+}
+
+std::string dial_digits(const std::vector<DialSim::Digit> &digits) {
+    std::string s;
+    for (const DialSim::Digit &d : digits) s += (char)('0' + d.digit);
+    return s;
+}
+
+// Reads a trace CSV; expected digits come from a "digits=" comment
+bool dial_read_trace(const char *path, std::vector<RotaryDial::TraceEdge> &edges, std::string &digits) {
+    std::ifstream in(path);
+    if (!in) return false;
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.empty()) continue;
+        if (line[0] == '#') {
+            size_t at = line.find("digits=");
+            if (at != std::string::npos) digits = line.substr(at + 7, line.find_first_not_of("0123456789", at + 7) - at - 7);
+            continue;
+        }
+        long long time_us;
+        unsigned source, level, mode;
+        if (sscanf(line.c_str(), "%lld,%u,%u,%u", &time_us, &source, &level, &mode) != 4) continue;
+        edges.push_back({time_us, (uint8_t)source, (uint8_t)level, (uint8_t)mode});
+    }
+    return true;
+}
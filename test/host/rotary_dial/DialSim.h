@@ -0,0 +1,72 @@
+#pragma once
+#include <stdint.h>
+#include <random>
+#include <string>
+#include <vector>
+#include "RotaryDial.h"
+#include "app_config.h"
+
+// Synthesized pin waveform: one level change on one pin
+struct DialWave {
+    int64_t time_us;
+    int pin;
+    int level;
+};
+
+// Parameters of a synthetic dialing session: lift, dial the digits, hang up
+struct DialScenario {
+    const char *name;
+    const char *digits;
+    double pps;           // Nominal pulses per second
+    double break_ratio;   // Share of the period the contact is open (pulse high)
+    double jitter;        // Random period deviation, +- fraction
+    int break_bounces;    // Extra contact bounces when the pulse starts (contact opens)
+    int make_bounces;     // ... and when it ends (contact closes)
+    int bounce_us;        // Spacing of the bounces
+    int pause_ms;         // Finger travel between two digits
+    int hook_glitches;    // Short hook contact openings while dialing
+    bool in_spec;         // Must decode without error
+};
+
+std::vector<DialWave> dial_synthesize(const DialScenario &sc, std::mt19937 &rng);
+
+// Drives one RotaryDial on the host HAL the way input_task does: loop() on
+// every edge and whenever nextWakeMs() (capped at APP_INPUT_IDLE_WAIT_MS) runs out.
+class DialSim {
+public:
+    static constexpr int kPulsePin = APP_PIN_DIAL_PULSE;
+    static constexpr int kHookPin = APP_PIN_HOOK;
+    static constexpr int kButtonPin = APP_PIN_EXTRA_BTN;
+
+    struct Digit {
+        int digit;
+        int64_t time_us;       // When the callback ran
+        int64_t last_pulse_us; // Last counted-edge candidate before it
+    };
+
+    DialSim(); // Resets the HAL (not its key store) and begins a fresh dial
+    ~DialSim();
+
+    RotaryDial &dial() { return *_dial; }
+    void runUntil(int64_t time_us);
+    void apply(const DialWave &wave);                  // Through the pin and its ISR
+    void replay(const RotaryDial::TraceEdge &edge);    // Through feedEdge(), as /api/input/trace rows
+    void play(const std::vector<DialWave> &waves, int64_t settle_us = 3000000);
+
+    std::vector<Digit> digits;
+    std::vector<bool> hook_changes;
+    int loops = 0;
+
+private:
+    static void onDigit(int digit);
+    static void onHook(bool off_hook);
+    static DialSim *s_active;
+
+    RotaryDial *_dial;
+    int64_t _last_pulse_us = 0;
+};
+
+std::string dial_digits(const std::vector<DialSim::Digit> &digits);
+
+// Reads an /api/input/trace CSV; expected digits come from a "digits=" comment
+bool dial_read_trace(const char *path, std::vector<RotaryDial::TraceEdge> &edges, std::string &digits);
@@ -0,0 +1,101 @@
+#include "HostDialHal.h"
+#include <map>
+#include <string>
+
+namespace host_dial {
+namespace {
+
+struct Pin {
+    int level = 1;
+    RotaryDialIrq irq = RotaryDialIrq::None;
+    rotary_dial_isr_t isr = nullptr;
+    void *arg = nullptr;
+};
+
+int64_t s_now_us = 0;
+std::map<int, Pin> s_pins;
+bool s_event = false;
+std::map<std::string, uint16_t> s_store;
+int s_saves = 0;
+
+int64_t hal_time_us() { return s_now_us; }
+
+int hal_get_level(int pin) {
+    auto it = s_pins.find(pin);
+    return it == s_pins.end() ? 1 : it->second.level;
+}
+
+bool hal_setup_input(int pin, RotaryDialIrq irq, rotary_dial_isr_t isr, void *arg) {
+    if (pin < 0) return false;
+    Pin &p = s_pins[pin];
+    p.irq = irq;
+    p.isr = isr;
+    p.arg = arg;
+    return true;
+}
+
+bool hal_wait_event(uint32_t) { return takeEvent(); }
+
+void hal_signal_event(bool) { s_event = true; }
+
+bool hal_load_u16(const char *key, uint16_t *value) { return stored(key, value); }
+
+bool hal_save_u16(const char *key, uint16_t value) {
+    s_store[key] = value;
+    s_saves++;
+    return true;
+}
+
+} // namespace
+
+const RotaryDialHal kHal = {
+    hal_time_us, hal_get_level, hal_setup_input, hal_wait_event, hal_signal_event, hal_load_u16, hal_save_u16,
+};
+
+void reset() {
+    s_now_us = 0;
+    s_pins.clear();
+    s_event = false;
+}
+
+void clearStore() {
+    s_store.clear();
+    s_saves = 0;
+}
+
+void setTime(int64_t time_us) {
+    if (time_us > s_now_us) s_now_us = time_us;
+}
+
+int64_t now() { return s_now_us; }
+
+void setLevel(int pin, int level) {
+    Pin &p = s_pins[pin];
+    int old = p.level;
+    p.level = level ? 1 : 0;
+    if (!p.isr || old == p.level) return;
+    bool rising = p.level == 1;
+    if (p.irq == RotaryDialIrq::AnyEdge || (p.irq == RotaryDialIrq::Rising && rising) ||
+        (p.irq == RotaryDialIrq::Falling && !rising)) {
+        p.isr(p.arg);
+    }
+}
+
+void setLevelQuiet(int pin, int level) { s_pins[pin].level = level ? 1 : 0; }
+
+bool takeEvent() {
+    bool event = s_event;
+    s_event = false;
+    return event;
+}
+
+int saveCount() { return s_saves; }
+
+bool stored(const char *key, uint16_t *value) {
+    auto it = s_store.find(key);
+    if (it == s_store.end()) return false;
+    *value = it->second;
+    return true;
+}
+
+} // namespace host_dial
@@ -0,0 +1,22 @@
+#pragma once
+#include <stdint.h>
+#include "RotaryDialHal.h"
+
+// Simulated board behind RotaryDialHal: a virtual microsecond clock, pin
+// levels that fire the registered ISR on matching edges, the input task's
+// event flag and an in-memory key store standing in for NVS.
+namespace host_dial {
+
+extern const RotaryDialHal kHal;
+
+void reset();                       // Clock 0, all pins high (pull-ups), no ISRs, store kept
+void clearStore();
+void setTime(int64_t time_us);      // Never moves backwards
+int64_t now();
+void setLevel(int pin, int level);  // Fires the pin's ISR if the edge matches its irq
+void setLevelQuiet(int pin, int level); // Level only, for edges injected via feedEdge()
+bool takeEvent();                   // Pending signal_event(), cleared on read
+int saveCount();                    // save_u16() calls since clearStore()
+bool stored(const char *key, uint16_t *value);
+
+} // namespace host_dial
@@ -0,0 +1,147 @@
+// RotaryDial simulator. Without arguments it runs the synthetic scenarios
+// below over many seeds and reports decode accuracy, digit decision latency
+// (last pulse to callback) and hook misdetections; in-spec scenarios must
+// decode without error. Arguments are /api/input/trace CSV files to replay;
+// a "digits=" comment in the file gives the expected result.
+//
+//   rotary_dial_sim                 run the scenarios
+//   rotary_dial_sim trace.csv ...   replay traces
+//   rotary_dial_sim --emit NAME     print one run of a scenario as trace CSV
+#include <algorithm>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "DialSim.h"
+#include "HostDialHal.h"
+
+static const DialScenario kScenarios[] = {
+    // name            digits   pps   break jitter brk mk  b_us  pause hook  in_spec
+    {"nominal_10pps",  "0711",  10.0, 0.60, 0.00,  0,  0,  0,    700,  0,    true},
+    {"break_bounce",   "0711",  10.0, 0.60, 0.05,  3,  0,  1000, 700,  0,    true},
+    {"slow_6pps",      "5309",  6.0,  0.65, 0.05,  1,  0,  1000, 900,  0,    true},
+    {"fast_12pps",     "4711",  12.0, 0.60, 0.05,  1,  0,  800,  600,  0,    true},
+    {"noisy_hook",     "110",   10.0, 0.60, 0.05,  1,  0,  1000, 700,  3,    true},
+    {"make_bounce",    "0711",  10.0, 0.60, 0.05,  0,  3,  1000, 700,  0,    false},
+    {"too_fast_20pps", "4711",  20.0, 0.60, 0.00,  0,  0,  0,    600,  0,    false},
+};
+
+static const int kRuns = 25;
+
+struct Stats {
+    int expected = 0;
+    int errors = 0;
+    int hook_errors = 0;
+    int64_t latency_sum_us = 0;
+    int64_t latency_min_us = INT64_MAX;
+    int64_t latency_max_us = 0;
+    int latency_count = 0;
+
+    void add(const std::string &want, const DialSim &sim, bool check_hook) {
+        std::string got = dial_digits(sim.digits);
+        expected += (int)want.size();
+        size_t common = std::min(want.size(), got.size());
+        for (size_t i = 0; i < common; ++i) errors += want[i] != got[i];
+        errors += (int)(std::max(want.size(), got.size()) - common);
+        if (check_hook && sim.hook_changes != std::vector<bool>{true, false}) hook_errors++;
+        for (const DialSim::Digit &d : sim.digits) {
+            int64_t latency = d.time_us - d.last_pulse_us;
+            latency_sum_us += latency;
+            latency_min_us = std::min(latency_min_us, latency);
+            latency_max_us = std::max(latency_max_us, latency);
+            latency_count++;
+        }
+    }
+
+    double accuracy() const { return expected ? 100.0 * std::max(0, expected - errors) / expected : 100.0; }
+
+    void print(const char *name, const char *note) const {
+        if (latency_count == 0) {
+            printf("%-20s %7.1f%% %8s %8s %8s %6d  %s\n", name, accuracy(), "-", "-", "-", hook_errors, note);
+            return;
+        }
+        printf("%-20s %7.1f%% %8.1f %8.1f %8.1f %6d  %s\n", name, accuracy(), latency_min_us / 1000.0,
+               latency_sum_us / 1000.0 / latency_count, latency_max_us / 1000.0, hook_errors, note);
+    }
+};
+
+static void print_header() {
+    printf("%-20s %8s %8s %8s %8s %6s\n", "scenario", "accuracy", "lat_min", "lat_avg", "lat_max", "hook");
+    printf("%-20s %8s %8s %8s %8s %6s\n", "", "", "ms", "ms", "ms", "errors");
+}
+
+static int run_scenarios() {
+    print_header();
+    int failures = 0;
+    for (const DialScenario &sc : kScenarios) {
+        Stats stats;
+        for (int run = 0; run < kRuns; ++run) {
+            std::mt19937 rng(1000 + run);
+            host_dial::clearStore(); // Cold start: nothing learned yet
+            DialSim sim;
+            sim.play(dial_synthesize(sc, rng));
+            stats.add(sc.digits, sim, true);
+        }
+        bool failed = sc.in_spec && (stats.errors || stats.hook_errors);
+        failures += failed;
+        stats.print(sc.name, failed ? "FAILED" : (sc.in_spec ? "" : "(out of spec, reported only)"));
+    }
+    return failures ? 1 : 0;
+}
+
+static int emit(const char *name) {
+    for (const DialScenario &sc : kScenarios) {
+        if (strcmp(sc.name, name) != 0) continue;
+        std::mt19937 rng(1);
+        host_dial::clearStore();
+        DialSim sim;
+        sim.play(dial_synthesize(sc, rng));
+        std::vector<RotaryDial::TraceEdge> edges(sim.dial().traceCapacity());
+        size_t count = sim.dial().copyTrace(edges.data(), edges.size());
+        printf("# input trace v1, source 0=pulse 1=hook 2=button, edges=%u, overflows=%lu\n",
+               (unsigned)count, (unsigned long)sim.dial().edgeOverflows());
+        printf("# synthesized: rotary_dial_sim --emit %s (%.1f pps, break %.0f%%, jitter %.0f%%), digits=%s\n",
+               sc.name, sc.pps, sc.break_ratio * 100, sc.jitter * 100, sc.digits);
+        printf("time_us,source,level,mode_active\n");
+        for (size_t i = 0; i < count; ++i) {
+            printf("%lld,%u,%u,%u\n", (long long)edges[i].time_us, (unsigned)edges[i].source,
+                   (unsigned)edges[i].level, (unsigned)edges[i].mode_active);
+        }
+        return 0;
+    }
+    fprintf(stderr, "unknown scenario %s\n", name);
+    return 2;
+}
+
+static int replay(int argc, char **argv) {
+    print_header();
+    int failures = 0;
+    for (int i = 1; i < argc; ++i) {
+        std::vector<RotaryDial::TraceEdge> edges;
+        std::string want;
+        if (!dial_read_trace(argv[i], edges, want)) {
+            fprintf(stderr, "cannot read %s\n", argv[i]);
+            failures++;
+            continue;
+        }
+        host_dial::clearStore();
+        DialSim sim;
+        for (const RotaryDial::TraceEdge &e : edges) sim.replay(e);
+        sim.runUntil((edges.empty() ? 0 : edges.back().time_us) + 3000000);
+
+        Stats stats;
+        stats.add(want, sim, false);
+        std::string got = dial_digits(sim.digits);
+        bool failed = !want.empty() && got != want;
+        failures += failed;
+        std::string note = "decoded " + got + (want.empty() ? "" : " expected " + want) + (failed ? " FAILED" : "");
+        const char *base = strrchr(argv[i], '/');
+        stats.print(base ? base + 1 : argv[i], note.c_str());
+    }
+    return failures ? 1 : 0;
+}
+
+int main(int argc, char **argv) {
+    if (argc == 3 && strcmp(argv[1], "--emit") == 0) return emit(argv[2]);
+    if (argc > 1) return replay(argc, argv);
+    return run_scenarios();
+}
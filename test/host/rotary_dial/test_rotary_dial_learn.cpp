@@ -0,0 +1,118 @@
+// Learned digit gap (APP_DIAL_GAP_ADAPTIVE): replays the slow and fast dial
+// traces in traces/ and synthetic dials with exact periods, and checks the
+// learned period, the gap clamp and when the period is persisted.
+#include <stdlib.h>
+#include <string>
+#include "DialSim.h"
+#include "HostDialHal.h"
+#include "host_test.h"
+
+static uint32_t expected_gap(uint32_t period_ms) {
+    uint32_t gap = period_ms * APP_DIAL_GAP_PERIOD_FACTOR;
+    if (gap < APP_DIAL_GAP_MIN_MS) gap = APP_DIAL_GAP_MIN_MS;
+    if (gap > APP_DIAL_DIGIT_GAP_MS) gap = APP_DIAL_DIGIT_GAP_MS;
+    return gap;
+}
+
+// Plays a session of exact-period digits starting one second from now
+static void dial_at(DialSim &sim, const char *digits, double period_ms) {
+    DialScenario sc = {"exact", digits, 1000.0 / period_ms, 0.6, 0.0, 0, 0, 0, 800, 0, true};
+    std::mt19937 rng(1);
+    std::vector<DialWave> waves = dial_synthesize(sc, rng);
+    int64_t offset = host_dial::now() + 1000000;
+    for (DialWave &w : waves) w.time_us += offset;
+    sim.play(waves);
+}
+
+static void test_trace(const char *file, uint32_t nominal_period_ms) {
+    std::vector<RotaryDial::TraceEdge> edges;
+    std::string want;
+    CHECK(dial_read_trace((std::string(HOST_TRACE_DIR) + "/" + file).c_str(), edges, want));
+    CHECK(!edges.empty() && !want.empty());
+
+    host_dial::clearStore();
+    DialSim sim;
+    for (const RotaryDial::TraceEdge &e : edges) sim.replay(e);
+    sim.runUntil(edges.back().time_us + 3000000);
+
+    CHECK(dial_digits(sim.digits) == want);
+    uint32_t period = sim.dial().learnedPeriodMs();
+    CHECK(abs((int)period - (int)nominal_period_ms) <= (int)nominal_period_ms / 20); // Traces have 5% jitter
+    CHECK_EQ(sim.dial().digitGapMs(), expected_gap(period));
+    // Once learned, a digit completes one gap after its last pulse
+    const DialSim::Digit &last = sim.digits.back();
+    CHECK(last.time_us - last.last_pulse_us <= (int64_t)(expected_gap(period) + 2) * 1000);
+    printf("%s: period %u ms, gap %u ms\n", file, (unsigned)period, (unsigned)sim.dial().digitGapMs());
+}
+
+static void test_gap_clamp() {
+    struct { double period_ms; uint32_t gap_ms; } cases[] = {
+        {100.0, 300},                  // 10 pps: 3 x period
+        {66.0, APP_DIAL_GAP_MIN_MS},   // 15 pps: 198 ms, raised to the minimum
+        {190.0, APP_DIAL_DIGIT_GAP_MS} // 5.3 pps: 570 ms, capped at the fixed gap
+    };
+    for (const auto &c : cases) {
+        host_dial::clearStore();
+        DialSim sim;
+        CHECK_EQ(sim.dial().digitGapMs(), APP_DIAL_DIGIT_GAP_MS); // Nothing learned yet
+        dial_at(sim, "0", c.period_ms);
+        CHECK_EQ(sim.dial().learnedPeriodMs(), (uint32_t)c.period_ms);
+        CHECK_EQ(sim.dial().digitGapMs(), c.gap_ms);
+    }
+
+    // Fewer than APP_DIAL_LEARN_MIN_SAMPLES periods keep the fixed gap
+    host_dial::clearStore();
+    DialSim sim;
+    dial_at(sim, "5", 100.0);
+    CHECK_EQ(sim.dial().learnedPeriodMs(), 0);
+    CHECK_EQ(sim.dial().digitGapMs(), APP_DIAL_DIGIT_GAP_MS);
+}
+
+static void test_persistence() {
+    host_dial::clearStore();
+    uint16_t stored = 0;
+    {
+        DialSim sim;
+        dial_at(sim, "0", 100.0);
+        CHECK_EQ(host_dial::saveCount(), 1); // First learned value is saved right away
+        CHECK(host_dial::stored("dial_period", &stored) && stored == 100);
+
+        // A big change inside the save interval waits
+        dial_at(sim, "00000", 110.0);
+        CHECK_EQ(sim.dial().learnedPeriodMs(), 110);
+        CHECK_EQ(host_dial::saveCount(), 1);
+
+        // After the interval, the pending change is written with the next digit
+        sim.runUntil(host_dial::now() + (int64_t)APP_DIAL_LEARN_SAVE_INTERVAL_MS * 1000);
+        dial_at(sim, "0", 110.0);
+        CHECK_EQ(host_dial::saveCount(), 2);
+        CHECK(host_dial::stored("dial_period", &stored) && stored == 110);
+
+        // A drift below 3 ms is not worth a flash write, even after the interval
+        sim.runUntil(host_dial::now() + (int64_t)APP_DIAL_LEARN_SAVE_INTERVAL_MS * 1000);
+        dial_at(sim, "000", 112.0);
+        CHECK_EQ(sim.dial().learnedPeriodMs(), 112);
+        CHECK_EQ(host_dial::saveCount(), 2);
+
+        // 3 ms is
+        dial_at(sim, "000", 113.0);
+        CHECK_EQ(sim.dial().learnedPeriodMs(), 113);
+        CHECK_EQ(host_dial::saveCount(), 3);
+        CHECK(host_dial::stored("dial_period", &stored) && stored == 113);
+    }
+
+    // A new boot starts from the stored period
+    DialSim sim;
+    CHECK_EQ(sim.dial().learnedPeriodMs(), 113);
+    CHECK_EQ(sim.dial().digitGapMs(), expected_gap(113));
+    dial_at(sim, "0", 113.0);
+    CHECK_EQ(host_dial::saveCount(), 3); // Unchanged value is not written again
+}
+
+int main() {
+    test_trace("slow_dial_6pps.csv", 167);
+    test_trace("fast_dial_12pps.csv", 83);
+    test_gap_clamp();
+    test_persistence();
+    return host_test_result("test_rotary_dial_learn");
+}
@@ -0,0 +1,128 @@
+// Parsing subset of cJSON for the host tests; bench_phonebook_load links the
+// real cJSON instead when it is available
+#include <string>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include "cJSON.h"
+
+static const char *json_skip(const char *p) {
+    while (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r') p++;
+    return p;
+}
+
+static const char *json_parse_value(cJSON *item, const char *p);
+
+// Strings only need the escapes the web UI produces; \u is kept for ASCII
+static const char *json_parse_string(char **out, const char *p) {
+    if (*p != '"') return nullptr;
+    std::string str;
+    for (p++; *p != '"'; p++) {
+        if (!*p) return nullptr;
+        if (*p != '\\') {
+            str += *p;
+            continue;
+        }
+        switch (*++p) {
+            case 'n': str += '\n'; break;
+            case 't': str += '\t'; break;
+            case 'r': str += '\r'; break;
+            case 'b': str += '\b'; break;
+            case 'f': str += '\f'; break;
+            case 'u':
+                if (strlen(p) < 5) return nullptr;
+                str += (char)strtol(std::string(p + 1, 4).c_str(), nullptr, 16);
+                p += 4;
+                break;
+            case '\0': return nullptr;
+            default: str += *p; break;
+        }
+    }
+    *out = strdup(str.c_str());
+    return p + 1;
+}
+
+static const char *json_parse_container(cJSON *item, const char *p, char close) {
+    item->type = close == '}' ? cJSON_Object : cJSON_Array;
+    p = json_skip(p + 1);
+    if (*p == close) return p + 1;
+    cJSON *last = nullptr;
+    for (;;) {
+        cJSON *child = (cJSON *)calloc(1, sizeof(cJSON));
+        if (last) {
+            last->next = child;
+            child->prev = last;
+        } else {
+            item->child = child;
+        }
+        last = child;
+        p = json_skip(p);
+        if (close == '}') {
+            p = json_parse_string(&child->string, p);
+            if (!p) return nullptr;
+            p = json_skip(p);
+            if (*p++ != ':') return nullptr;
+        }
+        p = json_parse_value(child, json_skip(p));
+        if (!p) return nullptr;
+        p = json_skip(p);
+        if (*p == ',') {
+            p++;
+            continue;
+        }
+        if (*p != close) return nullptr;
+        return p + 1;
+    }
+}
+
+static const char *json_parse_value(cJSON *item, const char *p) {
+    if (*p == '{') return json_parse_container(item, p, '}');
+    if (*p == '[') return json_parse_container(item, p, ']');
+    if (*p == '"') {
+        item->type = cJSON_String;
+        return json_parse_string(&item->valuestring, p);
+    }
+    if (!strncmp(p, "true", 4)) { item->type = cJSON_True; item->valueint = 1; return p + 4; }
+    if (!strncmp(p, "false", 5)) { item->type = cJSON_False; return p + 5; }
+    if (!strncmp(p, "null", 4)) { item->type = cJSON_NULL; return p + 4; }
+    char *end = nullptr;
+    double number = strtod(p, &end);
+    if (end == p) return nullptr;
+    item->type = cJSON_Number;
+    item->valuedouble = number;
+    item->valueint = (int)number;
+    return end;
+}
+
+cJSON *cJSON_Parse(const char *value) {
+    if (!value) return nullptr;
+    cJSON *root = (cJSON *)calloc(1, sizeof(cJSON));
+    const char *end = json_parse_value(root, json_skip(value));
+    if (!end || *json_skip(end)) {
+        cJSON_Delete(root);
+        return nullptr;
+    }
+    return root;
+}
+
+void cJSON_Delete(cJSON *item) {
+    while (item) {
+        cJSON *next = item->next;
+        cJSON_Delete(item->child);
+        free(item->valuestring);
+        free(item->string);
+        free(item);
+        item = next;
+    }
+}
+
+cJSON *cJSON_GetObjectItem(const cJSON *object, const char *string) {
+    if (!object) return nullptr;
+    for (cJSON *child = object->child; child; child = child->next) {
+        if (child->string && !strcasecmp(child->string, string)) return child;
+    }
+    return nullptr;
+}
+
+int cJSON_IsString(const cJSON *item) { return item && item->type == cJSON_String; }
+int cJSON_IsObject(const cJSON *item) { return item && item->type == cJSON_Object; }
@@ -0,0 +1,32 @@
+#pragma once
+// Parsing subset of the cJSON API, enough for the phonebook import
+#include <stddef.h>
+
+#define cJSON_Invalid 0
+#define cJSON_False (1 << 0)
+#define cJSON_True (1 << 1)
+#define cJSON_NULL (1 << 2)
+#define cJSON_Number (1 << 3)
+#define cJSON_String (1 << 4)
+#define cJSON_Array (1 << 5)
+#define cJSON_Object (1 << 6)
+
+typedef struct cJSON {
+    struct cJSON *next;
+    struct cJSON *prev;
+    struct cJSON *child;
+    int type;
+    char *valuestring;
+    int valueint;
+    double valuedouble;
+    char *string;
+} cJSON;
+
+cJSON *cJSON_Parse(const char *value);
+void cJSON_Delete(cJSON *item);
+cJSON *cJSON_GetObjectItem(const cJSON *object, const char *string);
+int cJSON_IsString(const cJSON *item);
+int cJSON_IsObject(const cJSON *item);
+
+#define cJSON_ArrayForEach(element, array) \
+    for (element = (array != NULL) ? (array)->child : NULL; element != NULL; element = element->next)
@@ -0,0 +1,11 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#define MALLOC_CAP_8BIT 0x04
+#define MALLOC_CAP_SPIRAM 0x400
+#define MALLOC_CAP_INTERNAL 0x800
+
+static inline void *heap_caps_malloc(size_t size, uint32_t) { return malloc(size); }
+static inline size_t heap_caps_get_largest_free_block(uint32_t) { return 0; }
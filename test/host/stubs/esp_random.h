@@ -0,0 +1,5 @@
+#pragma once
+#include <stdint.h>
+#include <stdlib.h>
+
+static inline uint32_t esp_random(void) { return (uint32_t)rand(); }
@@ -0,0 +1,15 @@
+#pragma once
+#include <sys/time.h>
+
+// No network on the host: SNTP never syncs
+typedef enum { SNTP_SYNC_STATUS_RESET, SNTP_SYNC_STATUS_COMPLETED, SNTP_SYNC_STATUS_IN_PROGRESS } sntp_sync_status_t;
+#define SNTP_OPMODE_POLL 0
+
+typedef void (*sntp_sync_time_cb_t)(struct timeval *tv);
+
+static inline void esp_sntp_setoperatingmode(int) {}
+static inline void esp_sntp_setservername(int, const char *) {}
+static inline void esp_sntp_init(void) {}
+static inline void esp_sntp_stop(void) {}
+static inline sntp_sync_status_t esp_sntp_get_sync_status(void) { return SNTP_SYNC_STATUS_RESET; }
+static inline void sntp_set_time_sync_notification_cb(sntp_sync_time_cb_t) {}
@@ -0,0 +1,29 @@
+#pragma once
+#include <stdint.h>
+#include <atomic>
+#include <thread>
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+#define pdTRUE 1
+#define pdFALSE 0
+#define portMAX_DELAY 0xffffffffu
+#define portTICK_PERIOD_MS 1
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
+
+// Spinlock, like the ESP-IDF portMUX, so critical sections are real on the host
+struct portMUX_TYPE {
+    std::atomic<bool> locked;
+};
+#define portMUX_INITIALIZER_UNLOCKED {false}
+
+static inline void host_mux_enter(portMUX_TYPE *mux) {
+    while (mux->locked.exchange(true, std::memory_order_acquire)) std::this_thread::yield();
+}
+static inline void host_mux_exit(portMUX_TYPE *mux) { mux->locked.store(false, std::memory_order_release); }
+
+#define portENTER_CRITICAL(mux) host_mux_enter(mux)
+#define portEXIT_CRITICAL(mux) host_mux_exit(mux)
+#define portENTER_CRITICAL_ISR(mux) host_mux_enter(mux)
+#define portEXIT_CRITICAL_ISR(mux) host_mux_exit(mux)
+#define portYIELD_FROM_ISR(woken) (void)(woken)
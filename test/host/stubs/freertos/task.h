@@ -0,0 +1,14 @@
+#pragma once
+#include <chrono>
+#include <thread>
+#include "FreeRTOS.h"
+
+typedef void *TaskHandle_t;
+typedef void (*TaskFunction_t)(void *);
+
+// Tasks are not started on the host; code under test must not depend on them
+static inline BaseType_t xTaskCreate(TaskFunction_t, const char *, uint32_t, void *, int, TaskHandle_t *created) {
+    if (created) *created = nullptr;
+    return pdFALSE;
+}
+static inline void vTaskDelay(TickType_t ticks) { std::this_thread::sleep_for(std::chrono::milliseconds(ticks)); }
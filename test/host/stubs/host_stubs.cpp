@@ -0,0 +1,169 @@
+// Implementations behind the host stub headers
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <string>
+#include <stdlib.h>
+#include <string.h>
+#include "esp_rom_crc.h"
+#include "esp_timer.h"
+#include "nvs.h"
+#include "freertos/semphr.h"
+
+int64_t esp_timer_get_time(void) {
+    static const auto start = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+const char *esp_err_to_name(esp_err_t code) {
+    switch (code) {
+        case ESP_OK: return "ESP_OK";
+        case ESP_FAIL: return "ESP_FAIL";
+        case ESP_ERR_NO_MEM: return "ESP_ERR_NO_MEM";
+        case ESP_ERR_INVALID_ARG: return "ESP_ERR_INVALID_ARG";
+        case ESP_ERR_INVALID_STATE: return "ESP_ERR_INVALID_STATE";
+        case ESP_ERR_INVALID_SIZE: return "ESP_ERR_INVALID_SIZE";
+        case ESP_ERR_NOT_FOUND: return "ESP_ERR_NOT_FOUND";
+        case ESP_ERR_INVALID_CRC: return "ESP_ERR_INVALID_CRC";
+        case ESP_ERR_NVS_NOT_FOUND: return "ESP_ERR_NVS_NOT_FOUND";
+        case ESP_ERR_NVS_INVALID_LENGTH: return "ESP_ERR_NVS_INVALID_LENGTH";
+        default: return "ESP_ERR";
+    }
+}
+
+// Table-driven like the ROM version, so benchmarks do not pay for a bitwise loop
+uint32_t esp_rom_crc32_le(uint32_t crc, const uint8_t *buf, uint32_t len) {
+    static const auto table = [] {
+        std::array<uint32_t, 256> t{};
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; k++) c = (c >> 1) ^ (0xEDB88320u & (0u - (c & 1)));
+            t[i] = c;
+        }
+        return t;
+    }();
+    crc = ~crc;
+    while (len--) crc = (crc >> 8) ^ table[(crc ^ *buf++) & 0xFF];
+    return ~crc;
+}
+
+// --- NVS ---------------------------------------------------------------------
+
+static std::map<std::string, std::string> s_nvs; // "namespace/key" -> raw value
+static std::map<nvs_handle_t, std::string> s_nvs_handles;
+static nvs_handle_t s_nvs_next = 1;
+static int s_nvs_writes = 0;
+static int s_nvs_commits = 0;
+
+void host_nvs_clear(void) {
+    s_nvs.clear();
+    s_nvs_writes = 0;
+    s_nvs_commits = 0;
+}
+
+int host_nvs_write_count(void) { return s_nvs_writes; }
+int host_nvs_commit_count(void) { return s_nvs_commits; }
+int host_nvs_key_count(void) { return (int)s_nvs.size(); }
+
+esp_err_t nvs_open(const char *ns, nvs_open_mode_t, nvs_handle_t *out) {
+    *out = s_nvs_next++;
+    s_nvs_handles[*out] = ns;
+    return ESP_OK;
+}
+
+void nvs_close(nvs_handle_t handle) { s_nvs_handles.erase(handle); }
+
+esp_err_t nvs_commit(nvs_handle_t) {
+    s_nvs_commits++;
+    return ESP_OK;
+}
+
+static std::string nvs_key(nvs_handle_t handle, const char *key) { return s_nvs_handles[handle] + "/" + key; }
+
+static esp_err_t nvs_set(nvs_handle_t handle, const char *key, const void *data, size_t len) {
+    s_nvs[nvs_key(handle, key)] = std::string((const char *)data, len);
+    s_nvs_writes++;
+    return ESP_OK;
+}
+
+static esp_err_t nvs_get(nvs_handle_t handle, const char *key, void *out, size_t len) {
+    auto it = s_nvs.find(nvs_key(handle, key));
+    if (it == s_nvs.end() || it->second.size() != len) return ESP_ERR_NVS_NOT_FOUND;
+    memcpy(out, it->second.data(), len);
+    return ESP_OK;
+}
+
+esp_err_t nvs_set_u8(nvs_handle_t h, const char *key, uint8_t v) { return nvs_set(h, key, &v, sizeof(v)); }
+esp_err_t nvs_get_u8(nvs_handle_t h, const char *key, uint8_t *out) { return nvs_get(h, key, out, sizeof(*out)); }
+esp_err_t nvs_set_u16(nvs_handle_t h, const char *key, uint16_t v) { return nvs_set(h, key, &v, sizeof(v)); }
+esp_err_t nvs_get_u16(nvs_handle_t h, const char *key, uint16_t *out) { return nvs_get(h, key, out, sizeof(*out)); }
+esp_err_t nvs_set_i32(nvs_handle_t h, const char *key, int32_t v) { return nvs_set(h, key, &v, sizeof(v)); }
+esp_err_t nvs_get_i32(nvs_handle_t h, const char *key, int32_t *out) { return nvs_get(h, key, out, sizeof(*out)); }
+esp_err_t nvs_set_str(nvs_handle_t h, const char *key, const char *v) { return nvs_set(h, key, v, strlen(v) + 1); }
+esp_err_t nvs_set_blob(nvs_handle_t h, const char *key, const void *v, size_t len) { return nvs_set(h, key, v, len); }
+
+// Variable-length values: out == NULL queries the length
+static esp_err_t nvs_get_var(nvs_handle_t h, const char *key, void *out, size_t *len, esp_err_t too_small) {
+    auto it = s_nvs.find(nvs_key(h, key));
+    if (it == s_nvs.end()) return ESP_ERR_NVS_NOT_FOUND;
+    if (out) {
+        if (*len < it->second.size()) return too_small;
+        memcpy(out, it->second.data(), it->second.size());
+    }
+    *len = it->second.size();
+    return ESP_OK;
+}
+
+esp_err_t nvs_get_str(nvs_handle_t h, const char *key, char *out, size_t *len) {
+    return nvs_get_var(h, key, out, len, ESP_ERR_INVALID_SIZE);
+}
+
+esp_err_t nvs_get_blob(nvs_handle_t h, const char *key, void *out, size_t *len) {
+    return nvs_get_var(h, key, out, len, ESP_ERR_NVS_INVALID_LENGTH);
+}
+
+esp_err_t nvs_erase_key(nvs_handle_t h, const char *key) {
+    return s_nvs.erase(nvs_key(h, key)) ? ESP_OK : ESP_ERR_NVS_NOT_FOUND;
+}
+
+// --- Semaphores ----------------------------------------------------------------
+
+struct HostSemaphore {
+    std::mutex mutex;
+    std::condition_variable cv;
+    int count;
+};
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void) { return new HostSemaphore{{}, {}, 1}; }
+SemaphoreHandle_t xSemaphoreCreateBinary(void) { return new HostSemaphore{{}, {}, 0}; }
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks) {
+    std::unique_lock<std::mutex> lock(sem->mutex);
+    auto ready = [sem] { return sem->count > 0; };
+    if (ticks == portMAX_DELAY) {
+        sem->cv.wait(lock, ready);
+    } else if (!sem->cv.wait_for(lock, std::chrono::milliseconds(ticks), ready)) {
+        return pdFALSE;
+    }
+    sem->count--;
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem) {
+    {
+        std::lock_guard<std::mutex> lock(sem->mutex);
+        if (sem->count > 0) return pdFALSE;
+        sem->count = 1;
+    }
+    sem->cv.notify_one();
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGiveFromISR(SemaphoreHandle_t sem, BaseType_t *woken) {
+    if (woken) *woken = pdFALSE;
+    return xSemaphoreGive(sem);
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t sem) { delete sem; }
@@ -0,0 +1,28 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+// In-memory NVS; host_nvs_clear() resets it between test cases
+typedef uint32_t nvs_handle_t;
+typedef enum { NVS_READONLY, NVS_READWRITE } nvs_open_mode_t;
+
+esp_err_t nvs_open(const char *ns, nvs_open_mode_t mode, nvs_handle_t *out);
+void nvs_close(nvs_handle_t handle);
+esp_err_t nvs_commit(nvs_handle_t handle);
+esp_err_t nvs_set_u8(nvs_handle_t handle, const char *key, uint8_t value);
+esp_err_t nvs_get_u8(nvs_handle_t handle, const char *key, uint8_t *out);
+esp_err_t nvs_set_u16(nvs_handle_t handle, const char *key, uint16_t value);
+esp_err_t nvs_get_u16(nvs_handle_t handle, const char *key, uint16_t *out);
+esp_err_t nvs_set_str(nvs_handle_t handle, const char *key, const char *value);
+esp_err_t nvs_get_str(nvs_handle_t handle, const char *key, char *out, size_t *len);
+esp_err_t nvs_set_i32(nvs_handle_t handle, const char *key, int32_t value);
+esp_err_t nvs_get_i32(nvs_handle_t handle, const char *key, int32_t *out);
+esp_err_t nvs_set_blob(nvs_handle_t handle, const char *key, const void *value, size_t len);
+esp_err_t nvs_get_blob(nvs_handle_t handle, const char *key, void *out, size_t *len);
+esp_err_t nvs_erase_key(nvs_handle_t handle, const char *key);
+
+void host_nvs_clear(void);
+int host_nvs_write_count(void); // Successful set calls since the last clear
+int host_nvs_commit_count(void); // nvs_commit calls since the last clear
+int host_nvs_key_count(void);    // Keys currently stored, all namespaces
@@ -0,0 +1,99 @@
+#pragma once
+// Host model of the ESP32 ROM tinfl API, backed by zlib raw inflate.
+//
+// The ROM carries miniz 1.x, whose tinfl reads ahead into its 32-bit bit
+// buffer and does not give unused whole bytes back when the DEFLATE stream
+// ends. The model reproduces that: on DONE it swallows up to
+// host_tinfl_lookahead bytes after the end of the stream and leaves them in
+// m_bit_buf/m_num_bits, below host_tinfl_junk_bits stray bits.
+// zlib allocates from an arena inside the decompressor, so freeing the
+// struct releases everything, as with the real one.
+#include <stddef.h>
+#include <stdint.h>
+#include <zlib.h>
+
+#define TINFL_LZ_DICT_SIZE 32768
+
+enum {
+    TINFL_FLAG_PARSE_ZLIB_HEADER = 1,
+    TINFL_FLAG_HAS_MORE_INPUT = 2,
+    TINFL_FLAG_USING_NON_WRAPPING_OUTPUT_BUF = 4,
+};
+
+typedef enum {
+    TINFL_STATUS_BAD_PARAM = -3,
+    TINFL_STATUS_ADLER32_MISMATCH = -2,
+    TINFL_STATUS_FAILED = -1,
+    TINFL_STATUS_DONE = 0,
+    TINFL_STATUS_NEEDS_MORE_INPUT = 1,
+    TINFL_STATUS_HAS_MORE_OUTPUT = 2,
+} tinfl_status;
+
+typedef uint8_t mz_uint8;
+typedef uint32_t mz_uint32;
+
+typedef struct {
+    mz_uint32 m_num_bits;
+    mz_uint32 m_bit_buf;
+    z_stream zs;
+    int inited;
+    size_t arena_used;
+    alignas(16) uint8_t arena[48 * 1024];
+} tinfl_decompressor;
+
+inline int host_tinfl_lookahead = 3;  // 0..3 whole bytes kept past the stream end
+inline int host_tinfl_junk_bits = 0;  // 0..7 bits below them
+
+#define tinfl_init(r) \
+    do { \
+        (r)->inited = 0; \
+        (r)->m_num_bits = 0; \
+        (r)->m_bit_buf = 0; \
+    } while (0)
+
+static inline voidpf host_tinfl_alloc(voidpf opaque, uInt items, uInt size) {
+    tinfl_decompressor *r = (tinfl_decompressor *)opaque;
+    size_t need = ((size_t)items * size + 15) & ~(size_t)15;
+    if (r->arena_used + need > sizeof(r->arena)) return Z_NULL;
+    voidpf p = r->arena + r->arena_used;
+    r->arena_used += need;
+    return p;
+}
+
+static inline void host_tinfl_free(voidpf, voidpf) {}
+
+static inline tinfl_status tinfl_decompress(tinfl_decompressor *r, const mz_uint8 *in, size_t *in_size,
+                                            mz_uint8 *start, mz_uint8 *next, size_t *out_size, mz_uint32 flags) {
+    (void)start;
+    (void)flags;
+    if (!r->inited) {
+        r->zs = z_stream();
+        r->zs.zalloc = host_tinfl_alloc;
+        r->zs.zfree = host_tinfl_free;
+        r->zs.opaque = r;
+        r->arena_used = 0;
+        if (inflateInit2(&r->zs, -15) != Z_OK) return TINFL_STATUS_FAILED;
+        r->inited = 1;
+    }
+    r->zs.next_in = (Bytef *)in;
+    r->zs.avail_in = (uInt)*in_size;
+    r->zs.next_out = next;
+    r->zs.avail_out = (uInt)*out_size;
+    int rc = inflate(&r->zs, Z_NO_FLUSH);
+    size_t used = *in_size - r->zs.avail_in;
+    *out_size -= r->zs.avail_out;
+    if (rc == Z_STREAM_END) {
+        r->inited = 0;
+        size_t take = r->zs.avail_in < (uInt)host_tinfl_lookahead ? r->zs.avail_in : (size_t)host_tinfl_lookahead;
+        uint32_t bytes = 0;
+        for (size_t i = 0; i < take; i++) bytes |= (uint32_t)in[used + i] << (8 * i);
+        r->m_bit_buf = (bytes << host_tinfl_junk_bits) | (0x5Au & ((1u << host_tinfl_junk_bits) - 1));
+        r->m_num_bits = (mz_uint32)(8 * take + host_tinfl_junk_bits);
+        *in_size = used + take;
+        return TINFL_STATUS_DONE;
+    }
+    *in_size = used;
+    if (rc != Z_OK && rc != Z_BUF_ERROR) return TINFL_STATUS_FAILED;
+    if (r->zs.avail_out == 0) return TINFL_STATUS_HAS_MORE_OUTPUT;
+    return TINFL_STATUS_NEEDS_MORE_INPUT;
+}
@@ -0,0 +1,175 @@
+// GzipInflater against zlib-made gzip files, fed in every piece size from 1
+// byte up, with the ROM tinfl look-ahead (see stubs/rom/miniz.h) at 0..3
+// bytes. Truncated files must never finish, a corrupt trailer must fail.
+#include <random>
+#include <vector>
+#include <string.h>
+#include <zlib.h>
+#include "OtaInflate.h"
+#include "host_test.h"
+
+typedef std::vector<uint8_t> Bytes;
+
+static Bytes make_payload(std::mt19937 &rng, size_t size, bool compressible) {
+    Bytes data(size);
+    for (size_t i = 0; i < size; ++i) {
+        data[i] = compressible ? (uint8_t)("firmware image "[i % 15] ^ ((rng() % 16) == 0 ? rng() : 0)) : (uint8_t)rng();
+    }
+    return data;
+}
+
+static Bytes gzip(const Bytes &data, int level, bool with_header_fields) {
+    z_stream zs = {};
+    deflateInit2(&zs, level, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY);
+    gz_header header = {};
+    static Bytef extra[] = {'D', 'C', 3, 0, 1, 2, 3};
+    static Bytef name[] = "dial-a-charmer.bin";
+    static Bytef comment[] = "host test";
+    if (with_header_fields) {
+        header.extra = extra;
+        header.extra_len = sizeof(extra);
+        header.name = name;
+        header.comment = comment;
+        header.hcrc = 1;
+        deflateSetHeader(&zs, &header);
+    }
+    Bytes out(deflateBound(&zs, data.size()) + 256);
+    zs.next_in = (Bytef *)data.data();
+    zs.avail_in = (uInt)data.size();
+    zs.next_out = out.data();
+    zs.avail_out = (uInt)out.size();
+    deflate(&zs, Z_FINISH);
+    out.resize(zs.total_out);
+    deflateEnd(&zs);
+    return out;
+}
+
+static esp_err_t collect(void *ctx, const uint8_t *data, size_t len) {
+    Bytes *out = static_cast<Bytes *>(ctx);
+    out->insert(out->end(), data, data + len);
+    return ESP_OK;
+}
+
+struct Result {
+    esp_err_t feed;
+    esp_err_t finish;
+    Bytes out;
+};
+
+static Result inflate_in_pieces(const Bytes &gz, size_t piece) {
+    Result r = {ESP_OK, ESP_OK, {}};
+    GzipInflater inflater;
+    if (inflater.begin(collect, &r.out) != ESP_OK) {
+        r.feed = ESP_ERR_NO_MEM;
+        return r;
+    }
+    for (size_t pos = 0; pos < gz.size() && r.feed == ESP_OK; pos += piece) {
+        r.feed = inflater.feed(gz.data() + pos, std::min(piece, gz.size() - pos));
+    }
+    r.finish = inflater.finish();
+    return r;
+}
+
+static void test_round_trip(std::mt19937 &rng) {
+    const size_t sizes[] = {0, 1, 7, 300, 4096, 70000};
+    for (size_t size : sizes) {
+        for (int variant = 0; variant < 4; ++variant) {
+            Bytes data = make_payload(rng, size, variant & 1);
+            Bytes gz = gzip(data, (variant & 1) ? 9 : 1, variant & 2);
+            for (int lookahead = 0; lookahead <= 3; ++lookahead) {
+                host_tinfl_lookahead = lookahead;
+                host_tinfl_junk_bits = (lookahead * 3 + variant) & 7;
+                size_t max_piece = size < 1000 ? gz.size() + 1 : 40;
+                for (size_t piece = 1; piece <= max_piece; ++piece) {
+                    Result r = inflate_in_pieces(gz, piece);
+                    CHECK_EQ(r.feed, ESP_OK);
+                    CHECK_EQ(r.finish, ESP_OK);
+                    CHECK(r.out == data);
+                    if (r.feed != ESP_OK || r.finish != ESP_OK) {
+                        fprintf(stderr, "  size=%zu variant=%d lookahead=%d piece=%zu\n", size, variant, lookahead, piece);
+                        return;
+                    }
+                }
+                Result whole = inflate_in_pieces(gz, gz.size());
+                CHECK_EQ(whole.finish, ESP_OK);
+            }
+        }
+    }
+}
+
+static void test_truncated(std::mt19937 &rng) {
+    Bytes data = make_payload(rng, 5000, true);
+    Bytes gz = gzip(data, 6, false);
+    for (int lookahead = 0; lookahead <= 3; ++lookahead) {
+        host_tinfl_lookahead = lookahead;
+        for (size_t cut = 1; cut <= 12; ++cut) {
+            Bytes part(gz.begin(), gz.end() - cut);
+            for (size_t piece : {(size_t)1, (size_t)3, (size_t)64, part.size()}) {
+                Result r = inflate_in_pieces(part, piece);
+                CHECK_EQ(r.feed, ESP_OK);
+                CHECK_EQ(r.finish, ESP_ERR_INVALID_SIZE);
+            }
+        }
+    }
+}
+
+static void test_corrupt_trailer(std::mt19937 &rng) {
+    Bytes data = make_payload(rng, 3000, false);
+    Bytes gz = gzip(data, 6, false);
+    for (int lookahead = 0; lookahead <= 3; ++lookahead) {
+        host_tinfl_lookahead = lookahead;
+        for (size_t i = 1; i <= 8; ++i) {
+            Bytes bad = gz;
+            bad[bad.size() - i] ^= 0x10;
+            for (size_t piece : {(size_t)1, (size_t)5, bad.size()}) {
+                Result r = inflate_in_pieces(bad, piece);
+                CHECK_EQ(r.feed, ESP_ERR_INVALID_CRC);
+                CHECK(r.finish != ESP_OK);
+            }
+        }
+    }
+}
+
+static void test_trailing_padding(std::mt19937 &rng) {
+    Bytes data = make_payload(rng, 2000, true);
+    Bytes gz = gzip(data, 6, false);
+    gz.insert(gz.end(), 16, 0); // e.g. block-aligned upload
+    for (int lookahead = 0; lookahead <= 3; ++lookahead) {
+        host_tinfl_lookahead = lookahead;
+        Result r = inflate_in_pieces(gz, 7);
+        CHECK_EQ(r.finish, ESP_OK);
+        CHECK(r.out == data);
+    }
+}
+
+static void test_not_gzip() {
+    Bytes raw = {0xE9, 0x03, 0x02, 0x20, 0x00, 0x00, 0x00, 0x00};
+    CHECK(!GzipInflater::isGzip(raw.data(), raw.size()));
+    Result r = inflate_in_pieces(raw, raw.size());
+    CHECK_EQ(r.feed, ESP_ERR_INVALID_ARG);
+}
+
+static void test_corrupt_data(std::mt19937 &rng) {
+    Bytes data = make_payload(rng, 20000, true);
+    Bytes gz = gzip(data, 6, false);
+    int rejected = 0;
+    for (int i = 0; i < 50; ++i) {
+        Bytes bad = gz;
+        bad[10 + rng() % (bad.size() - 18)] ^= (uint8_t)(1u << (rng() % 8));
+        Result r = inflate_in_pieces(bad, 1 + rng() % 100);
+        CHECK(r.finish != ESP_OK || r.out == data);
+        if (r.finish != ESP_OK) rejected++;
+    }
+    CHECK(rejected > 0);
+}
+
+int main() {
+    std::mt19937 rng(4711);
+    test_round_trip(rng);
+    test_truncated(rng);
+    test_corrupt_trailer(rng);
+    test_trailing_padding(rng);
+    test_not_gzip();
+    test_corrupt_data(rng);
+    return host_test_result("test_ota_inflate");
+}
@@ -0,0 +1,59 @@
+// The web server replaces the phonebook (saveFromJson) while the main task
+// looks numbers up and dispatches them. Run under ASan: an entry handed out
+// by find() must stay valid until the caller drops it.
+#include <atomic>
+#include <string>
+#include <thread>
+#include "PhonebookManager.h"
+#include "host_test.h"
+
+static std::atomic<int> s_dispatched{0};
+
+static void action_count(const PhonebookEntry &entry) {
+    if (entry.value.size() == 4) s_dispatched++;
+}
+
+int main() {
+    phonebook.registerAction("TTS", action_count);
+    phonebook.begin();
+
+    std::atomic<bool> stop{false};
+    std::thread writer([&] {
+        for (int round = 0; round < 300; ++round) {
+            std::string json = "{";
+            for (int i = 0; i < 40; ++i) {
+                if (i) json += ",";
+                json += "\"" + std::to_string(700 + i) + "\":{\"name\":\"N" + std::to_string(round) +
+                        "\",\"type\":\"TTS\",\"value\":\"v" + std::to_string(100 + round % 900) + "\"}";
+            }
+            json += "}";
+            CHECK(phonebook.saveFromJson(json.c_str()));
+            if (round % 10 == 0) phonebook.addEntry("799", "Extra", "TTS", "vxyz");
+        }
+        stop = true;
+    });
+
+    int lookups = 0;
+    int found = 0;
+    while (!stop) {
+        PhonebookEntryRef entry = phonebook.find("712");
+        lookups++;
+        if (entry) {
+            found++;
+            std::this_thread::yield(); // Give the writer a chance to swap the table
+            CHECK(entry->type == "TTS");
+            CHECK(entry->value.size() == 4 && entry->value[0] == 'v');
+            CHECK(entry->name[0] == 'N');
+            CHECK(phonebook.dispatch(*entry));
+        }
+        PhonebookMatch match = phonebook.matchPrefix("71");
+        CHECK(match == PhonebookMatch::Partial || match == PhonebookMatch::None);
+    }
+    writer.join();
+
+    CHECK(found > 0);
+    CHECK_EQ(s_dispatched.load(), found);
+    CHECK(phonebook.matchPrefix("712") == PhonebookMatch::Unique);
+    printf("%d lookups, %d found while replacing\n", lookups, found);
+    return host_test_result("test_phonebook_concurrency");
+}
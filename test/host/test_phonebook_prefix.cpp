@@ -0,0 +1,76 @@
+// matchPrefix() decides when the main task may dispatch a number before the
+// dial timeout; these cases pin down the overlap handling.
+#include "PhonebookManager.h"
+#include "StateVersion.h"
+#include "host_test.h"
+
+static void test_default_numbers() {
+    // Defaults: "0", "1".."5", "8", "11" and "110"
+    CHECK(phonebook.matchPrefix("1") == PhonebookMatch::Ambiguous);  // "11" and "110" extend it
+    CHECK(phonebook.matchPrefix("11") == PhonebookMatch::Ambiguous); // "110" extends it
+    CHECK(phonebook.matchPrefix("110") == PhonebookMatch::Unique);
+    CHECK(phonebook.matchPrefix("5") == PhonebookMatch::Unique);
+    CHECK(phonebook.matchPrefix("0") == PhonebookMatch::Unique);
+    CHECK(phonebook.matchPrefix("9") == PhonebookMatch::None);
+    CHECK(phonebook.matchPrefix("12") == PhonebookMatch::None);
+    CHECK(phonebook.matchPrefix("1100") == PhonebookMatch::None);
+    CHECK(phonebook.matchPrefix("") == PhonebookMatch::None);
+    CHECK(phonebook.matchPrefix("1a") == PhonebookMatch::None);
+}
+
+static void test_partial_and_non_digit_numbers() {
+    phonebook.addEntry("4711", "Cologne", "TTS", "Hallo");
+    phonebook.addEntry("*9", "Star", "TTS", "Stern");
+    CHECK(phonebook.matchPrefix("47") == PhonebookMatch::Partial);
+    CHECK(phonebook.matchPrefix("471") == PhonebookMatch::Partial);
+    CHECK(phonebook.matchPrefix("4711") == PhonebookMatch::Unique);
+    CHECK(phonebook.matchPrefix("4") == PhonebookMatch::Ambiguous); // "4" itself is a persona
+    CHECK(phonebook.matchPrefix("*9") == PhonebookMatch::None);     // Not dialable, but ...
+    CHECK(phonebook.hasEntry("*9"));                                // ... still found after the timeout
+}
+
+static void test_unique_after_remove() {
+    phonebook.removeEntry("110");
+    CHECK(phonebook.matchPrefix("11") == PhonebookMatch::Unique);
+    CHECK(phonebook.matchPrefix("1") == PhonebookMatch::Ambiguous);
+    CHECK(phonebook.matchPrefix("110") == PhonebookMatch::None);
+
+    phonebook.removeEntry("11");
+    CHECK(phonebook.matchPrefix("1") == PhonebookMatch::Unique);
+
+    phonebook.removeEntry("4711");
+    CHECK(phonebook.matchPrefix("4") == PhonebookMatch::Unique);
+    CHECK(phonebook.matchPrefix("47") == PhonebookMatch::None);
+}
+
+static void test_replace_from_json() {
+    CHECK(phonebook.saveFromJson(R"({"7":{"name":"A","type":"TTS","value":"x"},)"
+                                 R"("77":{"name":"B","type":"TTS","value":"y"}})"));
+    CHECK(phonebook.matchPrefix("7") == PhonebookMatch::Ambiguous);
+    CHECK(phonebook.matchPrefix("77") == PhonebookMatch::Unique);
+    CHECK(phonebook.matchPrefix("1") == PhonebookMatch::None); // Old entries are gone
+    CHECK(!phonebook.saveFromJson("{broken"));
+    CHECK(phonebook.matchPrefix("77") == PhonebookMatch::Unique); // Invalid JSON keeps the table
+}
+
+// The host has no SD card, so save() fails: the /api/state version must
+// still follow the table that lookups (and GET /api/phonebook) see.
+static void test_state_version_follows_table() {
+    uint32_t before = state_version::snapshot().section[STATE_PHONEBOOK];
+    CHECK(phonebook.saveFromJson(R"({"9":{"name":"C","type":"TTS","value":"z"}})"));
+    uint32_t after = state_version::snapshot().section[STATE_PHONEBOOK];
+    CHECK(after != before);
+    CHECK(!phonebook.saveFromJson("{broken"));
+    CHECK_EQ(state_version::snapshot().section[STATE_PHONEBOOK], after);
+}
+
+int main() {
+    state_version::init();
+    phonebook.begin(); // No SD card on the host: starts from the built-in defaults
+    test_default_numbers();
+    test_partial_and_non_digit_numbers();
+    test_unique_after_remove();
+    test_replace_from_json();
+    test_state_version_follows_table();
+    return host_test_result("test_phonebook_prefix");
+}
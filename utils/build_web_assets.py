@@ -0,0 +1,90 @@
+#!/usr/bin/env python3
+"""Pre-compress the embedded web UI for the firmware.
+
+Writes main/include/web_assets_gz.h with a gzip copy of every web asset plus
+the CRC32 of the source it was built from. WebManager serves the gzip copy to
+clients that accept it, but only while that CRC still matches the embedded
+original, so a stale header falls back to the uncompressed file.
+
+Run before `idf.py build` whenever main/web_ui changes:
+
+    python utils/build_web_assets.py
+"""
+
+import gzip
+import sys
+import zlib
+from pathlib import Path
+
+PROJECT_ROOT = Path(__file__).resolve().parent.parent
+WEB_UI_DIR = PROJECT_ROOT / "main" / "web_ui"
+OUTPUT = PROJECT_ROOT / "main" / "include" / "web_assets_gz.h"
+
+# Same names as the EMBED_FILES/EMBED_TXTFILES entries WebManager serves
+ASSETS = [
+    "index.html",
+    "style.css",
+    "app.js",
+    "fonts/3620-plaisir-app.otf",
+    "fonts/AATriple.otf",
+]
+
+
+def c_ident(name):
+    return "web_gz_" + "".join(ch if ch.isalnum() else "_" for ch in name)
+
+
+def c_bytes(data):
+    lines = []
+    for i in range(0, len(data), 16):
+        lines.append("    " + ", ".join(f"0x{b:02x}" for b in data[i:i + 16]) + ",")
+    return "\n".join(lines)
+
+
+def main():
+    arrays = []
+    table = []
+    total_raw = 0
+    total_gz = 0
+
+    for name in ASSETS:
+        path = WEB_UI_DIR / name
+        if not path.exists():
+            print(f"  [SKIP] {name} (not found)")
+            continue
+        raw = path.read_bytes()
+        packed = gzip.compress(raw, compresslevel=9, mtime=0)
+        if len(packed) >= len(raw):
+            print(f"  [SKIP] {name} (gzip not smaller)")
+            continue
+
+        ident = c_ident(Path(name).name)
+        crc = zlib.crc32(raw) & 0xFFFFFFFF
+        arrays.append(f"static const uint8_t {ident}[] = {{\n{c_bytes(packed)}\n}};\n")
+        table.append(f'    {{"{Path(name).name}", 0x{crc:08x}u, {len(raw)}u, {ident}, sizeof({ident})}},')
+        total_raw += len(raw)
+        total_gz += len(packed)
+        print(f"  [OK] {name}: {len(raw)} -> {len(packed)} bytes ({100 * len(packed) // len(raw)}%)")
+
+    with OUTPUT.open("w", encoding="utf-8", newline="\n") as out:
+        out.write("// Generated by utils/build_web_assets.py - do not edit.\n")
+        out.write("#pragma once\n#include <stddef.h>\n#include <stdint.h>\n\n")
+        out.write("struct WebAssetGz {\n")
+        out.write("    const char *name;  // File name without directory\n")
+        out.write("    uint32_t src_crc;  // CRC32 of the uncompressed source\n")
+        out.write("    uint32_t src_len;\n")
+        out.write("    const uint8_t *data;\n")
+        out.write("    size_t len;\n")
+        out.write("};\n\n")
+        out.write("\n".join(arrays))
+        out.write("\nstatic const WebAssetGz web_assets_gz[] = {\n")
+        out.write("".join(line + "\n" for line in table))
+        out.write("    {nullptr, 0, 0, nullptr, 0},\n")
+        out.write("};\n")
+
+    print(f"Wrote {OUTPUT.relative_to(PROJECT_ROOT)}: {total_raw} -> {total_gz} bytes")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())